@@ -5,14 +5,46 @@
 #include <string>
 #include <filesystem>
 #include <thread>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <cstring>
+
+#include "LocalSocket.h"
+#include "RenderProtocol.h"
+#include "SharedFrame.h"
+#include "Palette.h"
+#include "BigFloat.h"
+#include "FractalEngine.h"
 
 
 void AskUserNbProcessMpi();
+void StartRenderServer();
+void StopRenderServer();
 void CalculateMandelbrot(double, double, double, double);
+void RequestMandelbrot();
+void SaveView();
+void MoveView(int, int);
+void ShowPreviousView();
+void RestoreDisplayedView();
+void ChangeFractal(FractalType, int);
+void ToggleColorMode();
+void ReceiveRenderReplies();
+void HandleRenderReplies();
+void RecolorMandelbrot(PaletteType);
+void SendRecolor();
 void InitializeForm(int, int);
 int WindowLoop();
 const int GreatestCommonDivisor(int, int);
-void SetMandelbrotImage();
+bool SetMandelbrotImage();
+SDL_Rect ClipToWindow(int, int, int, int);
+void DrawSelection(int, int, int, int);
+void EraseSelection();
+void PresentWindow();
 int getScreenWidth();
 int getScreenHeight();
 
@@ -26,6 +58,16 @@ SDL_Surface* window;
 /// </summary>
 SDL_Surface* image;
 
+/// <summary>
+/// Parts of the window changed since they were last displayed
+/// </summary>
+std::vector<SDL_Rect> dirtyRects;
+
+/// <summary>
+/// Borders of the rectangle to zoom in drawn over the image, the image is copied back under them to erase it
+/// </summary>
+std::vector<SDL_Rect> selectionBorders;
+
 /// <summary>
 /// Ratio size of the image.
 /// Here 80% of the screen size.
@@ -48,7 +90,18 @@ int pixelHeight = (int)(getScreenHeight() * ratioImage);
 bool rectangleAvailable = false;
 
 /// <summary>
-/// X coord of P1 in the axe
+/// Real part of the center of the image at full precision, the coords of P1 and P2 are relative to it
+/// so they keep their precision however deep the zoom is
+/// </summary>
+BigFloat centerX;
+
+/// <summary>
+/// Imaginary part of the center of the image at full precision
+/// </summary>
+BigFloat centerY;
+
+/// <summary>
+/// X coord of P1 in the axe, relative to centerX
 /// </summary>
 double P1XinAxe = -2.0;
 
@@ -73,6 +126,135 @@ double P2YinAxe = P2XinAxe * pixelHeight / pixelWidth;
 /// </summary>
 int nbProcessMpi = 1;
 
+/// <summary>
+/// Number of iterations after which a pixel is considered as not diverging, raised with the zoom
+/// </summary>
+int maxIteration = 1000;
+
+/// <summary>
+/// Number of iterations added to maxIteration each time the zoom doubles
+/// </summary>
+constexpr int iterationsPerZoomLevel = 200;
+
+/// <summary>
+/// Palette used to color the Mandelbrot image, changed with the keys 1 to 4
+/// </summary>
+PaletteType palette = PALETTE_SQRT;
+
+/// <summary>
+/// Range and iterations of a displayed image, to display it again
+/// </summary>
+typedef struct view {
+	BigFloat centerX;
+	BigFloat centerY;
+	double P1XinAxe;
+	double P1YinAxe;
+	double P2XinAxe;
+	double P2YinAxe;
+	int maxIteration;
+	fractalParameters fractal;
+} view;
+
+view GetCurrentView();
+
+/// <summary>
+/// Fractal drawn in the image, changed with the keys F1 to F5
+/// </summary>
+fractalParameters fractal = { FRACTAL_MANDELBROT, 2, COLOR_SMOOTH, 0, 0 };
+
+/// <summary>
+/// Images displayed before the current one, the last one is displayed again with Backspace
+/// </summary>
+std::vector<view> previousViews;
+
+/// <summary>
+/// Memory of the tile cache of the render server in MB, going back to a previous view or moving the image
+/// only calculates the tiles which aren't in the cache
+/// </summary>
+constexpr int renderCacheSize = 256;
+
+/// <summary>
+/// Passes of the progressive rendering asked to the render server : 1/16 of the pixels, then 1/4, then all of them
+/// </summary>
+constexpr int progressivePasses = 3;
+
+/// <summary>
+/// Connection to FractalPlusPlusMPI running as a render server
+/// </summary>
+socketHandle renderServer = invalidSocket;
+
+/// <summary>
+/// Request sent to the render server whose last reply hasn't been handled yet
+/// </summary>
+typedef struct sentRequest {
+	RenderCommand command;
+	PaletteType palette; // Palette of the frame once the request is done
+	view requestedView; // View calculated by a render, displayed once it is done
+	std::vector<view> history; // Previous views when the render was asked
+} sentRequest;
+
+/// <summary>
+/// Requests sent to the render server and not answered yet, oldest first, the server answering them in order.
+/// Only used by the main thread.
+/// </summary>
+std::deque<sentRequest> pendingRequests;
+
+/// <summary>
+/// Last render displayed in full with the previous views at that time, Escape comes back to it
+/// whatever the renders asked since then changed (zoom, move, Backspace or fractal)
+/// </summary>
+sentRequest displayedRender;
+
+/// <summary>
+/// True once a render has been displayed in full
+/// </summary>
+bool renderDisplayed = false;
+
+/// <summary>
+/// True when the last frame couldn't be copied out of the shared memory, it's copied again with the next reply or event
+/// </summary>
+bool imageOutdated = false;
+
+/// <summary>
+/// Thread waiting for the replies of the render server, so the window stays responsive while a frame is calculated
+/// </summary>
+std::thread replyThread;
+
+/// <summary>
+/// Thread running the command of the render server, system returning once the server ends
+/// </summary>
+std::thread serverThread;
+
+/// <summary>
+/// Whether the command of the render server ended, set by serverThread
+/// </summary>
+std::atomic<bool> serverExited(false);
+
+/// <summary>
+/// Status returned by system for the command of the render server, once serverExited is true
+/// </summary>
+std::atomic<int> serverExitStatus(0);
+
+/// <summary>
+/// Protects receivedReplies and replyThreadStopped, shared by the reply thread and the main thread
+/// </summary>
+std::mutex replyMutex;
+
+/// <summary>
+/// Replies received by the reply thread and not handled yet by the main thread
+/// </summary>
+std::vector<renderReply> receivedReplies;
+
+/// <summary>
+/// Whether the connection to the render server is closed, the reply thread has then ended
+/// </summary>
+bool replyThreadStopped = false;
+
+/// <summary>
+/// Shared memory where the render server writes the frames, if it could be created
+/// </summary>
+SharedFrame sharedFrame;
+
 /// <summary>
 /// Main method of the program
 /// </summary>
@@ -80,9 +262,11 @@ int nbProcessMpi = 1;
 int main()
 {
 	AskUserNbProcessMpi();
+	StartRenderServer();
 	InitializeForm(pixelWidth, pixelHeight);
 	CalculateMandelbrot(0, 0, pixelWidth, pixelHeight); // Calculate a Mandelbrot image before entering the SDL window loop
 	WindowLoop();
+	StopRenderServer();
 	return 0;
 }
 
@@ -103,6 +287,92 @@ void AskUserNbProcessMpi() {
 	} while (nbProcessMpi < 1);
 }
 
+/// <summary>
+/// Start FractalPlusPlusMPI in the background as a render server and connect to it.
+/// The MPI processes stay alive until the GUI quits, so a zoom doesn't pay for their startup.
+/// The command runs on serverThread, so the GUI stops waiting as soon as the server ends without listening.
+/// </summary>
+void StartRenderServer() {
+	if (!InitializeSockets()) {
+		throw std::runtime_error("Unable to initialize the sockets");
+	}
+	int port = FindFreeLocalPort();
+	if (port == 0) {
+		throw std::runtime_error("Unable to find a free port for the render server");
+	}
+
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32) && !defined(__CYGWIN__)
+	constexpr char FPPExeName[] = "FractalPlusPlusMPI.exe";
+#else
+	constexpr char FPPExeName[] = "./FractalPlusPlusMPI"; // In linux we need to prepend "./" when it's in the current directory
+#endif
+	constexpr char MPIExeName[] = "mpiexec";
+	std::string commandeString;
+
+	// Get the frames through shared memory, without going through a BMP file, when it's available
+	std::string serverOptions = " --server " + std::to_string(port) + " --cache-size " + std::to_string(renderCacheSize);
+	if (sharedFrame.Create(SharedFrame::UniqueName(), pixelWidth, pixelHeight)) {
+		serverOptions += " --shared-frame " + sharedFrame.GetName();
+	}
+	else {
+		std::cout << "Unable to create the shared memory, the frames will be read from a BMP file" << std::endl;
+	}
+
+	if (nbProcessMpi == 1)
+	{
+		// Store the command in the commandeString variable
+		commandeString = std::string(FPPExeName) + serverOptions;
+	}
+	else
+	{
+		// Store the command in the commandeString variable
+		commandeString = std::string(MPIExeName) + " -n " + std::to_string(nbProcessMpi) + ' ' + std::string(FPPExeName) + serverOptions;
+	}
+
+	std::cout.flush(); // Flush the terminal buffer before calling the system method to avoid mixing the output of the two programs
+	serverExited = false;
+	serverThread = std::thread([commandeString]() {
+		serverExitStatus = system(commandeString.c_str());
+		serverExited = true;
+	});
+
+	// Wait for the server to listen, starting the MPI processes can take a few seconds
+	for (int attempt = 0; attempt < 300 && renderServer == invalidSocket && !serverExited; attempt++) {
+		renderServer = ConnectLocal(port);
+		if (renderServer == invalidSocket) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		}
+	}
+	if (renderServer == invalidSocket) {
+		if (serverExited) {
+			serverThread.join();
+			throw std::runtime_error("The render server stopped without listening on port " + std::to_string(port)
+				+ " (status " + std::to_string(serverExitStatus) + "), see its output above");
+		}
+		serverThread.detach(); // Still starting after 30 s, it is left running
+		throw std::runtime_error("Unable to connect to the render server on port " + std::to_string(port));
+	}
+	replyThread = std::thread(ReceiveRenderReplies);
+}
+
+/// <summary>
+/// Ask the render server to stop, cancelling the frame being calculated, and close the connection
+/// </summary>
+void StopRenderServer() {
+	renderRequest request = {};
+	request.command = COMMAND_QUIT;
+	SendAll(renderServer, &request, sizeof(request));
+	replyThread.join(); // Ends when the server closes the connection
+	CloseSocket(renderServer);
+	serverThread.join(); // Ends when every MPI process has stopped
+	renderServer = invalidSocket;
+
+	// The image is only displayed while the server runs
+	SDL_FreeSurface(image);
+	image = nullptr;
+	sharedFrame.Close();
+}
+
 /// <summary>
 /// This method initialize the form where the user is able to see and zoom in the Mandelbrot image
 /// </summary>
@@ -116,8 +386,8 @@ void InitializeForm(int pixelWidth, int pixelHeight) {
 	
 	// Make sure SDL cleans up before exit
 	atexit(SDL_Quit);
-	// Create a new window
-	window = SDL_SetVideoMode(pixelWidth, pixelHeight, 0, SDL_HWSURFACE | SDL_DOUBLEBUF);
+	// Create a new window, in software so only the changed parts of the window are copied to the screen with SDL_UpdateRects
+	window = SDL_SetVideoMode(pixelWidth, pixelHeight, 0, SDL_SWSURFACE);
 	if (!window) {
 		throw std::runtime_error("Unable to set " + std::to_string(pixelWidth) + "x" + std::to_string(pixelHeight) + " video: " + SDL_GetError());
 	}
@@ -127,7 +397,7 @@ void InitializeForm(int pixelWidth, int pixelHeight) {
 }
 
 /// <summary>
-/// Call the MPI program to calculate Mandelbrot with all the parameters
+/// Ask the render server to calculate Mandelbrot with all the parameters
 /// </summary>
 /// <param name="P1x">Optional parameter which is the x coordinate of the top left point after selecting an area to zoom in</param>
 /// <param name="P1y">Optional parameter which is the y coordinate of the top left point after selecting an area to zoom in</param>
@@ -138,11 +408,11 @@ void CalculateMandelbrot(double P1x = 0, double P1y = 0, double P2x = 0, double
 	double rangeX = abs(P2XinAxe - P1XinAxe);
 	double rangeY = abs(P2YinAxe - P1YinAxe);
 
-	// Calculate the new range
-	double localP1XinAxe = P1x / pixelWidth * rangeX - rangeX / 2;
-	double localP1YinAxe = P1y / pixelHeight * rangeY - rangeY / 2;
-	double localP2XinAxe = P2x / pixelWidth * rangeX - rangeX / 2;
-	double localP2YinAxe = P2y / pixelHeight * rangeY - rangeY / 2;
+	// Calculate the new range, relative to the previous center
+	double localP1XinAxe = P1XinAxe + P1x / pixelWidth * rangeX;
+	double localP1YinAxe = P1YinAxe + P1y / pixelHeight * rangeY;
+	double localP2XinAxe = P1XinAxe + P2x / pixelWidth * rangeX;
+	double localP2YinAxe = P1YinAxe + P2y / pixelHeight * rangeY;
 
 	// Reorder the points in case the user selected the area from bottom to top and/or from right to left
 	if (localP1XinAxe < localP2XinAxe)
@@ -166,42 +436,271 @@ void CalculateMandelbrot(double P1x = 0, double P1y = 0, double P2x = 0, double
 		P2YinAxe = localP1YinAxe;
 	}
 
+	// Move the center to the middle of the new range, with enough precision to tell its pixels apart
+	int fractionLimbs = BigFloat::FractionLimbsFor(std::min((P2XinAxe - P1XinAxe) / pixelWidth, (P2YinAxe - P1YinAxe) / pixelHeight));
+	double halfX = (P2XinAxe - P1XinAxe) / 2;
+	double halfY = (P2YinAxe - P1YinAxe) / 2;
+	centerX = centerX + BigFloat(P1XinAxe + halfX, fractionLimbs);
+	centerY = centerY + BigFloat(P1YinAxe + halfY, fractionLimbs);
+	P1XinAxe = -halfX;
+	P2XinAxe = halfX;
+	P1YinAxe = -halfY;
+	P2YinAxe = halfY;
+	maxIteration = std::max(1000, (int)(iterationsPerZoomLevel * log2(4 / (P2XinAxe - P1XinAxe))));
+
+	RequestMandelbrot();
+}
+
+/// <summary>
+/// Ask the render server to calculate the Mandelbrot image of the current center and range.
+/// The server cancels the frame it is calculating, if any, so only the last view asked is calculated in full.
+/// </summary>
+void RequestMandelbrot() {
+	// About 0.3 decimal digit per bit, with enough precision to tell the pixels apart
+	int fractionLimbs = BigFloat::FractionLimbsFor(std::min((P2XinAxe - P1XinAxe) / pixelWidth, (P2YinAxe - P1YinAxe) / pixelHeight));
+	std::string center = centerX.ToString((int)(fractionLimbs * 32 * 0.30103) + 2) + " " + centerY.ToString((int)(fractionLimbs * 32 * 0.30103) + 2);
+
 	// Display the new range
 	std::cout << "----------------------------------------------" << std::endl;
-	std::cout << "Range of the Mandelbrot set :" << std::endl;
-	std::cout << "rangeX = " << P2XinAxe - P1XinAxe << ", rangeY = " << P2YinAxe - P1YinAxe << std::endl;
+	std::cout << "Range of the " << GetFractalName(fractal.type) << " of power " << fractal.power << " :" << std::endl;
+	std::cout << "center = " << center << std::endl;
+	std::cout << "rangeX = " << P2XinAxe - P1XinAxe << ", rangeY = " << P2YinAxe - P1YinAxe << ", maxIteration = " << maxIteration << std::endl;
 	std::cout << "--------------------------------------------------" << std::endl;
 
-	// Execute the MPI program to generate the Mandelbrot image
+	// Ask the render server to generate the Mandelbrot image, the center is sent after the request with all its decimals.
+	// The passes are displayed by WindowLoop as they arrive, a new area can be selected once the first one is displayed.
+	renderRequest request = { COMMAND_RENDER, pixelWidth, pixelHeight, maxIteration, palette, (uint32_t)center.size(), progressivePasses, fractal.type,
+		P1XinAxe, P2XinAxe, P1YinAxe, P2YinAxe, fractal.power, fractal.colorMode, fractal.juliaReal, fractal.juliaImag };
+	if (!SendAll(renderServer, &request, sizeof(request)) || !SendAll(renderServer, center.data(), center.size())) {
+		throw std::runtime_error("The render server stopped");
+	}
+	pendingRequests.push_back({ COMMAND_RENDER, palette, GetCurrentView(), previousViews });
+	rectangleAvailable = false;
+}
+
+/// <summary>
+/// Get the view of the last render asked
+/// </summary>
+/// <returns>center, range, iterations and fractal of the image</returns>
+view GetCurrentView() {
+	return { centerX, centerY, P1XinAxe, P1YinAxe, P2XinAxe, P2YinAxe, maxIteration, fractal };
+}
 
-#if defined(WIN32) || defined(_WIN32) || defined(__WIN32) && !defined(__CYGWIN__)
-	constexpr char FPPExeName[] = "FractalPlusPlusMPI.exe";
-#else
-	constexpr char FPPExeName[] = "./FractalPlusPlusMPI"; // In linux we need to prepend "./" when it's in the current directory
-#endif
-	constexpr char MPIExeName[] = "mpiexec";
-	std::string commandeString;
+/// <summary>
+/// Keep the current view to come back to it with Backspace
+/// </summary>
+void SaveView() {
+	previousViews.push_back(GetCurrentView());
+}
 
-	if (nbProcessMpi == 1)
+/// <summary>
+/// Move the image by a whole number of pixels, so the render server finds in its cache the tiles still visible
+/// </summary>
+/// <param name="columns">pixels to move to the right, negative to move to the left</param>
+/// <param name="rows">pixels to move to the bottom, negative to move to the top</param>
+void MoveView(int columns, int rows) {
+	SaveView();
+
+	int fractionLimbs = BigFloat::FractionLimbsFor(std::min((P2XinAxe - P1XinAxe) / pixelWidth, (P2YinAxe - P1YinAxe) / pixelHeight));
+	centerX = centerX + BigFloat(columns * (P2XinAxe - P1XinAxe) / pixelWidth, fractionLimbs);
+	centerY = centerY + BigFloat(rows * (P2YinAxe - P1YinAxe) / pixelHeight, fractionLimbs);
+	RequestMandelbrot();
+}
+
+/// <summary>
+/// Display again the view before the last zoom or move, its tiles are usually still in the cache of the render server
+/// </summary>
+void ShowPreviousView() {
+	view previous = previousViews.back();
+	previousViews.pop_back();
+	centerX = previous.centerX;
+	centerY = previous.centerY;
+	P1XinAxe = previous.P1XinAxe;
+	P1YinAxe = previous.P1YinAxe;
+	P2XinAxe = previous.P2XinAxe;
+	P2YinAxe = previous.P2YinAxe;
+	maxIteration = previous.maxIteration;
+	fractal = previous.fractal;
+	RequestMandelbrot();
+}
+
+/// <summary>
+/// Abort the renders being calculated and come back to the last image displayed in full, with its previous views,
+/// so Escape doesn't lose a view of the history even if the render aborted was itself a Backspace
+/// </summary>
+void RestoreDisplayedView() {
+	const view& displayed = displayedRender.requestedView;
+	centerX = displayed.centerX;
+	centerY = displayed.centerY;
+	P1XinAxe = displayed.P1XinAxe;
+	P1YinAxe = displayed.P1YinAxe;
+	P2XinAxe = displayed.P2XinAxe;
+	P2YinAxe = displayed.P2YinAxe;
+	maxIteration = displayed.maxIteration;
+	fractal = displayed.fractal;
+	previousViews = displayedRender.history;
+	RequestMandelbrot();
+}
+
+/// <summary>
+/// Draw another fractal, unzoomed. The Julia set uses the center of the current image as c,
+/// so zooming on an area of the Mandelbrot set first chooses its Julia set.
+/// </summary>
+/// <param name="type">fractal to draw</param>
+/// <param name="power">power of its formula</param>
+void ChangeFractal(FractalType type, int power) {
+	fractalParameters newFractal = { type, power, fractal.colorMode, fractal.juliaReal, fractal.juliaImag };
+	if (type == FRACTAL_JULIA && fractal.type != FRACTAL_JULIA) {
+		newFractal.juliaReal = centerX.ToDouble();
+		newFractal.juliaImag = centerY.ToDouble();
+	}
+	if (!AreFractalParametersValid(newFractal)) {
+		std::cout << "The center of the image is too far from 0 to draw its Julia set" << std::endl;
+		return;
+	}
+	SaveView();
+
+	fractal = newFractal;
+	centerX = BigFloat();
+	centerY = BigFloat();
+	P1XinAxe = -2.0;
+	P2XinAxe = 2.0;
+	P1YinAxe = P1XinAxe * pixelHeight / pixelWidth;
+	P2YinAxe = P2XinAxe * pixelHeight / pixelWidth;
+	maxIteration = 1000;
+	RequestMandelbrot();
+}
+
+/// <summary>
+/// Switch between the smooth colors and one band of color per iteration, the image is calculated again
+/// </summary>
+void ToggleColorMode() {
+	fractal.colorMode = fractal.colorMode == COLOR_SMOOTH ? COLOR_BANDS : COLOR_SMOOTH;
+	RequestMandelbrot();
+}
+
+/// <summary>
+/// Body of the reply thread, receive the replies of the render server until it closes the connection
+/// and leave them to the main thread, woken up by an SDL_USEREVENT
+/// </summary>
+void ReceiveRenderReplies() {
+	renderReply reply;
+	SDL_Event event = {};
+	event.type = SDL_USEREVENT;
+	while (ReceiveAll(renderServer, &reply, sizeof(reply))) {
+		{
+			std::lock_guard<std::mutex> lock(replyMutex);
+			receivedReplies.push_back(reply);
+		}
+		SDL_PushEvent(&event); // Wake up WindowLoop, if the queue is full the reply is handled with the next event
+	}
 	{
-		// Store the command in the commandeString variable
-		commandeString = std::string(FPPExeName) + ' ' + std::to_string(pixelWidth) + ' ' + std::to_string(pixelHeight) + ' ' + std::to_string(P1XinAxe) + ' ' + std::to_string(P2XinAxe) + ' ' + std::to_string(P1YinAxe) + ' ' + std::to_string(P2YinAxe);
+		std::lock_guard<std::mutex> lock(replyMutex);
+		replyThreadStopped = true;
 	}
-	else
+	SDL_PushEvent(&event);
+}
+
+/// <summary>
+/// Handle the replies received since the last call. Only the passes of the last request are displayed,
+/// the frames it superseded are cancelled by the render server or already out of date.
+/// </summary>
+void HandleRenderReplies() {
+	std::vector<renderReply> replies;
+	bool stopped;
 	{
-		// Store the command in the commandeString variable
-		commandeString = std::string(MPIExeName) + " -n " + std::to_string(nbProcessMpi) + ' ' + std::string(FPPExeName) + ' ' + std::to_string(pixelWidth) + ' ' + std::to_string(pixelHeight) + ' ' + std::to_string(P1XinAxe) + ' ' + std::to_string(P2XinAxe) + ' ' + std::to_string(P1YinAxe) + ' ' + std::to_string(P2YinAxe);
+		std::lock_guard<std::mutex> lock(replyMutex);
+		replies.swap(receivedReplies);
+		stopped = replyThreadStopped;
 	}
 
-	std::cout.flush(); // Flush the terminal buffer before calling the system method to avoid mixing the output of the two programs
-	system(commandeString.c_str());
+	for (const renderReply& reply : replies) {
+		if (pendingRequests.empty()) {
+			throw std::runtime_error("The render server replied to no request");
+		}
+		sentRequest request = pendingRequests.front();
+		bool lastRequest = pendingRequests.size() == 1;
+		if (reply.status != STATUS_PARTIAL) {
+			pendingRequests.pop_front();
+		}
+
+		if (reply.status == STATUS_INVALID_REQUEST && request.command == COMMAND_RECOLOR) {
+			throw std::runtime_error(std::string("The render server refused the palette ") + GetPaletteName(request.palette));
+		}
+		else if (reply.status == STATUS_INVALID_REQUEST) {
+			throw std::runtime_error("The render server refused the image of " + std::to_string(pixelWidth) + "x" + std::to_string(pixelHeight) + " pixels");
+		}
+		else if (reply.status == STATUS_CANCELLED && request.command == COMMAND_RECOLOR) {
+			std::cout << "Frame " << reply.frame << " not colored, it was cancelled by the next request" << std::endl;
+			continue;
+		}
+		else if (reply.status == STATUS_CANCELLED) {
+			std::cout << "Frame " << reply.frame << " cancelled after " << reply.seconds << " s" << std::endl;
+			continue;
+		}
+		else if (reply.status == STATUS_PARTIAL) {
+			std::cout << "Frame " << reply.frame << " previewed after " << reply.seconds << " s" << std::endl;
+		}
+		else if (request.command == COMMAND_RECOLOR) {
+			std::cout << "Frame " << reply.frame << " colored with the " << GetPaletteName(request.palette) << " palette in " << reply.seconds * 1000 << " ms" << std::endl;
+		}
+		else {
+			std::cout << "Frame " << reply.frame << " rendered in " << reply.seconds << " s" << std::endl;
+			if (lastRequest) {
+				displayedRender = request;
+				renderDisplayed = true;
+			}
+		}
+
+		if (lastRequest) {
+			imageOutdated = true;
+		}
+		// The palette changed while the frame was calculated
+		if (reply.status == STATUS_DONE && pendingRequests.empty() && request.palette != palette) {
+			SendRecolor();
+		}
+	}
+
+	// Display the last frame, if the server is already writing the next one this frame is copied with the next reply
+	if (imageOutdated) {
+		imageOutdated = !SetMandelbrotImage();
+	}
+
+	if (stopped && !pendingRequests.empty()) {
+		throw std::runtime_error("The render server stopped");
+	}
+}
+
+/// <summary>
+/// Color the current Mandelbrot image with another palette. The render server colors it again
+/// without calculating it, in a few milliseconds, once the frame being calculated is done.
+/// </summary>
+/// <param name="newPalette">palette to use</param>
+void RecolorMandelbrot(PaletteType newPalette) {
+	palette = newPalette;
+	if (pendingRequests.empty()) {
+		SendRecolor();
+	}
+}
 
-	SetMandelbrotImage();
+/// <summary>
+/// Ask the render server to color the last frame with the current palette
+/// </summary>
+void SendRecolor() {
+	renderRequest request = {};
+	request.command = COMMAND_RECOLOR;
+	request.palette = palette;
+	if (!SendAll(renderServer, &request, sizeof(request))) {
+		throw std::runtime_error("The render server stopped");
+	}
+	pendingRequests.push_back({ COMMAND_RECOLOR, palette });
 }
 
 /// <summary>
 /// Looping method of the SDL window to draw the rectangle when the user is selecting an area to zoom in
 /// and to calculate the Mandelbrot image when the user has finished selecting an area.
+/// The loop sleeps until an event or a reply of the render server arrives, and only copies to the screen the parts of the window
+/// which changed, so it leaves the processor to the MPI ranks.
 /// </summary>
 /// <returns>exit code</returns>
 int WindowLoop() {
@@ -221,9 +720,19 @@ int WindowLoop() {
 	SDL_Event event;
 	bool running = true;
 
-	while (running) {
-		// Wait for mouse click event or quit event
-		while (SDL_PollEvent(&event)) {
+	std::cout << "Press 1 to " << PALETTE_COUNT << " to change the palette (";
+	for (int i = 0; i < (int)PALETTE_COUNT; i++) {
+		std::cout << (i == 0 ? "" : ", ") << i + 1 << " " << GetPaletteName((PaletteType)i);
+	}
+	std::cout << ")" << std::endl;
+	std::cout << "Press the arrows to move the image and Backspace to go back to the previous view" << std::endl;
+	std::cout << "Press Escape to stop the zoom being calculated and go back to the previous view" << std::endl;
+	std::cout << "Press F1 for the Mandelbrot set, F2 for the Julia set of the center of the image, F3 for the Burning Ship,"
+		<< " F4 to raise the power of the formula and F5 to switch between smooth colors and bands" << std::endl;
+
+	// Wait for the next event, then handle the ones which came meanwhile before displaying the changes once
+	while (running && SDL_WaitEvent(&event)) {
+		do {
 			switch (event.type) {
 				case SDL_MOUSEBUTTONDOWN:
 					if (rectangleAvailable) {
@@ -241,11 +750,14 @@ int WindowLoop() {
 							std::cout << "P2 points at (" + std::to_string(P2x) + ", " + std::to_string(P2y) + ")" << std::endl;
 
 							rectangleAvailable = false;
+							selectionBorders.clear(); // Left on the image until the first pass of the zoom replaces it
 
+							SaveView();
 							CalculateMandelbrot(P1x, P1y, P2x, P2y); // Generate the Mandelbrot image with the selected area
 						}
 
 						// Reset values of the rectangle to zoom in
+						EraseSelection();
 						P1x = -1;
 						P1y = -1;
 						P2x = -1;
@@ -259,7 +771,7 @@ int WindowLoop() {
 						int mouseP2x = event.button.x;
 						int mouseP2y = event.button.y;
 
-						SDL_BlitSurface(image, NULL, window, NULL); // We need to redisplay the Mandelbrot image otherwise the rectangles overlap
+						EraseSelection(); // We need to redisplay the Mandelbrot image under the previous rectangle otherwise the rectangles overlap
 
 						// Don't draw the rectangle if the user is trying to zoom from right to left or from bottom to top
 						if (P1x < mouseP2x && P1y < mouseP2y) {
@@ -279,22 +791,7 @@ int WindowLoop() {
 							// Calculate the position of the bottom right corner of the rectangle to zoom in
 							P2x = P1x + (step * xStep) + xStep; // Round the width to the nearest superior multiple of xStep
 							P2y = P1y + (step * yStep) + yStep; // Round the height to the nearest superior multiple of yStep
-							int rectangleWidth = P2x - P1x;
-							int rectangleHeight = P2y - P1y;
-							
-							// Draw the rectangle to zoom in
-							// SDL_FillRect can't do only borders so we need to draw 4 rectangles
-							// SDL_Rect contains the top left corner and width and height of a rectangle, so it can't be right to left or bottom to top
-							constexpr int borderSize = 2;
-							const Uint32 rectangleColor = SDL_MapRGB(window->format, 22, 74, 200);
-							SDL_Rect rectangleTopLeftToTopRight = { P1x, P1y, rectangleWidth, borderSize };
-							SDL_FillRect(window, &rectangleTopLeftToTopRight, rectangleColor);
-							SDL_Rect rectangleTopLeftToBottomLeft = { P1x, P1y, borderSize, rectangleHeight };
-							SDL_FillRect(window, &rectangleTopLeftToBottomLeft, rectangleColor);
-							SDL_Rect rectangleTopRightToBottomRight = { P2x, P1y, borderSize, rectangleHeight };
-							SDL_FillRect(window, &rectangleTopRightToBottomRight, rectangleColor);
-							SDL_Rect rectangleBottomLeftToBottomRight = { P1x, P2y, rectangleWidth, borderSize };
-							SDL_FillRect(window, &rectangleBottomLeftToBottomRight, rectangleColor);
+							DrawSelection(P1x, P1y, P2x, P2y);
 						}
 						else {
 							// Reset the values of the bottom right corner of the rectangle to zoom in
@@ -303,12 +800,68 @@ int WindowLoop() {
 						}
 					}
 					break;
+				case SDL_KEYDOWN:
+					// Stop the frame being calculated, even before its first pass is displayed
+					if (event.key.keysym.sym == SDLK_ESCAPE && P1x == -1 && !pendingRequests.empty() && pendingRequests.back().command == COMMAND_RENDER && renderDisplayed) {
+						RestoreDisplayedView();
+					}
+					// Change the palette of the current image, unless the user is selecting an area to zoom in
+					if (rectangleAvailable && P1x == -1 && event.key.keysym.sym >= SDLK_1 && event.key.keysym.sym < SDLK_1 + (int)PALETTE_COUNT) {
+						RecolorMandelbrot((PaletteType)(event.key.keysym.sym - SDLK_1));
+					}
+					// Move the image by a quarter of its size with the arrows, go back to the previous view or change the fractal
+					else if (rectangleAvailable && P1x == -1) {
+						switch (event.key.keysym.sym) {
+							case SDLK_LEFT:
+								MoveView(-pixelWidth / 4, 0);
+								break;
+							case SDLK_RIGHT:
+								MoveView(pixelWidth / 4, 0);
+								break;
+							case SDLK_UP:
+								MoveView(0, -pixelHeight / 4);
+								break;
+							case SDLK_DOWN:
+								MoveView(0, pixelHeight / 4);
+								break;
+							case SDLK_BACKSPACE:
+								if (!previousViews.empty()) {
+									ShowPreviousView();
+								}
+								break;
+							case SDLK_F1:
+								ChangeFractal(FRACTAL_MANDELBROT, 2);
+								break;
+							case SDLK_F2:
+								ChangeFractal(FRACTAL_JULIA, 2);
+								break;
+							case SDLK_F3:
+								ChangeFractal(FRACTAL_BURNING_SHIP, 2);
+								break;
+							case SDLK_F4:
+								// The Multibrot sets with the Mandelbrot set
+								ChangeFractal(fractal.type, fractal.power == maxFractalPower ? minFractalPower : fractal.power + 1);
+								break;
+							case SDLK_F5:
+								ToggleColorMode();
+								break;
+							default:
+								break;
+						}
+					}
+					break;
+				case SDL_VIDEOEXPOSE:
+					dirtyRects.push_back(ClipToWindow(0, 0, pixelWidth, pixelHeight)); // The window was covered
+					break;
+				case SDL_USEREVENT:
+					break; // A reply of the render server, handled with the other replies below
 				case SDL_QUIT:
 					running = false; // End the loop to exit the program
 					break;
 			}
-		}
-		SDL_Flip(window); // Swap the buffers to display the new image or update the rectangle to zoom in
+		} while (running && SDL_PollEvent(&event));
+		HandleRenderReplies(); // Display the passes of the frame being calculated
+		PresentWindow(); // Display the new image or update the rectangle to zoom in
 	}
 	return 0;
 }
@@ -339,25 +892,143 @@ const int GreatestCommonDivisor(int a, int b)
 }
 
 /// <summary>
-/// Set the newly generated Mandelbrot image in the SDL hidden buffer
-/// Calling SDL_Flip(form) is needed to swap the buffers and display the image
+/// Set the newly generated Mandelbrot image in the window surface,
+/// from the shared memory or from the BMP file if the shared memory couldn't be created.
+/// The frame is copied out of the shared memory, the server rewriting it with the next pass while the image is still displayed.
+/// The rectangle being selected is drawn again over it. Calling PresentWindow() is needed to display the image.
 /// </summary>
-void SetMandelbrotImage() {
-	// Get the path of the Mandelbrot image
+/// <returns>false if the server kept rewriting the shared memory during the copy, the previous image then stays displayed</returns>
+bool SetMandelbrotImage() {
+	SDL_Surface* newImage;
+	if (sharedFrame.IsOpen()) {
+		Uint32 rmask, gmask, bmask;
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+		rmask = 0x0000ff00;
+		gmask = 0x00ff0000;
+		bmask = 0xff000000;
+#else
+		rmask = 0x00ff0000;
+		gmask = 0x0000ff00;
+		bmask = 0x000000ff;
+#endif
+		newImage = SDL_CreateRGBSurface(SDL_SWSURFACE, pixelWidth, pixelHeight, 32, rmask, gmask, bmask, 0);
+		if (!newImage) {
+			throw std::runtime_error(std::string("Error creating image: ") + SDL_GetError());
+		}
+
+		// Copy the frame, again if the server started writing the next one during the copy
+		bool copied = false;
+		for (int attempt = 0; attempt < 10 && !copied; attempt++) {
+			uint64_t sequence = sharedFrame.GetSequence();
+			if (!sharedFrame.IsReady() || sharedFrame.GetWidth() != pixelWidth || sharedFrame.GetHeight() != pixelHeight) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				continue;
+			}
+			for (int row = 0; row < pixelHeight; row++) {
+				std::memcpy((unsigned char*)newImage->pixels + (size_t)row * newImage->pitch, sharedFrame.GetPixels() + (size_t)row * pixelWidth * 4, (size_t)pixelWidth * 4);
+			}
+			std::atomic_thread_fence(std::memory_order_acquire);
+			copied = sharedFrame.IsReady() && sharedFrame.GetSequence() == sequence;
+		}
+		if (!copied) {
+			SDL_FreeSurface(newImage);
+			return false;
+		}
+	}
+	else {
+		// Get the path of the Mandelbrot image
 #if defined(WIN32) || defined(_WIN32) || defined(__WIN32) && !defined(__CYGWIN__)
-	std::string path = std::filesystem::temp_directory_path().string() + "Mandelbrot.bmp";
+		std::string path = std::filesystem::temp_directory_path().string() + "Mandelbrot.bmp";
 #else
-	std::string path = "/tmp/Mandelbrot.bmp";
+		std::string path = "/tmp/Mandelbrot.bmp";
 #endif
-	image = SDL_LoadBMP(path.c_str());
-	if (!image) {
-		throw std::runtime_error(std::string("Error loading image: ") + SDL_GetError());
+		newImage = SDL_LoadBMP(path.c_str());
+		if (!newImage) {
+			throw std::runtime_error(std::string("Error loading image: ") + SDL_GetError());
+		}
 	}
-	
+	if (image) {
+		SDL_FreeSurface(image);
+	}
+	image = newImage;
+
 	rectangleAvailable = true; // Reset the variable to allow the user to select a new area to zoom in
 
-	// Display the image (in the hidden buffer)
+	// Display the image (in the window surface), then the rectangle being selected over it
 	SDL_BlitSurface(image, NULL, window, NULL);
+	const Uint32 rectangleColor = SDL_MapRGB(window->format, 22, 74, 200);
+	for (SDL_Rect& border : selectionBorders) {
+		SDL_FillRect(window, &border, rectangleColor);
+	}
+	dirtyRects.push_back(ClipToWindow(0, 0, pixelWidth, pixelHeight));
+	return true;
+}
+
+/// <summary>
+/// Get the part of a rectangle inside the window, SDL_UpdateRects refusing the rectangles going out of it
+/// </summary>
+/// <param name="x">X position of the left column</param>
+/// <param name="y">Y position of the top row</param>
+/// <param name="width">width in pixels</param>
+/// <param name="height">height in pixels</param>
+/// <returns>rectangle clipped to the window, with a width or height of 0 if it's outside</returns>
+SDL_Rect ClipToWindow(int x, int y, int width, int height) {
+	int left = std::clamp(x, 0, pixelWidth);
+	int top = std::clamp(y, 0, pixelHeight);
+	int right = std::clamp(x + width, 0, pixelWidth);
+	int bottom = std::clamp(y + height, 0, pixelHeight);
+	return { (Sint16)left, (Sint16)top, (Uint16)(right - left), (Uint16)(bottom - top) };
+}
+
+/// <summary>
+/// Draw the rectangle to zoom in over the image, erased with EraseSelection
+/// </summary>
+/// <param name="P1x">X position of the top left corner</param>
+/// <param name="P1y">Y position of the top left corner</param>
+/// <param name="P2x">X position of the bottom right corner</param>
+/// <param name="P2y">Y position of the bottom right corner</param>
+void DrawSelection(int P1x, int P1y, int P2x, int P2y) {
+	int rectangleWidth = P2x - P1x;
+	int rectangleHeight = P2y - P1y;
+
+	// SDL_FillRect can't do only borders so we need to draw 4 rectangles
+	// SDL_Rect contains the top left corner and width and height of a rectangle, so it can't be right to left or bottom to top
+	constexpr int borderSize = 2;
+	const Uint32 rectangleColor = SDL_MapRGB(window->format, 22, 74, 200);
+	selectionBorders = {
+		ClipToWindow(P1x, P1y, rectangleWidth, borderSize), // Top left to top right
+		ClipToWindow(P1x, P1y, borderSize, rectangleHeight), // Top left to bottom left
+		ClipToWindow(P2x, P1y, borderSize, rectangleHeight), // Top right to bottom right
+		ClipToWindow(P1x, P2y, rectangleWidth, borderSize) // Bottom left to bottom right
+	};
+	for (SDL_Rect& border : selectionBorders) {
+		SDL_FillRect(window, &border, rectangleColor);
+		dirtyRects.push_back(border);
+	}
+}
+
+/// <summary>
+/// Erase the rectangle to zoom in by copying the image back under its borders
+/// </summary>
+void EraseSelection() {
+	for (SDL_Rect& border : selectionBorders) {
+		SDL_Rect target = border; // SDL_BlitSurface changes the destination rectangle
+		SDL_BlitSurface(image, &border, window, &target);
+		dirtyRects.push_back(border);
+	}
+	selectionBorders.clear();
+}
+
+/// <summary>
+/// Copy the parts of the window which changed to the screen
+/// </summary>
+void PresentWindow() {
+	// The borders of a rectangle outside the window are empty
+	dirtyRects.erase(std::remove_if(dirtyRects.begin(), dirtyRects.end(), [](const SDL_Rect& rect) { return rect.w == 0 || rect.h == 0; }), dirtyRects.end());
+	if (!dirtyRects.empty()) {
+		SDL_UpdateRects(window, (int)dirtyRects.size(), dirtyRects.data());
+		dirtyRects.clear();
+	}
 }
 
 /// <summary>
@@ -0,0 +1,133 @@
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include "Animation.h"
+
+
+/// <summary>
+/// Name of each easing in the keyframe file, in the order of EasingType
+/// </summary>
+static const char* const easingNames[EASING_COUNT] = { "linear", "ease-in", "ease-out", "ease-in-out" };
+
+/// <summary>
+/// Read the keyframes of an animation, one per line, the empty lines and the lines starting with # being ignored.
+/// A line is "centerX centerY width [frames [easing]]", frames (default 1) being the number of frames until the next keyframe
+/// and easing (default linear) one of linear, ease-in, ease-out and ease-in-out.
+/// </summary>
+/// <param name="path">path of the keyframe file</param>
+/// <returns>keyframes in the order of the file, at least one</returns>
+std::vector<keyframe> LoadKeyframes(const std::string& path)
+{
+	std::ifstream file(path);
+	if (!file) {
+		throw std::invalid_argument("Unable to read the keyframes " + path);
+	}
+
+	std::vector<keyframe> keyframes;
+	std::string line;
+	for (int lineNumber = 1; std::getline(file, line); lineNumber++) {
+		std::istringstream values(line);
+		std::string first;
+		if (!(values >> first) || first[0] == '#') {
+			continue;
+		}
+
+		keyframe key = { 0, 0, 0, 1, EASING_LINEAR };
+		std::string easing;
+		values.clear();
+		values.seekg(0);
+		if (!(values >> key.centerX >> key.centerY >> key.width) || key.width <= 0) {
+			throw std::invalid_argument("Line " + std::to_string(lineNumber) + " of " + path + " must be centerX centerY width [frames [easing]] with a positive width");
+		}
+		if (values >> key.frames && values >> easing) {
+			int i = 0;
+			while (i < EASING_COUNT && easing != easingNames[i]) {
+				i++;
+			}
+			if (i == EASING_COUNT) {
+				throw std::invalid_argument("The easing of line " + std::to_string(lineNumber) + " of " + path + " must be linear, ease-in, ease-out or ease-in-out");
+			}
+			key.easing = (EasingType)i;
+		}
+		if (key.frames < 1) {
+			throw std::invalid_argument("The frames of line " + std::to_string(lineNumber) + " of " + path + " must be greater than 0");
+		}
+		keyframes.push_back(key);
+	}
+
+	if (keyframes.empty()) {
+		throw std::invalid_argument("No keyframe in " + path);
+	}
+	return keyframes;
+}
+
+/// <summary>
+/// Get the number of frames of an animation
+/// </summary>
+/// <param name="keyframes">keyframes of the animation</param>
+/// <returns>frames between the keyframes, and the last keyframe</returns>
+int GetAnimationFrameCount(const std::vector<keyframe>& keyframes)
+{
+	int frames = 1;
+	for (size_t i = 0; i + 1 < keyframes.size(); i++) {
+		frames += keyframes[i].frames;
+	}
+	return frames;
+}
+
+/// <summary>
+/// Apply an easing to the progress between two keyframes
+/// </summary>
+/// <param name="easing">easing of the first keyframe</param>
+/// <param name="t">progress from 0 to 1</param>
+/// <returns>eased progress from 0 to 1</returns>
+static double Ease(EasingType easing, double t)
+{
+	switch (easing) {
+		case EASING_IN:
+			return t * t;
+		case EASING_OUT:
+			return t * (2 - t);
+		case EASING_IN_OUT:
+			return t * t * (3 - 2 * t);
+		default:
+			return t;
+	}
+}
+
+/// <summary>
+/// Get the area of the complex plane of a frame.
+/// The width changes geometrically between two keyframes so the zoom speed looks constant,
+/// and the center moves with it so a zoom between two keyframes keeps the center of the second one fixed on the screen.
+/// </summary>
+/// <param name="keyframes">keyframes of the animation</param>
+/// <param name="frame">frame, from 0 to GetAnimationFrameCount() - 1</param>
+/// <param name="aspectRatio">height of the image divided by its width</param>
+/// <returns>area of the frame</returns>
+animationView GetAnimationView(const std::vector<keyframe>& keyframes, int frame, double aspectRatio)
+{
+	size_t segment = 0;
+	while (segment + 1 < keyframes.size() && frame >= keyframes[segment].frames) {
+		frame -= keyframes[segment].frames;
+		segment++;
+	}
+
+	const keyframe& from = keyframes[segment];
+	double centerX = from.centerX;
+	double centerY = from.centerY;
+	double width = from.width;
+	if (segment + 1 < keyframes.size()) {
+		const keyframe& to = keyframes[segment + 1];
+		double progress = Ease(from.easing, (double)frame / from.frames);
+		width = from.width * pow(to.width / from.width, progress);
+		// Share of the way done by the camera, the share of the change of the width when it changes
+		double move = fabs(to.width - from.width) > 1e-9 * from.width ? (from.width - width) / (from.width - to.width) : progress;
+		centerX = from.centerX + (to.centerX - from.centerX) * move;
+		centerY = from.centerY + (to.centerY - from.centerY) * move;
+	}
+
+	double height = width * aspectRatio;
+	return { centerX - width / 2, centerX + width / 2, centerY - height / 2, centerY + height / 2 };
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Speed of the camera between two keyframes
+/// </summary>
+enum EasingType {
+	EASING_LINEAR, // Constant speed
+	EASING_IN, // Starts slowly
+	EASING_OUT, // Ends slowly
+	EASING_IN_OUT, // Starts and ends slowly
+	EASING_COUNT
+};
+
+/// <summary>
+/// Point of the path of a zoom animation, read from a line "centerX centerY width [frames [easing]]" of the keyframe file
+/// </summary>
+typedef struct keyframe {
+	double centerX; // Center of the image in the complex plane
+	double centerY;
+	double width; // Width of the area of the complex plane, the height follows the ratio of the image
+	int frames; // Number of frames from this keyframe to the next one, unused for the last keyframe
+	EasingType easing; // Speed of the camera until the next keyframe
+} keyframe;
+
+/// <summary>
+/// Area of the complex plane of a frame of the animation
+/// </summary>
+typedef struct animationView {
+	double minRangeX;
+	double maxRangeX;
+	double minRangeY;
+	double maxRangeY;
+} animationView;
+
+std::vector<keyframe> LoadKeyframes(const std::string&);
+int GetAnimationFrameCount(const std::vector<keyframe>&);
+animationView GetAnimationView(const std::vector<keyframe>&, int, double);
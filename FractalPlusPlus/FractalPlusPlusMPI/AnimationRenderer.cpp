@@ -0,0 +1,322 @@
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <list>
+#include <stdexcept>
+#include <mpi.h>
+
+#include "AnimationRenderer.h"
+#include "Animation.h"
+#include "Schedules.h"
+
+
+/// <summary>
+/// Frame of an animation being calculated by the ranks, assembled by rank 0
+/// </summary>
+typedef struct animationFrame {
+	int index;
+	std::vector<float> iterations; // Smooth iteration counts of the frame, filled chunk by chunk
+	std::vector<int> chunkOrder; // First row of each chunk, in the order they are handed out
+	size_t nextChunk; // Next chunk of chunkOrder to hand out
+	int rowsLeft; // Rows not calculated yet
+} animationFrame;
+
+static void RunAnimationMaster(FractalRenderer&, int, int, rankStatistics*, const std::vector<keyframe>&, const std::string&);
+static void RunAnimationWorker(FractalRenderer&, rankStatistics*, const std::vector<keyframe>&);
+static void SetAnimationFrame(FractalRenderer&, int, const std::vector<keyframe>&);
+static std::vector<int> GetAnimationChunkOrder(const FractalRenderer&, const std::vector<float>&, const animationView&);
+static void SaveAnimationFrame(FractalRenderer&, const animationFrame&, const std::string&);
+
+/// <summary>
+/// Render every frame of the zoom animation of path in one run, saving them in directory as they are done.
+/// The frames are calculated by chunks of rows with the dynamic schedule, rank 0 handing out the chunks of the next frame
+/// as soon as every chunk of the current ones is handed out, so the ranks never wait for the end of a frame.
+/// The frames are calculated in float or double precision like --precision chooses it for each of them, without the perturbation,
+/// so the animations going deeper than a double are refused.
+/// </summary>
+/// <param name="renderer">renderer calculating the frames</param>
+/// <param name="rank">rank of the current process</param>
+/// <param name="numtasks">number of MPI ranks</param>
+/// <param name="path">keyframe file of the animation</param>
+/// <param name="directory">directory where the frames are saved</param>
+void RenderAnimation(FractalRenderer& renderer, int rank, int numtasks, const std::string& path, const std::string& directory)
+{
+	std::vector<keyframe> keyframes = LoadKeyframes(path);
+	int frameCount = GetAnimationFrameCount(keyframes);
+	renderer.engine = GetFractalEngine(renderer.fractal);
+	SetFormulaKernel(renderer.engine.escapeTimeRow);
+	// The ranges of the frames are doubles, the center in double-double and the reference orbit of the deep zooms aren't calculated
+	if (renderer.precisionMode == PRECISION_DOUBLE_DOUBLE) {
+		throw std::invalid_argument("The frames of --animation are calculated in float or double, not in double-double");
+	}
+	for (int frame = 0; frame < frameCount; frame++) {
+		SetAnimationFrame(renderer, frame, keyframes);
+		if (renderer.GetRelativeSpacing() < perturbationSpacing) {
+			throw std::invalid_argument("Frame " + std::to_string(frame) + " of " + path + " is too deep for the double precision of --animation");
+		}
+	}
+	renderer.phaseTrace.NextFrame();
+
+	// Every frame is calculated at full resolution in one pass, like the grid of a single pass
+	renderer.referenceReal.clear();
+	renderer.referenceImag.clear();
+	renderer.passStep = 1;
+	renderer.passReuse = false;
+	renderer.passWidth = renderer.pixelWidth;
+	renderer.passHeight = renderer.pixelHeight;
+
+	double startTime = MPI_Wtime();
+	if (rank == 0) {
+		std::filesystem::create_directories(directory);
+		std::cout << "Calculating " << frameCount << " frames of " << keyframes.size() << " keyframes with the " << GetKernelName() << " kernel and "
+			<< renderer.threadPool->GetThreadCount() << " threads per rank" << std::endl;
+		std::cout << "--------------------------------------------------" << std::endl;
+	}
+
+	rankStatistics statistics = { 0, 0, 0, 0, 0 };
+	renderer.kernelIterations = 0;
+	if (rank == 0) {
+		RunAnimationMaster(renderer, numtasks, frameCount, &statistics, keyframes, directory);
+	}
+	else {
+		RunAnimationWorker(renderer, &statistics, keyframes);
+	}
+	statistics.iterations = (double)renderer.kernelIterations;
+	ReportStatistics(renderer, rank, numtasks, statistics);
+
+	if (rank == 0) {
+		double seconds = MPI_Wtime() - startTime;
+		std::cout << frameCount << " frames saved in " << directory << " in " << seconds << " s (" << frameCount / seconds << " frames per second)" << std::endl;
+	}
+}
+
+/// <summary>
+/// Rank 0's side of the animation, the dynamic schedule of RunDynamicMaster over the chunks of every frame.
+/// The chunks of a frame are handed out the most expensive first, their cost being estimated from the last saved frame,
+/// so the last chunks of a frame are short and its end doesn't wait for a slow chunk.
+/// </summary>
+/// <param name="renderer">renderer calculating the frames</param>
+/// <param name="numtasks">number of MPI ranks</param>
+/// <param name="frameCount">number of frames of the animation</param>
+/// <param name="statistics">work done by rank 0</param>
+/// <param name="keyframes">keyframes of the animation</param>
+/// <param name="directory">directory where the frames are saved</param>
+static void RunAnimationMaster(FractalRenderer& renderer, int numtasks, int frameCount, rankStatistics* statistics, const std::vector<keyframe>& keyframes, const std::string& directory)
+{
+	// Frames being calculated, a frame starts only when every chunk of the others is handed out,
+	// so there are at most numtasks + 1 of them, each rank calculating a chunk of one of them
+	std::list<animationFrame> frames;
+	int nextFrame = 0;
+	int activeWorkers = numtasks - 1;
+	bool computes = renderer.RankZeroComputes(numtasks);
+
+	// Last saved frame, the estimate of the cost of the chunks of the next frames
+	std::vector<float> estimate;
+	animationView estimateView = {};
+
+	// Find the next chunk to calculate, starting a new frame if needed. work is {frame, firstRow, rowCount}
+	auto takeChunk = [&](int* work) {
+		auto frame = std::find_if(frames.begin(), frames.end(), [](const animationFrame& f) { return f.nextChunk < f.chunkOrder.size(); });
+		if (frame == frames.end()) {
+			if (nextFrame == frameCount) {
+				work[0] = work[1] = work[2] = 0;
+				return false;
+			}
+			SetAnimationFrame(renderer, nextFrame, keyframes);
+			frames.push_back({ nextFrame, std::vector<float>((size_t)renderer.pixelWidth * renderer.pixelHeight), GetAnimationChunkOrder(renderer, estimate, estimateView), 0, renderer.pixelHeight });
+			frame = std::prev(frames.end());
+			nextFrame++;
+		}
+		work[0] = frame->index;
+		work[1] = frame->chunkOrder[frame->nextChunk++];
+		work[2] = std::min(renderer.chunkRows, renderer.pixelHeight - work[1]);
+		return true;
+	};
+	auto findFrame = [&](int index) {
+		return std::find_if(frames.begin(), frames.end(), [index](const animationFrame& f) { return f.index == index; });
+	};
+	// Save the frame once its last rows are calculated
+	auto chunkDone = [&](std::list<animationFrame>::iterator frame, int rowCount) {
+		frame->rowsLeft -= rowCount;
+		if (frame->rowsLeft == 0) {
+			SaveAnimationFrame(renderer, *frame, directory);
+			SetAnimationFrame(renderer, frame->index, keyframes);
+			estimateView = { renderer.minRangeX, renderer.maxRangeX, renderer.minRangeY, renderer.maxRangeY };
+			estimate = std::move(frame->iterations);
+			frames.erase(frame);
+		}
+	};
+	auto hasWork = [&]() {
+		return nextFrame < frameCount || std::any_of(frames.begin(), frames.end(), [](const animationFrame& f) { return f.nextChunk < f.chunkOrder.size(); });
+	};
+
+	while (hasWork() || activeWorkers > 0) {
+		// Answer every rank waiting for work, wait for them when rank 0 has nothing left to calculate
+		int pending = 0;
+		MPI_Iprobe(MPI_ANY_SOURCE, TAG_RESULT, MPI_COMM_WORLD, &pending, MPI_STATUS_IGNORE);
+		while (pending || ((!hasWork() || !computes) && activeWorkers > 0)) {
+			MPI_Status status;
+			int result[3];
+			double traceStart = renderer.phaseTrace.Now();
+			MPI_Recv(result, 3, MPI_INT, MPI_ANY_SOURCE, TAG_RESULT, MPI_COMM_WORLD, &status);
+			int worker = status.MPI_SOURCE;
+			if (result[2] > 0) {
+				auto frame = findFrame(result[0]);
+				MPI_Recv(frame->iterations.data() + (size_t)result[1] * renderer.pixelWidth, result[2] * renderer.pixelWidth, MPI_FLOAT, worker, TAG_CHUNK_PIXELS, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+				renderer.phaseTrace.Add(PHASE_RECEIVE, traceStart, (double)result[2] * renderer.pixelWidth);
+				chunkDone(frame, result[2]);
+			}
+
+			int work[3];
+			if (!takeChunk(work)) {
+				activeWorkers--;
+			}
+			MPI_Send(work, 3, MPI_INT, worker, TAG_WORK, MPI_COMM_WORLD);
+
+			MPI_Iprobe(MPI_ANY_SOURCE, TAG_RESULT, MPI_COMM_WORLD, &pending, MPI_STATUS_IGNORE);
+		}
+
+		// Calculate one chunk of rank 0's own share
+		int work[3];
+		if (computes && takeChunk(work)) {
+			auto frame = findFrame(work[0]);
+			SetAnimationFrame(renderer, work[0], keyframes);
+			double startTime = MPI_Wtime();
+			double traceStart = renderer.phaseTrace.Now();
+			long long previousIterations = renderer.kernelIterations;
+			renderer.ComputePixels(work[1] * renderer.pixelWidth, work[2] * renderer.pixelWidth, frame->iterations.data() + (size_t)work[1] * renderer.pixelWidth);
+			statistics->busyTime += MPI_Wtime() - startTime;
+			statistics->chunks++;
+			statistics->pixels += (double)work[2] * renderer.pixelWidth;
+			statistics->iteratedPixels += (double)work[2] * renderer.pixelWidth;
+			renderer.phaseTrace.Add(PHASE_COMPUTE, traceStart, (double)(renderer.kernelIterations - previousIterations));
+			chunkDone(frame, work[2]);
+		}
+	}
+}
+
+/// <summary>
+/// Worker's side of the animation, like RunDynamicWorker with the frame of each chunk
+/// </summary>
+/// <param name="renderer">renderer calculating the frames</param>
+/// <param name="statistics">work done by the rank</param>
+/// <param name="keyframes">keyframes of the animation</param>
+static void RunAnimationWorker(FractalRenderer& renderer, rankStatistics* statistics, const std::vector<keyframe>& keyframes)
+{
+	std::vector<float> chunkIterations((size_t)renderer.chunkRows * renderer.pixelWidth);
+	int result[3] = { 0, 0, 0 };
+
+	while (true) {
+		double traceStart = renderer.phaseTrace.Now();
+		MPI_Send(result, 3, MPI_INT, 0, TAG_RESULT, MPI_COMM_WORLD);
+		if (result[2] > 0) {
+			MPI_Send(chunkIterations.data(), result[2] * renderer.pixelWidth, MPI_FLOAT, 0, TAG_CHUNK_PIXELS, MPI_COMM_WORLD);
+		}
+		renderer.phaseTrace.Add(PHASE_SEND, traceStart, (double)result[2] * renderer.pixelWidth);
+
+		int work[3];
+		traceStart = renderer.phaseTrace.Now();
+		MPI_Recv(work, 3, MPI_INT, 0, TAG_WORK, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+		renderer.phaseTrace.Add(PHASE_RECEIVE, traceStart, 3);
+		if (work[2] == 0) {
+			break; // No more work
+		}
+
+		SetAnimationFrame(renderer, work[0], keyframes);
+		double startTime = MPI_Wtime();
+		traceStart = renderer.phaseTrace.Now();
+		long long previousIterations = renderer.kernelIterations;
+		renderer.ComputePixels(work[1] * renderer.pixelWidth, work[2] * renderer.pixelWidth, chunkIterations.data());
+		statistics->busyTime += MPI_Wtime() - startTime;
+		statistics->chunks++;
+		statistics->pixels += (double)work[2] * renderer.pixelWidth;
+		statistics->iteratedPixels += (double)work[2] * renderer.pixelWidth;
+		renderer.phaseTrace.Add(PHASE_COMPUTE, traceStart, (double)(renderer.kernelIterations - previousIterations));
+
+		std::copy(work, work + 3, result);
+	}
+}
+
+/// <summary>
+/// Set the area of the complex plane and the precision of the current frame to the ones of a frame of the animation,
+/// the precision being chosen like PreparePrecision does between float and double
+/// </summary>
+/// <param name="renderer">renderer calculating the frames</param>
+/// <param name="frame">frame of the animation</param>
+/// <param name="keyframes">keyframes of the animation</param>
+static void SetAnimationFrame(FractalRenderer& renderer, int frame, const std::vector<keyframe>& keyframes)
+{
+	animationView view = GetAnimationView(keyframes, frame, (double)renderer.pixelHeight / renderer.pixelWidth);
+	renderer.minRangeX = view.minRangeX;
+	renderer.maxRangeX = view.maxRangeX;
+	renderer.minRangeY = view.minRangeY;
+	renderer.maxRangeY = view.maxRangeY;
+	renderer.rangeWidth = renderer.maxRangeX - renderer.minRangeX;
+	renderer.rangeHeight = renderer.maxRangeY - renderer.minRangeY;
+
+	PrecisionType precision = renderer.precisionMode;
+	if (precision == PRECISION_AUTO) {
+		precision = renderer.GetRelativeSpacing() >= floatSpacing ? PRECISION_FLOAT : PRECISION_DOUBLE;
+	}
+	// Only the kernels of the Mandelbrot set of power 2 have a float version
+	SetPrecision(precision == PRECISION_FLOAT && renderer.engine.escapeTimeRow == nullptr ? PRECISION_FLOAT : PRECISION_DOUBLE);
+}
+
+/// <summary>
+/// Order the chunks of the current frame from the most to the least expensive, estimated from the iteration counts
+/// of a previous frame at the same place of the complex plane, one pixel out of 8 of each row.
+/// The areas the previous frame doesn't cover count maxIteration, like the pixels inside the set.
+/// </summary>
+/// <param name="renderer">renderer calculating the frames</param>
+/// <param name="estimate">smooth iteration counts of the previous frame, empty for the first frame</param>
+/// <param name="estimateView">area of the previous frame</param>
+/// <returns>first row of each chunk, the most expensive first</returns>
+static std::vector<int> GetAnimationChunkOrder(const FractalRenderer& renderer, const std::vector<float>& estimate, const animationView& estimateView)
+{
+	constexpr int sampleStep = 8;
+	int chunkCount = (renderer.pixelHeight + renderer.chunkRows - 1) / renderer.chunkRows;
+	std::vector<int> order(chunkCount);
+	std::vector<double> costs(chunkCount);
+	for (int chunk = 0; chunk < chunkCount; chunk++) {
+		order[chunk] = chunk * renderer.chunkRows;
+		if (estimate.empty()) {
+			continue;
+		}
+		for (int row = order[chunk]; row < std::min(order[chunk] + renderer.chunkRows, renderer.pixelHeight); row++) {
+			double y = renderer.minRangeY + (row + 0.5) * renderer.rangeHeight / renderer.pixelHeight;
+			long long estimateRow = (long long)floor((y - estimateView.minRangeY) / (estimateView.maxRangeY - estimateView.minRangeY) * renderer.pixelHeight);
+			for (int column = 0; column < renderer.pixelWidth; column += sampleStep) {
+				double x = renderer.minRangeX + (column + 0.5) * renderer.rangeWidth / renderer.pixelWidth;
+				long long estimateColumn = (long long)floor((x - estimateView.minRangeX) / (estimateView.maxRangeX - estimateView.minRangeX) * renderer.pixelWidth);
+				float count = estimateRow < 0 || estimateRow >= renderer.pixelHeight || estimateColumn < 0 || estimateColumn >= renderer.pixelWidth
+					? interiorIteration : estimate[(size_t)estimateRow * renderer.pixelWidth + estimateColumn];
+				costs[chunk] += count == interiorIteration ? renderer.maxIteration : count;
+			}
+		}
+	}
+
+	std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return costs[a / renderer.chunkRows] > costs[b / renderer.chunkRows]; });
+	return order;
+}
+
+/// <summary>
+/// Color a finished frame of the animation and save it in directory
+/// </summary>
+/// <param name="renderer">renderer calculating the frames</param>
+/// <param name="frame">frame whose rows are all calculated</param>
+/// <param name="directory">directory where the frames are saved</param>
+static void SaveAnimationFrame(FractalRenderer& renderer, const animationFrame& frame, const std::string& directory)
+{
+	double traceStart = renderer.phaseTrace.Now();
+	renderer.framebuffer.resize(frame.iterations.size());
+	Colorize(frame.iterations.data(), frame.iterations.size(), renderer.maxIteration, renderer.palette, (unsigned char*)renderer.framebuffer.data());
+	renderer.phaseTrace.Add(PHASE_ENCODE, traceStart, (double)frame.iterations.size());
+
+	traceStart = renderer.phaseTrace.Now();
+	char name[32];
+	snprintf(name, sizeof(name), "frame_%05d.bmp", frame.index);
+	SaveBitmap(renderer.framebuffer.data(), renderer.pixelWidth, renderer.pixelHeight, (std::filesystem::path(directory) / name).string());
+	renderer.phaseTrace.Add(PHASE_WRITE, traceStart, (double)frame.iterations.size());
+	std::cout << "Frame " << frame.index << " saved" << std::endl;
+}
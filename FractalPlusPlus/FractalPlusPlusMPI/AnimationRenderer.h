@@ -0,0 +1,6 @@
+#pragma once
+#include <string>
+
+#include "FractalRenderer.h"
+
+void RenderAnimation(FractalRenderer&, int, int, const std::string&, const std::string&);
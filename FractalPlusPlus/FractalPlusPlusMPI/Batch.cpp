@@ -0,0 +1,112 @@
+#include <climits>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#include "Batch.h"
+
+
+/// <summary>
+/// Wait for the thread when every line was read, otherwise leave it blocked on the standard input
+/// </summary>
+JobReader::~JobReader()
+{
+	if (thread.joinable()) {
+		std::lock_guard<std::mutex> lock(mutex);
+		if (ended) {
+			thread.join();
+		}
+		else {
+			thread.detach();
+		}
+	}
+}
+
+/// <summary>
+/// Open the job file and start reading it
+/// </summary>
+/// <param name="path">path of the job file, - for the standard input</param>
+void JobReader::Open(const std::string& path)
+{
+	std::istream* input = &std::cin;
+	if (path != "-") {
+		file.open(path);
+		if (!file) {
+			throw std::invalid_argument("Unable to read the jobs " + path);
+		}
+		input = &file;
+	}
+
+	thread = std::thread([this, input]() {
+		std::string line;
+		for (int lineNumber = 1; std::getline(*input, line); lineNumber++) {
+			size_t first = line.find_first_not_of(" \t\r");
+			if (first == std::string::npos || line[first] == '#') {
+				continue;
+			}
+			std::lock_guard<std::mutex> lock(mutex);
+			lines.emplace_back(lineNumber, line);
+			lineRead.notify_all();
+		}
+		std::lock_guard<std::mutex> lock(mutex);
+		ended = true;
+		lineRead.notify_all();
+	});
+}
+
+/// <summary>
+/// Take the next line without waiting for it
+/// </summary>
+/// <param name="lineNumber">filled with the number of the line in the file, from 1</param>
+/// <param name="line">filled with the line</param>
+/// <returns>whether a line was returned, or why not</returns>
+JobLineStatus JobReader::TryNext(int* lineNumber, std::string* line)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (lines.empty()) {
+		return ended ? JOB_LINE_END : JOB_LINE_WAITING;
+	}
+	*lineNumber = lines.front().first;
+	*line = std::move(lines.front().second);
+	lines.pop_front();
+	return JOB_LINE_READ;
+}
+
+/// <summary>
+/// Wait until a line can be taken by TryNext or every line was read
+/// </summary>
+void JobReader::WaitForLine()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	lineRead.wait(lock, [this]() { return !lines.empty() || ended; });
+}
+
+/// <summary>
+/// Read a job from a line of the job file
+/// </summary>
+/// <param name="line">"width height minRangeX maxRangeX minRangeY maxRangeY maxIteration output"</param>
+/// <returns>job of the line</returns>
+batchJob ParseBatchJob(const std::string& line)
+{
+	std::istringstream values(line);
+	batchJob job = {};
+	if (!(values >> job.width >> job.height >> job.minRangeX >> job.maxRangeX >> job.minRangeY >> job.maxRangeY >> job.maxIteration)) {
+		throw std::invalid_argument("The job must be width height minRangeX maxRangeX minRangeY maxRangeY maxIteration output");
+	}
+	std::getline(values >> std::ws, job.output);
+	job.output.erase(job.output.find_last_not_of(" \t\r") + 1);
+
+	if (job.width <= 0 || job.height <= 0 || (long long)job.width * job.height > INT_MAX) {
+		throw std::invalid_argument("The size of the image must be positive and below 2^31 pixels");
+	}
+	if (!(job.minRangeX < job.maxRangeX) || !(job.minRangeY < job.maxRangeY)) {
+		throw std::invalid_argument("The minimum of each range must be lower than its maximum");
+	}
+	if (job.maxIteration <= 0) {
+		throw std::invalid_argument("maxIteration must be greater than 0");
+	}
+	if (job.output.empty()) {
+		throw std::invalid_argument("The job has no output path");
+	}
+	return job;
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/// <summary>
+/// Image of a batch, read from a line "width height minRangeX maxRangeX minRangeY maxRangeY maxIteration output" of the job file
+/// </summary>
+typedef struct batchJob {
+	int width;
+	int height;
+	double minRangeX;
+	double maxRangeX;
+	double minRangeY;
+	double maxRangeY;
+	int maxIteration;
+	std::string output; // Path of the BMP file, the rest of the line so it can contain spaces
+} batchJob;
+
+/// <summary>
+/// Result of JobReader::TryNext
+/// </summary>
+enum JobLineStatus {
+	JOB_LINE_READ, // A line was returned
+	JOB_LINE_WAITING, // No line for now, the next ones aren't written yet
+	JOB_LINE_END // Every line was returned
+};
+
+/// <summary>
+/// Lines of a job file, or of the standard input, read on a thread so rank 0 keeps handing out the chunks
+/// of the jobs already read while a script is still writing the next ones.
+/// The empty lines and the lines starting with # are ignored.
+/// </summary>
+class JobReader
+{
+private:
+	/// <summary>
+	/// Job file, unused for the standard input
+	/// </summary>
+	std::ifstream file;
+
+	/// <summary>
+	/// Thread reading the lines
+	/// </summary>
+	std::thread thread;
+
+	/// <summary>
+	/// Protects lines and ended, shared with the thread
+	/// </summary>
+	std::mutex mutex;
+
+	/// <summary>
+	/// Notified when a line is read or the end of the file is reached
+	/// </summary>
+	std::condition_variable lineRead;
+
+	/// <summary>
+	/// Lines read and not returned yet, with their line number
+	/// </summary>
+	std::deque<std::pair<int, std::string>> lines;
+
+	/// <summary>
+	/// Whether the end of the file was read
+	/// </summary>
+	bool ended = false;
+public:
+	~JobReader();
+	void Open(const std::string&);
+	JobLineStatus TryNext(int*, std::string*);
+	void WaitForLine();
+};
+
+batchJob ParseBatchJob(const std::string&);
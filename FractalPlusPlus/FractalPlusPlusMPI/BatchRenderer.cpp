@@ -0,0 +1,320 @@
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <list>
+#include <stdexcept>
+#include <mpi.h>
+
+#include "BatchRenderer.h"
+#include "Batch.h"
+#include "Schedules.h"
+
+
+/// <summary>
+/// Chunk of a job of the batch handed out by rank 0, with the job so the rank can calculate it without knowing the job file
+/// </summary>
+typedef struct batchChunk {
+	int job; // Index of the job in the job file
+	int firstRow;
+	int rowCount; // 0 when there is no more work
+	int width;
+	int height;
+	int maxIteration;
+	double minRangeX;
+	double maxRangeX;
+	double minRangeY;
+	double maxRangeY;
+} batchChunk;
+
+/// <summary>
+/// Job of the batch being calculated by the ranks, assembled by rank 0
+/// </summary>
+typedef struct batchFrame {
+	int index;
+	int line; // Line of the job in the job file, to report its failure
+	batchJob job;
+	std::vector<float> iterations; // Smooth iteration counts of the image, filled chunk by chunk
+	int nextRow; // First row not handed out yet
+	int rowsLeft; // Rows not calculated yet
+} batchFrame;
+
+static void RunBatchMaster(FractalRenderer&, int, rankStatistics*, int*, int*, const std::string&);
+static void RunBatchWorker(FractalRenderer&, rankStatistics*);
+static void SetBatchChunk(FractalRenderer&, const batchChunk&);
+static void SaveBatchJob(FractalRenderer&, const batchFrame&);
+
+/// <summary>
+/// Render the jobs of path in one run, each one saved as a BMP file as soon as its last row is calculated.
+/// Like the animations, the jobs are calculated by chunks of rows with the dynamic schedule, rank 0 starting the next job
+/// as soon as every chunk of the current ones is handed out, so the ranks never wait for the end of a job.
+/// The jobs are calculated in double precision, without the perturbation. A job which can't be read or saved is reported
+/// and the next ones are still rendered.
+/// </summary>
+/// <param name="renderer">renderer calculating the jobs</param>
+/// <param name="rank">rank of the current process</param>
+/// <param name="numtasks">number of MPI ranks</param>
+/// <param name="path">job file of the batch, - for the standard input</param>
+/// <returns>on rank 0, false if a job failed</returns>
+bool RenderBatch(FractalRenderer& renderer, int rank, int numtasks, const std::string& path)
+{
+	renderer.engine = GetFractalEngine(renderer.fractal);
+	SetFormulaKernel(renderer.engine.escapeTimeRow);
+	SetPrecision(PRECISION_DOUBLE);
+	renderer.phaseTrace.NextFrame();
+
+	// Every job is calculated at full resolution in one pass
+	renderer.referenceReal.clear();
+	renderer.referenceImag.clear();
+	renderer.passStep = 1;
+	renderer.passReuse = false;
+
+	double startTime = MPI_Wtime();
+	if (rank == 0) {
+		std::cout << "Calculating the jobs of " << (path == "-" ? "the standard input" : path) << " with the " << GetKernelName() << " kernel and "
+			<< renderer.threadPool->GetThreadCount() << " threads per rank" << std::endl;
+		std::cout << "--------------------------------------------------" << std::endl;
+	}
+
+	rankStatistics statistics = { 0, 0, 0, 0, 0 };
+	int savedJobs = 0;
+	int failedJobs = 0;
+	renderer.kernelIterations = 0;
+	if (rank == 0) {
+		RunBatchMaster(renderer, numtasks, &statistics, &savedJobs, &failedJobs, path);
+	}
+	else {
+		RunBatchWorker(renderer, &statistics);
+	}
+	statistics.iterations = (double)renderer.kernelIterations;
+	ReportStatistics(renderer, rank, numtasks, statistics);
+
+	if (rank == 0) {
+		double seconds = MPI_Wtime() - startTime;
+		std::cout << savedJobs << " jobs saved and " << failedJobs << " failed in " << seconds << " s (" << savedJobs / seconds << " jobs per second)" << std::endl;
+	}
+	return failedJobs == 0;
+}
+
+/// <summary>
+/// Rank 0's side of the batch, the dynamic schedule of RunAnimationMaster over the chunks of the jobs.
+/// The jobs are read from the job file as the ranks need work, a rank asking for work while the next job isn't written yet
+/// waits until it is.
+/// </summary>
+/// <param name="renderer">renderer calculating the jobs</param>
+/// <param name="numtasks">number of MPI ranks</param>
+/// <param name="statistics">work done by rank 0</param>
+/// <param name="savedJobs">filled with the number of jobs saved</param>
+/// <param name="failedJobs">filled with the number of jobs which couldn't be read or saved</param>
+/// <param name="path">job file of the batch, - for the standard input</param>
+static void RunBatchMaster(FractalRenderer& renderer, int numtasks, rankStatistics* statistics, int* savedJobs, int* failedJobs, const std::string& path)
+{
+	JobReader reader;
+	reader.Open(path);
+	bool jobsEnded = false;
+	int nextJob = 0;
+
+	// Jobs being calculated, a job starts only when every chunk of the others is handed out
+	std::list<batchFrame> frames;
+	std::vector<int> waitingWorkers;
+	int activeWorkers = numtasks - 1;
+	bool computes = renderer.RankZeroComputes(numtasks);
+
+	// Find the next chunk to calculate, reading a new job if needed. chunk->rowCount stays 0 when there is none
+	auto takeChunk = [&](batchChunk* chunk) {
+		*chunk = {};
+		auto frame = std::find_if(frames.begin(), frames.end(), [](const batchFrame& f) { return f.nextRow < f.job.height; });
+		while (frame == frames.end()) {
+			int lineNumber;
+			std::string line;
+			JobLineStatus status = reader.TryNext(&lineNumber, &line);
+			if (status != JOB_LINE_READ) {
+				jobsEnded = status == JOB_LINE_END;
+				return false;
+			}
+			try {
+				batchJob job = ParseBatchJob(line);
+				frames.push_back({ nextJob, lineNumber, job, std::vector<float>((size_t)job.width * job.height), 0, job.height });
+				frame = std::prev(frames.end());
+			}
+			catch (const std::exception& e) {
+				std::cerr << "Job of line " << lineNumber << " failed : " << e.what() << std::endl;
+				(*failedJobs)++;
+			}
+			nextJob++;
+		}
+		const batchJob& job = frame->job;
+		*chunk = { frame->index, frame->nextRow, std::min(renderer.chunkRows, job.height - frame->nextRow), job.width, job.height, job.maxIteration,
+			job.minRangeX, job.maxRangeX, job.minRangeY, job.maxRangeY };
+		frame->nextRow += chunk->rowCount;
+		return true;
+	};
+	auto findFrame = [&](int index) {
+		return std::find_if(frames.begin(), frames.end(), [index](const batchFrame& f) { return f.index == index; });
+	};
+	// Save the job once its last rows are calculated
+	auto chunkDone = [&](std::list<batchFrame>::iterator frame, int rowCount) {
+		frame->rowsLeft -= rowCount;
+		if (frame->rowsLeft == 0) {
+			try {
+				SaveBatchJob(renderer, *frame);
+				(*savedJobs)++;
+			}
+			catch (const std::exception& e) {
+				std::cerr << "Job of line " << frame->line << " failed : " << e.what() << std::endl;
+				(*failedJobs)++;
+			}
+			frames.erase(frame);
+		}
+	};
+
+	while (!jobsEnded || !frames.empty() || activeWorkers > 0) {
+		bool busy = false;
+
+		// Take the finished chunks, each rank then waits for its next chunk
+		int pending = 0;
+		MPI_Status status;
+		MPI_Iprobe(MPI_ANY_SOURCE, TAG_RESULT, MPI_COMM_WORLD, &pending, &status);
+		while (pending) {
+			int worker = status.MPI_SOURCE;
+			int result[3];
+			double traceStart = renderer.phaseTrace.Now();
+			MPI_Recv(result, 3, MPI_INT, worker, TAG_RESULT, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+			if (result[2] > 0) {
+				auto frame = findFrame(result[0]);
+				MPI_Recv(frame->iterations.data() + (size_t)result[1] * frame->job.width, result[2] * frame->job.width, MPI_FLOAT, worker, TAG_CHUNK_PIXELS, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+				renderer.phaseTrace.Add(PHASE_RECEIVE, traceStart, (double)result[2] * frame->job.width);
+				chunkDone(frame, result[2]);
+			}
+			waitingWorkers.push_back(worker);
+			busy = true;
+			MPI_Iprobe(MPI_ANY_SOURCE, TAG_RESULT, MPI_COMM_WORLD, &pending, &status);
+		}
+
+		// Answer the ranks waiting for work, unless the next job isn't written yet
+		while (!waitingWorkers.empty()) {
+			batchChunk chunk;
+			if (!takeChunk(&chunk) && !jobsEnded) {
+				break;
+			}
+			if (chunk.rowCount == 0) {
+				activeWorkers--; // No more work
+			}
+			MPI_Send(&chunk, sizeof(chunk), MPI_BYTE, waitingWorkers.back(), TAG_WORK, MPI_COMM_WORLD);
+			waitingWorkers.pop_back();
+			busy = true;
+		}
+
+		// Calculate one chunk of rank 0's own share
+		batchChunk chunk;
+		if (computes && takeChunk(&chunk)) {
+			auto frame = findFrame(chunk.job);
+			SetBatchChunk(renderer, chunk);
+			double startTime = MPI_Wtime();
+			double traceStart = renderer.phaseTrace.Now();
+			long long previousIterations = renderer.kernelIterations;
+			renderer.ComputePixels(chunk.firstRow * chunk.width, chunk.rowCount * chunk.width, frame->iterations.data() + (size_t)chunk.firstRow * chunk.width);
+			statistics->busyTime += MPI_Wtime() - startTime;
+			statistics->chunks++;
+			statistics->pixels += (double)chunk.rowCount * chunk.width;
+			statistics->iteratedPixels += (double)chunk.rowCount * chunk.width;
+			renderer.phaseTrace.Add(PHASE_COMPUTE, traceStart, (double)(renderer.kernelIterations - previousIterations));
+			chunkDone(frame, chunk.rowCount);
+			busy = true;
+		}
+
+		if (!busy && activeWorkers > (int)waitingWorkers.size()) {
+			// Waiting for the chunks of the other ranks, a job read meanwhile is started when one arrives
+			MPI_Probe(MPI_ANY_SOURCE, TAG_RESULT, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+		}
+		else if (!busy && !jobsEnded) {
+			// Every rank waits for the next job
+			reader.WaitForLine();
+		}
+	}
+}
+
+/// <summary>
+/// Worker's side of the batch, like RunAnimationWorker with the job of each chunk sent with it
+/// </summary>
+/// <param name="renderer">renderer calculating the jobs</param>
+/// <param name="statistics">work done by the rank</param>
+static void RunBatchWorker(FractalRenderer& renderer, rankStatistics* statistics)
+{
+	std::vector<float> chunkIterations;
+	int result[3] = { 0, 0, 0 };
+
+	while (true) {
+		double traceStart = renderer.phaseTrace.Now();
+		MPI_Send(result, 3, MPI_INT, 0, TAG_RESULT, MPI_COMM_WORLD);
+		if (result[2] > 0) {
+			MPI_Send(chunkIterations.data(), (int)chunkIterations.size(), MPI_FLOAT, 0, TAG_CHUNK_PIXELS, MPI_COMM_WORLD);
+		}
+		renderer.phaseTrace.Add(PHASE_SEND, traceStart, (double)chunkIterations.size());
+
+		batchChunk chunk;
+		traceStart = renderer.phaseTrace.Now();
+		MPI_Recv(&chunk, sizeof(chunk), MPI_BYTE, 0, TAG_WORK, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+		renderer.phaseTrace.Add(PHASE_RECEIVE, traceStart, 1);
+		if (chunk.rowCount == 0) {
+			break; // No more work
+		}
+
+		SetBatchChunk(renderer, chunk);
+		chunkIterations.resize((size_t)chunk.rowCount * chunk.width);
+		double startTime = MPI_Wtime();
+		traceStart = renderer.phaseTrace.Now();
+		long long previousIterations = renderer.kernelIterations;
+		renderer.ComputePixels(chunk.firstRow * chunk.width, chunk.rowCount * chunk.width, chunkIterations.data());
+		statistics->busyTime += MPI_Wtime() - startTime;
+		statistics->chunks++;
+		statistics->pixels += (double)chunk.rowCount * chunk.width;
+		statistics->iteratedPixels += (double)chunk.rowCount * chunk.width;
+		renderer.phaseTrace.Add(PHASE_COMPUTE, traceStart, (double)(renderer.kernelIterations - previousIterations));
+
+		result[0] = chunk.job;
+		result[1] = chunk.firstRow;
+		result[2] = chunk.rowCount;
+	}
+}
+
+/// <summary>
+/// Set the size, area and iterations of the current frame to the ones of the job of a chunk
+/// </summary>
+/// <param name="renderer">renderer calculating the jobs</param>
+/// <param name="chunk">chunk of the batch</param>
+static void SetBatchChunk(FractalRenderer& renderer, const batchChunk& chunk)
+{
+	renderer.pixelWidth = renderer.passWidth = chunk.width;
+	renderer.pixelHeight = renderer.passHeight = chunk.height;
+	renderer.maxIteration = chunk.maxIteration;
+	renderer.minRangeX = chunk.minRangeX;
+	renderer.maxRangeX = chunk.maxRangeX;
+	renderer.minRangeY = chunk.minRangeY;
+	renderer.maxRangeY = chunk.maxRangeY;
+	renderer.rangeWidth = renderer.maxRangeX - renderer.minRangeX;
+	renderer.rangeHeight = renderer.maxRangeY - renderer.minRangeY;
+}
+
+/// <summary>
+/// Color a finished job of the batch and save it, creating the directories of its path
+/// </summary>
+/// <param name="renderer">renderer calculating the jobs</param>
+/// <param name="frame">job whose rows are all calculated</param>
+static void SaveBatchJob(FractalRenderer& renderer, const batchFrame& frame)
+{
+	double traceStart = renderer.phaseTrace.Now();
+	renderer.framebuffer.resize(frame.iterations.size());
+	Colorize(frame.iterations.data(), frame.iterations.size(), frame.job.maxIteration, renderer.palette, (unsigned char*)renderer.framebuffer.data());
+	renderer.phaseTrace.Add(PHASE_ENCODE, traceStart, (double)frame.iterations.size());
+
+	traceStart = renderer.phaseTrace.Now();
+	std::filesystem::path directory = std::filesystem::path(frame.job.output).parent_path();
+	if (!directory.empty()) {
+		std::filesystem::create_directories(directory);
+	}
+	if (!SaveBitmap(renderer.framebuffer.data(), frame.job.width, frame.job.height, frame.job.output)) {
+		throw std::runtime_error("Unable to write " + frame.job.output);
+	}
+	renderer.phaseTrace.Add(PHASE_WRITE, traceStart, (double)frame.iterations.size());
+	std::cout << "Job of line " << frame.line << " saved in " << frame.job.output << std::endl;
+}
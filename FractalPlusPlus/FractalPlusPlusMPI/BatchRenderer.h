@@ -0,0 +1,6 @@
+#pragma once
+#include <string>
+
+#include "FractalRenderer.h"
+
+bool RenderBatch(FractalRenderer&, int, int, const std::string&);
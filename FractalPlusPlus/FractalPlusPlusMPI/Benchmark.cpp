@@ -0,0 +1,442 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <mpi.h>
+
+#include "Benchmark.h"
+
+
+/// <summary>
+/// Result of one benchmark, a row of the CSV file or a line of the JSON file written by --benchmark
+/// </summary>
+typedef struct benchmarkResult {
+	std::string suite; // micro, frame, strong-scaling or weak-scaling
+	std::string name;
+	std::string kernel;
+	int threads; // Threads per rank
+	int width; // Size of the image, 0 for the micro-benchmarks
+	int height;
+	int maxIteration; // 0 for Complex::NextIteration
+	double seconds; // Time of the fastest run
+	double pixels;
+	double iterations;
+} benchmarkResult;
+
+static void RunMicroBenchmarks(FractalRenderer&, std::vector<benchmarkResult>&, const benchmarkOptions&);
+static bool RunPrecisionBenchmarks(FractalRenderer&, int, int, std::vector<benchmarkResult>&, const benchmarkOptions&);
+static bool RunInteriorBenchmarks(FractalRenderer&, int, int, std::vector<benchmarkResult>&, const benchmarkOptions&);
+static bool CheckIterations(const FractalRenderer&, const std::vector<float>&, float, double, double, const std::string&);
+static bool CheckIdenticalIterations(const FractalRenderer&, const std::vector<float>&, const std::string&);
+static benchmarkResult BenchmarkFrame(FractalRenderer&, int, int, const std::string&, const std::string&, int, int, const char* const[4], const benchmarkOptions&);
+static double TimeFastestRun(const std::function<void()>&, int);
+static void WriteBenchmarkResults(const std::vector<benchmarkResult>&, int, const std::string&);
+
+/// <summary>
+/// Run the benchmarks selected by --benchmark-suites and append their results to the file of options :
+/// micro-benchmarks of the iteration, of the kernel and of the coloring on rank 0,
+/// full frames of fixed viewports with every rank, each precision against the next one, the interior checks against iterating every pixel,
+/// and the frames with 1 thread per rank up to the default number of threads, at a fixed size (strong scaling)
+/// and at a size growing with the number of threads (weak scaling).
+/// Running the program with 1 to N ranks, like benchmark_linux.sh does, gives the scaling with the ranks.
+/// </summary>
+/// <param name="renderer">renderer calculating the frames</param>
+/// <param name="rank">rank of the current process</param>
+/// <param name="numtasks">number of MPI ranks</param>
+/// <param name="options">file and runs of --benchmark</param>
+/// <returns>on rank 0, false if a precision differs too much from the next one or an interior check changes the image</returns>
+bool RunBenchmark(FractalRenderer& renderer, int rank, int numtasks, const benchmarkOptions& options)
+{
+	// Area of the complex plane of each frame, with the range of the X axis then of the Y axis of a 16:9 image
+	constexpr int frameCount = 4;
+	const char* const frameNames[frameCount] = { "default", "report-zoom", "seahorse-valley", "all-interior" };
+	const char* const frameRanges[frameCount][4] = {
+		{ "-2", "2", "-1.125", "1.125" }, // The two viewports of the report
+		{ "-1.828", "-1.64", "-0.057", "0.049" },
+		{ "-0.775", "-0.725", "0.0859375", "0.1140625" },
+		{ "-0.3", "0.1", "-0.1125", "0.1125" } // Inside the main cardioid, the worst case without --interior-checks
+	};
+	auto hasSuite = [&](const std::string& suite) { return ("," + options.suites + ",").find("," + suite + ",") != std::string::npos; };
+
+	// Every run of a frame must calculate it
+	renderer.saveFrames = false;
+	if (rank == 0) {
+		renderer.tileCache.Configure(cacheTileSize, 0, "");
+	}
+
+	std::vector<benchmarkResult> results;
+	bool passed = true;
+	if (rank == 0 && hasSuite("micro")) {
+		RunMicroBenchmarks(renderer, results, options);
+	}
+
+	if (hasSuite("frames")) {
+		for (int frame = 0; frame < frameCount; frame++) {
+			results.push_back(BenchmarkFrame(renderer, rank, numtasks, "frame", frameNames[frame], 1920, 1080, frameRanges[frame], options));
+		}
+	}
+
+	if (hasSuite("precision")) {
+		passed = RunPrecisionBenchmarks(renderer, rank, numtasks, results, options) && passed;
+	}
+
+	if (hasSuite("interior")) {
+		passed = RunInteriorBenchmarks(renderer, rank, numtasks, results, options) && passed;
+	}
+
+	if (hasSuite("scaling")) {
+		int defaultThreads = renderer.threadPool->GetThreadCount();
+		for (int threads = 1; threads <= defaultThreads; threads = threads == defaultThreads || threads * 2 < defaultThreads ? threads * 2 : defaultThreads) {
+			renderer.StartThreads(threads);
+
+			// Strong scaling : the same image for every number of workers
+			results.push_back(BenchmarkFrame(renderer, rank, numtasks, "strong-scaling", frameNames[0], 1920, 1080, frameRanges[0], options));
+
+			// Weak scaling : 960 * 540 pixels per thread of every rank
+			double scale = sqrt((double)threads * numtasks);
+			results.push_back(BenchmarkFrame(renderer, rank, numtasks, "weak-scaling", frameNames[0], (int)(960 * scale), (int)(540 * scale), frameRanges[0], options));
+		}
+		renderer.StartThreads(defaultThreads);
+	}
+
+	if (rank == 0) {
+		WriteBenchmarkResults(results, numtasks, options.path);
+	}
+	return passed;
+}
+
+/// <summary>
+/// Benchmark the parts of the calculation of a pixel on rank 0 alone, with one thread :
+/// Complex::NextIteration, each version of the kernel supported by the CPU, GetSmoothIteration and each palette
+/// </summary>
+/// <param name="renderer">renderer calculating the frames</param>
+/// <param name="results">filled with the result of each micro-benchmark</param>
+/// <param name="options">file and runs of --benchmark</param>
+static void RunMicroBenchmarks(FractalRenderer& renderer, std::vector<benchmarkResult>& results, const benchmarkOptions& options)
+{
+	// Written at the end of the loop so the compiler can't remove it
+	[[maybe_unused]] static volatile double sink;
+
+	// The sequence of a point inside the main cardioid never diverges
+	constexpr int sequenceIterations = 1 << 24;
+	double seconds = TimeFastestRun([&]() {
+		Complex c(-0.1, 0.1);
+		Complex z;
+		for (int i = 0; i < sequenceIterations; i++) {
+			z = z.NextIteration(c);
+		}
+		sink = z.ModulusSquared();
+	}, options.repeat);
+	results.push_back({ "micro", "next-iteration", "scalar", 1, 0, 0, 0, seconds, 0, (double)sequenceIterations });
+
+	// One row out of 8 of the seahorse valley in 1920x1080 pixels, where few pixels are inside the set
+	constexpr int rowStep = 8;
+	viewport view = { 1920, 1080, -0.775, -0.725, 0.0859375, 0.1140625, nullptr, 1, 0, 0 };
+	int rows = view.pixelHeight / rowStep;
+	std::vector<int> iterations((size_t)rows * view.pixelWidth);
+	std::vector<double> modulusSquared(iterations.size());
+	KernelType kernel = GetKernel();
+	SetFormulaKernel(nullptr);
+	for (PrecisionType precision : { PRECISION_FLOAT, PRECISION_DOUBLE }) {
+		SetPrecision(precision);
+		for (KernelType rowKernel : { KERNEL_SCALAR, KERNEL_AVX2, KERNEL_AVX512 }) {
+			if (!SetKernel(rowKernel)) {
+				continue; // Not supported by the CPU
+			}
+			seconds = TimeFastestRun([&]() {
+				for (int row = 0; row < rows; row++) {
+					for (int column = 0; column < view.pixelWidth; column += taskPixels) {
+						size_t first = (size_t)row * view.pixelWidth + column;
+						EscapeTimeRow(view, row * rowStep, column, std::min(taskPixels, view.pixelWidth - column), renderer.maxIteration, &iterations[first], &modulusSquared[first]);
+					}
+				}
+			}, options.repeat);
+			double rowIterations = 0;
+			for (int count : iterations) {
+				rowIterations += count;
+			}
+			results.push_back({ "micro", "escape-time-row", std::string(GetKernelName()) + " " + GetPrecisionName(precision), 1, view.pixelWidth, rows, renderer.maxIteration, seconds,
+				(double)iterations.size(), rowIterations });
+		}
+	}
+	SetKernel(kernel);
+
+	// Coloring of the pixels calculated by the kernel
+	renderer.engine = GetFractalEngine(renderer.fractal);
+	std::vector<float> smoothIterations(iterations.size());
+	seconds = TimeFastestRun([&]() {
+		for (size_t i = 0; i < iterations.size(); i++) {
+			smoothIterations[i] = renderer.GetSmoothIteration(iterations[i], modulusSquared[i]);
+		}
+	}, options.repeat);
+	results.push_back({ "micro", "smooth-iteration", "scalar", 1, view.pixelWidth, rows, renderer.maxIteration, seconds, (double)iterations.size(), 0 });
+
+	std::vector<color> pixels(iterations.size());
+	for (int i = 0; i < (int)PALETTE_COUNT; i++) {
+		seconds = TimeFastestRun([&]() {
+			Colorize(smoothIterations.data(), smoothIterations.size(), renderer.maxIteration, (PaletteType)i, (unsigned char*)pixels.data());
+		}, options.repeat);
+		results.push_back({ "micro", std::string("colorize-") + GetPaletteName((PaletteType)i), "scalar", 1, view.pixelWidth, rows, renderer.maxIteration, seconds, (double)pixels.size(), 0 });
+	}
+}
+
+/// <summary>
+/// Render each precision and the next one on a frame where PRECISION_AUTO chooses the lower one, the perturbation being the last one,
+/// and check that the lower one is close enough to the higher one. The rounding errors change the iteration count of a few pixels
+/// on the edge of the set, so each comparison accepts a share of the pixels differing by more than 1 iteration.
+/// </summary>
+/// <param name="renderer">renderer calculating the frames</param>
+/// <param name="rank">rank of the current process</param>
+/// <param name="numtasks">number of MPI ranks</param>
+/// <param name="results">filled with the time of each precision</param>
+/// <param name="options">file and runs of --benchmark</param>
+/// <returns>on rank 0, false if a precision differs too much from the next one</returns>
+static bool RunPrecisionBenchmarks(FractalRenderer& renderer, int rank, int numtasks, std::vector<benchmarkResult>& results, const benchmarkOptions& options)
+{
+	// Difference of smooth iteration count under which two pixels are considered the same
+	constexpr float tolerance = 1;
+	constexpr int comparisonCount = 3;
+	const char* const frameNames[comparisonCount] = { "default", "seahorse-valley", "deep-seahorse" };
+	const char* const frameRanges[comparisonCount][4] = {
+		{ "-2", "2", "-1.125", "1.125" },
+		{ "-0.775", "-0.725", "0.0859375", "0.1140625" },
+		{ "-0.743643887042158704752191506114774", "-0.743643887032158704752191506114774", "0.131825904202499470493132056385139", "0.131825904208124470493132056385139" }
+	};
+	// The pixels of the deep frame need about 2000 iterations to escape
+	const int frameIterations[comparisonCount] = { 1000, 1000, 5000 };
+	// Largest share of the pixels differing by more than tolerance. These are regression bounds rather than error bounds: they are about
+	// twice the 0.25 %, 0.034 % and 0.14 % measured with every kernel on these 480x270 frames with 1000, 1000 and 5000 iterations,
+	// and must be measured again if a frame, its size or its iterations change
+	const double maxDifferentShares[comparisonCount] = { 0.005, 0.001, 0.005 };
+	const PrecisionType precisions[comparisonCount + 1] = { PRECISION_FLOAT, PRECISION_DOUBLE, PRECISION_DOUBLE_DOUBLE, PRECISION_AUTO };
+
+	PrecisionType savedPrecisionMode = renderer.precisionMode;
+	PerturbationMode savedPerturbationMode = renderer.perturbationMode;
+	int savedMaxIteration = renderer.maxIteration;
+	bool passed = true;
+	for (int comparison = 0; comparison < comparisonCount; comparison++) {
+		renderer.maxIteration = frameIterations[comparison];
+		std::vector<float> lowerIterations;
+		for (int i = 0; i < 2; i++) {
+			// PRECISION_AUTO is the perturbation, the deep frame being too deep for a double
+			renderer.precisionMode = precisions[comparison + i];
+			renderer.perturbationMode = renderer.precisionMode == PRECISION_AUTO ? PERTURBATION_ON : PERTURBATION_OFF;
+			results.push_back(BenchmarkFrame(renderer, rank, numtasks, "precision", frameNames[comparison], 480, 270, frameRanges[comparison], options));
+			if (i == 0) {
+				lowerIterations = renderer.iterationBuffer;
+			}
+		}
+
+		if (rank == 0) {
+			std::string higherName = precisions[comparison + 1] == PRECISION_AUTO ? "perturbation" : GetPrecisionName(precisions[comparison + 1]);
+			// A frame almost entirely inside the set would compare nothing
+			passed = CheckIterations(renderer, lowerIterations, tolerance, maxDifferentShares[comparison], 0.25,
+				std::string(GetPrecisionName(precisions[comparison])) + " against " + higherName + " on " + frameNames[comparison]) && passed;
+		}
+	}
+	renderer.precisionMode = savedPrecisionMode;
+	renderer.perturbationMode = savedPerturbationMode;
+	renderer.maxIteration = savedMaxIteration;
+	return passed;
+}
+
+/// <summary>
+/// Render frames on the edge of the main cardioid and of the bulbs with each interior check and without them,
+/// and check that the interior checks give exactly the same iteration buffer, since the pixels they find can't diverge
+/// </summary>
+/// <param name="renderer">renderer calculating the frames</param>
+/// <param name="rank">rank of the current process</param>
+/// <param name="numtasks">number of MPI ranks</param>
+/// <param name="results">filled with the time of each interior check</param>
+/// <param name="options">file and runs of --benchmark</param>
+/// <returns>on rank 0, false if an interior check changes the image</returns>
+static bool RunInteriorBenchmarks(FractalRenderer& renderer, int rank, int numtasks, std::vector<benchmarkResult>& results, const benchmarkOptions& options)
+{
+	constexpr int frameCount = 5;
+	const char* const frameNames[frameCount] = { "default", "seahorse-valley", "cardioid-cusp", "period-2-bulb", "period-3-bulb" };
+	const char* const frameRanges[frameCount][4] = {
+		{ "-2", "2", "-1.125", "1.125" },
+		{ "-0.775", "-0.725", "0.0859375", "0.1140625" }, // Between the main cardioid and the period-2 bulb
+		{ "0.2", "0.3", "-0.028125", "0.028125" },
+		{ "-1.3", "-1.2", "-0.028125", "0.028125" },
+		{ "-0.2", "-0.05", "0.6", "0.684375" }
+	};
+	const int interiorChecks[3] = { INTERIOR_CHECK_BULBS, INTERIOR_CHECK_PERIODICITY, INTERIOR_CHECK_ALL };
+	const char* const interiorCheckNames[3] = { "bulbs", "periodicity", "all" };
+
+	int savedInteriorChecks = GetInteriorChecks();
+	PrecisionType savedPrecisionMode = renderer.precisionMode;
+	bool passed = true;
+	// The kernels have a version of the checks for each precision, PRECISION_AUTO choosing float for these frames
+	for (PrecisionType precision : { PRECISION_FLOAT, PRECISION_DOUBLE }) {
+		renderer.precisionMode = precision;
+		for (int frame = 0; frame < frameCount; frame++) {
+			SetInteriorChecks(INTERIOR_CHECK_NONE);
+			results.push_back(BenchmarkFrame(renderer, rank, numtasks, "interior-none", frameNames[frame], 480, 270, frameRanges[frame], options));
+			std::vector<float> iteratedIterations = renderer.iterationBuffer;
+			for (int i = 0; i < 3; i++) {
+				SetInteriorChecks(interiorChecks[i]);
+				results.push_back(BenchmarkFrame(renderer, rank, numtasks, std::string("interior-") + interiorCheckNames[i], frameNames[frame], 480, 270, frameRanges[frame], options));
+				if (rank == 0) {
+					passed = CheckIdenticalIterations(renderer, iteratedIterations, std::string("--interior-checks ") + interiorCheckNames[i] + " against none on "
+						+ frameNames[frame] + " in " + GetPrecisionName(precision)) && passed;
+				}
+			}
+		}
+	}
+	SetInteriorChecks(savedInteriorChecks);
+	renderer.precisionMode = savedPrecisionMode;
+	return passed;
+}
+
+/// <summary>
+/// Compare the smooth iteration counts of the last frame with the ones of another calculation of the same frame, on rank 0
+/// </summary>
+/// <param name="renderer">renderer calculating the frames</param>
+/// <param name="otherIterations">smooth iteration counts of the other calculation</param>
+/// <param name="tolerance">difference of smooth iteration count under which two pixels are considered the same</param>
+/// <param name="maxDifferentShare">largest share of the pixels allowed to differ by more than tolerance</param>
+/// <param name="minEscapedShare">smallest share of the pixels of the frame which must escape</param>
+/// <param name="description">calculations compared, displayed with the result</param>
+/// <returns>true if few enough pixels differ</returns>
+static bool CheckIterations(const FractalRenderer& renderer, const std::vector<float>& otherIterations, float tolerance, double maxDifferentShare, double minEscapedShare, const std::string& description)
+{
+	long long differentPixels = 0;
+	long long escapedPixels = 0;
+	double differences = 0;
+	for (size_t i = 0; i < renderer.iterationBuffer.size(); i++) {
+		bool otherInterior = otherIterations[i] == interiorIteration;
+		bool interior = renderer.iterationBuffer[i] == interiorIteration;
+		double difference = otherInterior || interior ? (otherInterior == interior ? 0 : renderer.maxIteration) : fabs(otherIterations[i] - renderer.iterationBuffer[i]);
+		differentPixels += difference > tolerance;
+		escapedPixels += !interior;
+		differences += difference;
+	}
+	double differentShare = (double)differentPixels / renderer.iterationBuffer.size();
+	double escapedShare = (double)escapedPixels / renderer.iterationBuffer.size();
+	bool passed = differentShare <= maxDifferentShare && escapedShare >= minEscapedShare;
+	std::cout << description << " : " << 100 * differentShare << " % of the pixels differ by more than " << tolerance << " iteration (at most "
+		<< 100 * maxDifferentShare << " %), mean difference " << differences / renderer.iterationBuffer.size() << ", " << 100 * escapedShare
+		<< " % of the pixels escape (at least " << 100 * minEscapedShare << " %) : " << (passed ? "OK" : "FAILED") << std::endl;
+	return passed;
+}
+
+/// <summary>
+/// Check that the smooth iteration counts of the last frame are exactly the ones of another calculation of the same frame, on rank 0
+/// </summary>
+/// <param name="renderer">renderer calculating the frames</param>
+/// <param name="otherIterations">smooth iteration counts of the other calculation</param>
+/// <param name="description">calculations compared, displayed with the result</param>
+/// <returns>true if every pixel is identical</returns>
+static bool CheckIdenticalIterations(const FractalRenderer& renderer, const std::vector<float>& otherIterations, const std::string& description)
+{
+	auto difference = std::mismatch(renderer.iterationBuffer.begin(), renderer.iterationBuffer.end(), otherIterations.begin(), otherIterations.end());
+	bool passed = difference.first == renderer.iterationBuffer.end() && difference.second == otherIterations.end();
+	std::cout << description << " : ";
+	if (passed) {
+		std::cout << "every pixel identical";
+	}
+	else if (renderer.iterationBuffer.size() != otherIterations.size()) {
+		std::cout << renderer.iterationBuffer.size() << " pixels against " << otherIterations.size();
+	}
+	else {
+		size_t pixel = difference.first - renderer.iterationBuffer.begin();
+		std::cout << "pixel (" << pixel % renderer.pixelWidth << ", " << pixel / renderer.pixelWidth << ") is " << *difference.first << " instead of " << *difference.second;
+	}
+	std::cout << " : " << (passed ? "OK" : "FAILED") << std::endl;
+	return passed;
+}
+
+/// <summary>
+/// Render a frame options.repeat times with every rank and keep the fastest run
+/// </summary>
+/// <param name="renderer">renderer calculating the frames</param>
+/// <param name="rank">rank of the current process</param>
+/// <param name="numtasks">number of MPI ranks</param>
+/// <param name="suite">suite of the benchmark</param>
+/// <param name="name">name of the viewport</param>
+/// <param name="width">width of the image</param>
+/// <param name="height">height of the image</param>
+/// <param name="ranges">minRangeX, maxRangeX, minRangeY and maxRangeY</param>
+/// <param name="options">file and runs of --benchmark</param>
+/// <returns>result of the benchmark, only meaningful on rank 0</returns>
+static benchmarkResult BenchmarkFrame(FractalRenderer& renderer, int rank, int numtasks, const std::string& suite, const std::string& name, int width, int height, const char* const ranges[4], const benchmarkOptions& options)
+{
+	renderer.pixelWidth = width;
+	renderer.pixelHeight = height;
+	renderer.SetViewport(ranges[0], ranges[1], ranges[2], ranges[3]);
+
+	double seconds = TimeFastestRun([&]() {
+		renderer.RenderFrame(rank, numtasks, nullptr);
+	}, options.repeat);
+	std::string kernel = renderer.referenceReal.empty() ? std::string(GetKernelName()) + " " + GetPrecisionName(GetPrecision()) : "perturbation";
+	return { suite, name, kernel, renderer.threadPool->GetThreadCount(), width, height, renderer.maxIteration, seconds, (double)width * height, renderer.frameStatistics.iterations };
+}
+
+/// <summary>
+/// Run a benchmark several times with every rank, each run starting and ending at the same time on every rank
+/// </summary>
+/// <param name="run">benchmark to run, called by every rank</param>
+/// <param name="runs">number of runs</param>
+/// <returns>time of the fastest run in seconds</returns>
+static double TimeFastestRun(const std::function<void()>& run, int runs)
+{
+	double fastest = 0;
+	for (int repeat = 0; repeat < runs; repeat++) {
+		MPI_Barrier(MPI_COMM_WORLD);
+		double startTime = MPI_Wtime();
+		run();
+		MPI_Barrier(MPI_COMM_WORLD);
+		double seconds = MPI_Wtime() - startTime;
+		fastest = repeat == 0 ? seconds : std::min(fastest, seconds);
+	}
+	return fastest;
+}
+
+/// <summary>
+/// Append the results of the benchmarks to path, with the build and the computer so the files of several runs can be compared
+/// </summary>
+/// <param name="results">results of the benchmarks</param>
+/// <param name="numtasks">number of MPI ranks</param>
+/// <param name="path">file where the results are appended</param>
+static void WriteBenchmarkResults(const std::vector<benchmarkResult>& results, int numtasks, const std::string& path)
+{
+	char machine[MPI_MAX_PROCESSOR_NAME];
+	int machineLength;
+	MPI_Get_processor_name(machine, &machineLength);
+	const std::string build = __DATE__ " " __TIME__; // When Benchmark.cpp was compiled
+
+	bool json = path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+	std::ofstream file(path, std::ios::app);
+	if (!file) {
+		throw std::runtime_error("Unable to write the benchmark results in " + path);
+	}
+	file.precision(9);
+	if (!json && file.tellp() == 0) {
+		file << "build,machine,ranks,threads,kernel,suite,name,width,height,maxIteration,seconds,pixels,iterations,pixelsPerSecond,iterationsPerSecond" << std::endl;
+	}
+
+	for (const benchmarkResult& result : results) {
+		double pixelsPerSecond = result.pixels / result.seconds;
+		double iterationsPerSecond = result.iterations / result.seconds;
+		if (json) {
+			// One object per line, so the results of several runs can be appended to the same file
+			file << "{\"build\":\"" << build << "\",\"machine\":\"" << std::string(machine, machineLength) << "\",\"ranks\":" << numtasks
+				<< ",\"threads\":" << result.threads << ",\"kernel\":\"" << result.kernel << "\",\"suite\":\"" << result.suite
+				<< "\",\"name\":\"" << result.name << "\",\"width\":" << result.width << ",\"height\":" << result.height
+				<< ",\"maxIteration\":" << result.maxIteration << ",\"seconds\":" << result.seconds << ",\"pixels\":" << result.pixels
+				<< ",\"iterations\":" << result.iterations << ",\"pixelsPerSecond\":" << pixelsPerSecond
+				<< ",\"iterationsPerSecond\":" << iterationsPerSecond << "}" << std::endl;
+		}
+		else {
+			file << build << "," << std::string(machine, machineLength) << "," << numtasks << "," << result.threads << "," << result.kernel << ","
+				<< result.suite << "," << result.name << "," << result.width << "," << result.height << "," << result.maxIteration << ","
+				<< result.seconds << "," << result.pixels << "," << result.iterations << "," << pixelsPerSecond << "," << iterationsPerSecond << std::endl;
+		}
+		std::cout << result.suite << " " << result.name << " (" << result.kernel << ", " << result.threads << " threads) : " << result.seconds << " s, "
+			<< pixelsPerSecond << " pixels/s, " << iterationsPerSecond << " iterations/s" << std::endl;
+	}
+	std::cout << "Benchmark results appended to " << path << std::endl;
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include <string>
+
+#include "FractalRenderer.h"
+
+/// <summary>
+/// Benchmarks run by --benchmark
+/// </summary>
+typedef struct benchmarkOptions {
+	std::string path; // File where the results are appended, as JSON lines if it ends with .json, otherwise as CSV
+	int repeat = 3; // Number of runs of each benchmark, the fastest one is kept
+	std::string suites = "micro,frames,precision,interior,scaling"; // Comma-separated list of the suites to run
+} benchmarkOptions;
+
+bool RunBenchmark(FractalRenderer&, int, int, const benchmarkOptions&);
@@ -0,0 +1,355 @@
+#include <algorithm>
+#include <cmath>
+
+#include "BigFloat.h"
+
+
+/// <summary>
+/// Constructor of the number 0, with a fraction of 2 limbs
+/// </summary>
+BigFloat::BigFloat() : limbs(3, 0) {}
+
+/// <summary>
+/// Constructor from a double, all the bits of the double which fit in the precision are kept
+/// </summary>
+/// <param name="value">value, its absolute value must be lower than 2^32</param>
+/// <param name="fractionLimbs">number of 32 bits limbs of the fraction</param>
+BigFloat::BigFloat(double value, int fractionLimbs) : negative(value < 0), limbs(fractionLimbs + 1, 0)
+{
+	double magnitude = std::min(fabs(value), 4294967295.0);
+	double integer = floor(magnitude);
+	limbs[fractionLimbs] = (uint32_t)integer;
+	double fraction = magnitude - integer;
+	for (int i = fractionLimbs - 1; i >= 0 && fraction > 0; i--) {
+		fraction = ldexp(fraction, 32); // Exact, only the exponent changes
+		double limb = floor(fraction);
+		limbs[i] = (uint32_t)limb;
+		fraction -= limb;
+	}
+	negative = negative && !IsZero();
+}
+
+/// <summary>
+/// Read a number written in decimal, like -0.743643887037158704752191506114774 or 1.5e-40
+/// </summary>
+/// <param name="text">number in decimal, with an optional exponent</param>
+/// <param name="fractionLimbs">number of 32 bits limbs of the fraction</param>
+/// <param name="result">set to the number when the text is valid</param>
+/// <returns>false if the text isn't a number or its integer part doesn't fit in 32 bits</returns>
+bool BigFloat::Parse(const std::string& text, int fractionLimbs, BigFloat* result)
+{
+	size_t position = 0;
+	bool isNegative = false;
+	if (position < text.size() && (text[position] == '-' || text[position] == '+')) {
+		isNegative = text[position] == '-';
+		position++;
+	}
+
+	// Digits without the decimal point, and number of digits before it
+	std::string digits;
+	long long integerDigits = -1;
+	for (; position < text.size(); position++) {
+		if (text[position] == '.' && integerDigits < 0) {
+			integerDigits = (long long)digits.size();
+		}
+		else if (text[position] >= '0' && text[position] <= '9') {
+			digits += text[position];
+		}
+		else {
+			break;
+		}
+	}
+	if (digits.empty()) {
+		return false;
+	}
+	if (integerDigits < 0) {
+		integerDigits = (long long)digits.size();
+	}
+
+	if (position < text.size() && (text[position] == 'e' || text[position] == 'E')) {
+		position++;
+		bool negativeExponent = false;
+		if (position < text.size() && (text[position] == '-' || text[position] == '+')) {
+			negativeExponent = text[position] == '-';
+			position++;
+		}
+		long long exponent = 0;
+		size_t firstExponentDigit = position;
+		for (; position < text.size() && text[position] >= '0' && text[position] <= '9' && exponent < 1000000; position++) {
+			exponent = exponent * 10 + (text[position] - '0');
+		}
+		if (position == firstExponentDigit) {
+			return false;
+		}
+		integerDigits += negativeExponent ? -exponent : exponent;
+	}
+	if (position != text.size()) {
+		return false;
+	}
+
+	auto digitAt = [&](long long index) { return index >= 0 && index < (long long)digits.size() ? (uint64_t)(digits[index] - '0') : 0; };
+
+	BigFloat number;
+	number.limbs.assign(fractionLimbs + 1, 0);
+	uint64_t integer = 0;
+	for (long long i = 0; i < integerDigits; i++) {
+		integer = integer * 10 + digitAt(i);
+		if (integer > UINT32_MAX) {
+			return false;
+		}
+	}
+
+	// Fraction from its last digit to its first one : fraction = (digit + fraction) / 10.
+	// The digits further than the precision after the point don't change the result.
+	long long lastUsefulDigit = integerDigits + (long long)fractionLimbs * 10 + 10;
+	for (long long i = std::min((long long)digits.size(), lastUsefulDigit) - 1; i >= integerDigits; i--) {
+		number.limbs[fractionLimbs] = (uint32_t)digitAt(i);
+		uint64_t remainder = 0;
+		for (int limb = fractionLimbs; limb >= 0; limb--) {
+			uint64_t current = (remainder << 32) | number.limbs[limb];
+			number.limbs[limb] = (uint32_t)(current / 10);
+			remainder = current % 10;
+		}
+	}
+
+	number.limbs[fractionLimbs] = (uint32_t)integer;
+	number.negative = isNegative && !number.IsZero();
+	*result = number;
+	return true;
+}
+
+/// <summary>
+/// Get the precision needed by the coordinates of an image whose pixels are spacing apart,
+/// with 64 bits more so the reference orbit stays exact over many iterations
+/// </summary>
+/// <param name="spacing">distance between two pixels in the complex plane</param>
+/// <returns>number of 32 bits limbs of the fraction</returns>
+int BigFloat::FractionLimbsFor(double spacing)
+{
+	if (!(spacing > 0) || std::isinf(spacing)) {
+		return 2;
+	}
+	int bits = (int)ceil(-log2(spacing)) + 64;
+	return std::max(2, (bits + 31) / 32);
+}
+
+/// <summary>
+/// Get the precision of the number
+/// </summary>
+/// <returns>number of 32 bits limbs of the fraction</returns>
+int BigFloat::GetFractionLimbs() const
+{
+	return (int)limbs.size() - 1;
+}
+
+/// <summary>
+/// Convert the number to the nearest double (truncated)
+/// </summary>
+/// <returns>value of the number</returns>
+double BigFloat::ToDouble() const
+{
+	double value = 0;
+	int fractionLimbs = GetFractionLimbs();
+	for (int i = 0; i <= fractionLimbs; i++) {
+		value += ldexp((double)limbs[i], 32 * (i - fractionLimbs));
+	}
+	return negative ? -value : value;
+}
+
+/// <summary>
+/// Write the number in decimal
+/// </summary>
+/// <param name="fractionDigits">maximum number of digits after the point, the trailing zeros are removed</param>
+/// <returns>number in decimal</returns>
+std::string BigFloat::ToString(int fractionDigits) const
+{
+	std::string text = (negative ? "-" : "") + std::to_string(limbs.back()) + ".";
+
+	std::vector<uint32_t> fraction = limbs;
+	for (int digit = 0; digit < fractionDigits; digit++) {
+		// The integer part of fraction * 10 is the next digit
+		fraction.back() = 0;
+		uint64_t carry = 0;
+		for (uint32_t& limb : fraction) {
+			uint64_t current = (uint64_t)limb * 10 + carry;
+			limb = (uint32_t)current;
+			carry = current >> 32;
+		}
+		text += (char)('0' + fraction.back());
+	}
+
+	size_t last = text.find_last_not_of('0');
+	return text.substr(0, text[last] == '.' ? last + 2 : last + 1);
+}
+
+/// <summary>
+/// Add two numbers
+/// </summary>
+/// <param name="other">number to add</param>
+/// <returns>sum, with the precision of the most precise operand</returns>
+BigFloat BigFloat::operator+(const BigFloat& other) const
+{
+	BigFloat result;
+	if (negative == other.negative) {
+		result = AddMagnitude(*this, other);
+		result.negative = negative;
+	}
+	else if (CompareMagnitude(*this, other) >= 0) {
+		result = SubtractMagnitude(*this, other);
+		result.negative = negative;
+	}
+	else {
+		result = SubtractMagnitude(other, *this);
+		result.negative = other.negative;
+	}
+	result.negative = result.negative && !result.IsZero();
+	return result;
+}
+
+/// <summary>
+/// Subtract two numbers
+/// </summary>
+/// <param name="other">number to subtract</param>
+/// <returns>difference, with the precision of the most precise operand</returns>
+BigFloat BigFloat::operator-(const BigFloat& other) const
+{
+	BigFloat opposite = other;
+	opposite.negative = !other.negative && !other.IsZero();
+	return *this + opposite;
+}
+
+/// <summary>
+/// Multiply two numbers, the bits after the precision are truncated
+/// </summary>
+/// <param name="other">number to multiply by</param>
+/// <returns>product, with the precision of the most precise operand</returns>
+BigFloat BigFloat::operator*(const BigFloat& other) const
+{
+	int fractionLimbs = std::max(GetFractionLimbs(), other.GetFractionLimbs());
+	BigFloat left = Resized(fractionLimbs);
+	BigFloat right = other.Resized(fractionLimbs);
+	size_t size = left.limbs.size();
+
+	// Schoolbook multiplication, the product has twice as many fraction limbs
+	std::vector<uint32_t> product(size * 2, 0);
+	for (size_t i = 0; i < size; i++) {
+		uint64_t carry = 0;
+		for (size_t j = 0; j < size; j++) {
+			uint64_t current = (uint64_t)left.limbs[i] * right.limbs[j] + product[i + j] + carry;
+			product[i + j] = (uint32_t)current;
+			carry = current >> 32;
+		}
+		product[i + size] = (uint32_t)carry;
+	}
+
+	BigFloat result;
+	result.limbs.assign(product.begin() + fractionLimbs, product.begin() + fractionLimbs + size);
+	result.negative = (negative != other.negative) && !result.IsZero();
+	return result;
+}
+
+/// <summary>
+/// Divide the number by 2, the last bit is truncated
+/// </summary>
+/// <returns>half of the number</returns>
+BigFloat BigFloat::Half() const
+{
+	BigFloat result = *this;
+	uint32_t carry = 0;
+	for (int i = (int)result.limbs.size() - 1; i >= 0; i--) {
+		uint32_t limb = result.limbs[i];
+		result.limbs[i] = (limb >> 1) | (carry << 31);
+		carry = limb & 1;
+	}
+	result.negative = negative && !result.IsZero();
+	return result;
+}
+
+/// <summary>
+/// Get the number with another precision
+/// </summary>
+/// <param name="fractionLimbs">number of 32 bits limbs of the fraction</param>
+/// <returns>number with the new precision, truncated if it's lower</returns>
+BigFloat BigFloat::Resized(int fractionLimbs) const
+{
+	BigFloat result;
+	result.negative = negative;
+	result.limbs.assign(fractionLimbs + 1, 0);
+	int shift = GetFractionLimbs() - fractionLimbs;
+	for (int i = 0; i <= fractionLimbs; i++) {
+		if (i + shift >= 0) {
+			result.limbs[i] = limbs[i + shift];
+		}
+	}
+	return result;
+}
+
+/// <summary>
+/// Check if the number is 0
+/// </summary>
+/// <returns>true if every limb is 0</returns>
+bool BigFloat::IsZero() const
+{
+	return std::all_of(limbs.begin(), limbs.end(), [](uint32_t limb) { return limb == 0; });
+}
+
+/// <summary>
+/// Compare the absolute values of two numbers
+/// </summary>
+/// <param name="left">first number</param>
+/// <param name="right">second number</param>
+/// <returns>-1, 0 or 1 if |left| is lower, equal or greater than |right|</returns>
+int BigFloat::CompareMagnitude(const BigFloat& left, const BigFloat& right)
+{
+	int fractionLimbs = std::max(left.GetFractionLimbs(), right.GetFractionLimbs());
+	BigFloat a = left.Resized(fractionLimbs);
+	BigFloat b = right.Resized(fractionLimbs);
+	for (int i = fractionLimbs; i >= 0; i--) {
+		if (a.limbs[i] != b.limbs[i]) {
+			return a.limbs[i] < b.limbs[i] ? -1 : 1;
+		}
+	}
+	return 0;
+}
+
+/// <summary>
+/// Add the absolute values of two numbers, the carry after the integer part is lost
+/// </summary>
+/// <param name="left">first number</param>
+/// <param name="right">second number</param>
+/// <returns>|left| + |right|</returns>
+BigFloat BigFloat::AddMagnitude(const BigFloat& left, const BigFloat& right)
+{
+	int fractionLimbs = std::max(left.GetFractionLimbs(), right.GetFractionLimbs());
+	BigFloat result = left.Resized(fractionLimbs);
+	BigFloat b = right.Resized(fractionLimbs);
+	uint64_t carry = 0;
+	for (int i = 0; i <= fractionLimbs; i++) {
+		uint64_t current = (uint64_t)result.limbs[i] + b.limbs[i] + carry;
+		result.limbs[i] = (uint32_t)current;
+		carry = current >> 32;
+	}
+	result.negative = false;
+	return result;
+}
+
+/// <summary>
+/// Subtract the absolute values of two numbers
+/// </summary>
+/// <param name="left">first number, its absolute value must be the greatest</param>
+/// <param name="right">second number</param>
+/// <returns>|left| - |right|</returns>
+BigFloat BigFloat::SubtractMagnitude(const BigFloat& left, const BigFloat& right)
+{
+	int fractionLimbs = std::max(left.GetFractionLimbs(), right.GetFractionLimbs());
+	BigFloat result = left.Resized(fractionLimbs);
+	BigFloat b = right.Resized(fractionLimbs);
+	int64_t borrow = 0;
+	for (int i = 0; i <= fractionLimbs; i++) {
+		int64_t current = (int64_t)result.limbs[i] - b.limbs[i] - borrow;
+		borrow = current < 0 ? 1 : 0;
+		result.limbs[i] = (uint32_t)(current + (borrow << 32));
+	}
+	result.negative = false;
+	return result;
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Fixed-point number of arbitrary precision, used for the coordinates of deep zooms
+/// and the reference orbit of the perturbation, where a double doesn't have enough digits.
+/// The value has a 32 bits integer part and a fraction of any number of 32 bits limbs,
+/// the result of an operation has the precision of its most precise operand.
+/// </summary>
+class BigFloat
+{
+private:
+	/// <summary>
+	/// Whether the number is negative
+	/// </summary>
+	bool negative = false;
+
+	/// <summary>
+	/// Limbs of the absolute value, least significant first.
+	/// The last one is the integer part, the others are the fraction.
+	/// </summary>
+	std::vector<uint32_t> limbs;
+
+	BigFloat Resized(int) const;
+	bool IsZero() const;
+	static int CompareMagnitude(const BigFloat&, const BigFloat&);
+	static BigFloat AddMagnitude(const BigFloat&, const BigFloat&);
+	static BigFloat SubtractMagnitude(const BigFloat&, const BigFloat&);
+public:
+	BigFloat();
+	BigFloat(double, int);
+	static bool Parse(const std::string&, int, BigFloat*);
+	static int FractionLimbsFor(double);
+	int GetFractionLimbs() const;
+	double ToDouble() const;
+	std::string ToString(int) const;
+	BigFloat operator+(const BigFloat&) const;
+	BigFloat operator-(const BigFloat&) const;
+	BigFloat operator*(const BigFloat&) const;
+	BigFloat Half() const;
+};
@@ -1,23 +1,129 @@
 #pragma once
+#include <cmath>
+
 /// <summary>
-/// Class to represent a complex number
+/// Class to represent a complex number, its parts being a double or a DoubleDouble for the deep zooms.
+/// The methods are defined in the header so they can be inlined in the calculation loops.
 /// </summary>
-class Complex
+/// <typeparam name="Real">type of the real and imaginary parts</typeparam>
+template <typename Real>
+class ComplexNumber
 {
 private:
 	/// <summary>
 	/// Real part of the complex
 	/// </summary>
-	double real;
+	Real real;
 
 	/// <summary>
 	/// Imaginary part of the complex
 	/// </summary>
-	double imag;
+	Real imag;
 public:
-	Complex();
-	Complex(double, double);
-	double Modulus();
-	Complex NextIteration(Complex);
+	/// <summary>
+	/// Constructor without parameters to create a 0 + 0i number
+	/// </summary>
+	ComplexNumber() : real(0), imag(0) {}
+
+	/// <summary>
+	/// Constructor of the complex number
+	/// </summary>
+	/// <param name="real">Real part of the complex</param>
+	/// <param name="imag">Imaginary part of the complex</param>
+	ComplexNumber(Real real, Real imag) : real(real), imag(imag) {}
+
+	/// <summary>
+	/// Calculate the modulus of the current complex number
+	/// </summary>
+	/// <returns>modulus of the current complex number</returns>
+	double Modulus() const
+	{
+		return sqrt((double)ModulusSquared());
+	}
+
+	/// <summary>
+	/// Calculate the square of the modulus of the current complex number, without the sqrt of Modulus
+	/// </summary>
+	/// <returns>square of the modulus of the current complex number</returns>
+	Real ModulusSquared() const
+	{
+		return real * real + imag * imag;
+	}
+
+	/// <summary>
+	/// Return a new complex using the formula z^2 + c
+	/// With z the current complex and c the parameter
+	/// </summary>
+	/// <param name="c">complex added for calculating the next iteration</param>
+	/// <returns>next iteration of Mandelbrot</returns>
+	ComplexNumber NextIteration(ComplexNumber c) const
+	{
+		// Do the multiplication and addition at the same time to gain time
+		return ComplexNumber((real * real) - (imag * imag) + c.real, (real * imag) + (imag * real) + c.imag);
+	}
+
+	/// <summary>
+	/// Add two complex numbers
+	/// </summary>
+	/// <param name="other">complex to add</param>
+	/// <returns>sum of the two complex numbers</returns>
+	ComplexNumber operator+(const ComplexNumber& other) const
+	{
+		return ComplexNumber(real + other.real, imag + other.imag);
+	}
+
+	/// <summary>
+	/// Multiply two complex numbers
+	/// </summary>
+	/// <param name="other">complex to multiply with</param>
+	/// <returns>product of the two complex numbers</returns>
+	ComplexNumber operator*(const ComplexNumber& other) const
+	{
+		return ComplexNumber((real * other.real) - (imag * other.imag), (real * other.imag) + (imag * other.real));
+	}
+
+	/// <summary>
+	/// Return a new complex with the absolute values of both parts, used by the Burning Ship
+	/// </summary>
+	/// <returns>|real| + |imag|i</returns>
+	ComplexNumber AbsoluteParts() const
+	{
+		return ComplexNumber(fabs(real), fabs(imag));
+	}
+
+	/// <summary>
+	/// Raise the current complex number to a power known at compile time,
+	/// by squaring so the compiler unrolls the few multiplications
+	/// </summary>
+	/// <typeparam name="Exponent">power, 1 or more</typeparam>
+	/// <returns>current complex number to the power Exponent</returns>
+	template <int Exponent>
+	ComplexNumber Power() const
+	{
+		if constexpr (Exponent == 1) {
+			return *this;
+		}
+		else if constexpr (Exponent % 2 == 0) {
+			ComplexNumber half = Power<Exponent / 2>();
+			return half * half;
+		}
+		else {
+			return Power<Exponent - 1>() * *this;
+		}
+	}
+
+	/// <summary>
+	/// Check if two complex numbers are exactly equal
+	/// </summary>
+	/// <param name="other">complex to compare with</param>
+	/// <returns>true if both parts are equal</returns>
+	bool operator==(const ComplexNumber& other) const
+	{
+		return real == other.real && imag == other.imag;
+	}
 };
 
+/// <summary>
+/// Complex number of doubles, used by every kernel except the double-double variants of FractalEngine.h
+/// </summary>
+typedef ComplexNumber<double> Complex;
@@ -0,0 +1,176 @@
+#pragma once
+#include <cmath>
+
+/// <summary>
+/// Number stored as the unevaluated sum of two doubles, the low part holding the bits the high part can't.
+/// It has about 32 significant digits instead of 16, for the zooms too deep for a double when the perturbation can't be used.
+/// The operations only use additions and multiplications of doubles, so the program must be compiled without contracting them
+/// into fused multiply-adds (-ffp-contract=off), like the kernels.
+/// The methods are defined in the header so they can be inlined in the calculation loops.
+/// </summary>
+class DoubleDouble
+{
+private:
+	/// <summary>
+	/// Value rounded to a double
+	/// </summary>
+	double high;
+
+	/// <summary>
+	/// Rounding error of high, at most half a unit in the last place of high
+	/// </summary>
+	double low;
+
+	/// <summary>
+	/// Add two doubles without losing the rounding error of the sum, when |a| >= |b|
+	/// </summary>
+	/// <param name="a">double of the highest magnitude</param>
+	/// <param name="b">other double</param>
+	/// <returns>exact sum</returns>
+	static DoubleDouble QuickTwoSum(double a, double b)
+	{
+		double sum = a + b;
+		return DoubleDouble(sum, b - (sum - a));
+	}
+
+	/// <summary>
+	/// Add two doubles without losing the rounding error of the sum
+	/// </summary>
+	/// <param name="a">first double</param>
+	/// <param name="b">second double</param>
+	/// <returns>exact sum</returns>
+	static DoubleDouble TwoSum(double a, double b)
+	{
+		double sum = a + b;
+		double bPart = sum - a;
+		return DoubleDouble(sum, (a - (sum - bPart)) + (b - bPart));
+	}
+
+	/// <summary>
+	/// Multiply two doubles without losing the rounding error of the product, with the splitting of Dekker
+	/// </summary>
+	/// <param name="a">first double</param>
+	/// <param name="b">second double</param>
+	/// <returns>exact product</returns>
+	static DoubleDouble TwoProduct(double a, double b)
+	{
+		// 2^27 + 1 splits a double in two halves of 26 bits whose products are exact
+		constexpr double splitter = 134217729.0;
+		double aSplit = splitter * a;
+		double aHigh = aSplit - (aSplit - a);
+		double aLow = a - aHigh;
+		double bSplit = splitter * b;
+		double bHigh = bSplit - (bSplit - b);
+		double bLow = b - bHigh;
+		double product = a * b;
+		return DoubleDouble(product, ((aHigh * bHigh - product) + aHigh * bLow + aLow * bHigh) + aLow * bLow);
+	}
+public:
+	/// <summary>
+	/// Constructor without parameters to create 0
+	/// </summary>
+	DoubleDouble() : high(0), low(0) {}
+
+	/// <summary>
+	/// Constructor from a double
+	/// </summary>
+	/// <param name="value">value of the number</param>
+	DoubleDouble(double value) : high(value), low(0) {}
+
+	/// <summary>
+	/// Constructor from the two parts
+	/// </summary>
+	/// <param name="high">value rounded to a double</param>
+	/// <param name="low">rounding error of high</param>
+	DoubleDouble(double high, double low) : high(high), low(low) {}
+
+	/// <summary>
+	/// Round the number to a double
+	/// </summary>
+	explicit operator double() const
+	{
+		return high;
+	}
+
+	/// <summary>
+	/// Get the low part of the number
+	/// </summary>
+	/// <returns>rounding error of the double value of the number</returns>
+	double GetLow() const
+	{
+		return low;
+	}
+
+	/// <summary>
+	/// Add two numbers
+	/// </summary>
+	/// <param name="other">number to add</param>
+	/// <returns>sum of the two numbers</returns>
+	DoubleDouble operator+(const DoubleDouble& other) const
+	{
+		DoubleDouble sum = TwoSum(high, other.high);
+		DoubleDouble lowSum = TwoSum(low, other.low);
+		sum = QuickTwoSum(sum.high, sum.low + lowSum.high);
+		return QuickTwoSum(sum.high, sum.low + lowSum.low);
+	}
+
+	/// <summary>
+	/// Subtract two numbers
+	/// </summary>
+	/// <param name="other">number to subtract</param>
+	/// <returns>difference of the two numbers</returns>
+	DoubleDouble operator-(const DoubleDouble& other) const
+	{
+		return *this + -other;
+	}
+
+	/// <summary>
+	/// Get the opposite of the number
+	/// </summary>
+	/// <returns>opposite of the number, exact</returns>
+	DoubleDouble operator-() const
+	{
+		return DoubleDouble(-high, -low);
+	}
+
+	/// <summary>
+	/// Multiply two numbers
+	/// </summary>
+	/// <param name="other">number to multiply with</param>
+	/// <returns>product of the two numbers</returns>
+	DoubleDouble operator*(const DoubleDouble& other) const
+	{
+		DoubleDouble product = TwoProduct(high, other.high);
+		return QuickTwoSum(product.high, product.low + (high * other.low + low * other.high));
+	}
+
+	/// <summary>
+	/// Compare the number with a double
+	/// </summary>
+	/// <param name="other">double to compare with</param>
+	/// <returns>true if the number is lower than or equal to the double</returns>
+	bool operator<=(double other) const
+	{
+		return high < other || (high == other && low <= 0);
+	}
+
+	/// <summary>
+	/// Check if two numbers are exactly equal
+	/// </summary>
+	/// <param name="other">number to compare with</param>
+	/// <returns>true if both parts are equal</returns>
+	bool operator==(const DoubleDouble& other) const
+	{
+		return high == other.high && low == other.low;
+	}
+};
+
+/// <summary>
+/// Absolute value of a number, found by the complex numbers of the Burning Ship like the fabs of a double
+/// </summary>
+/// <param name="value">number</param>
+/// <returns>|value|</returns>
+inline DoubleDouble fabs(const DoubleDouble& value)
+{
+	return (double)value < 0 || ((double)value == 0 && value.GetLow() < 0) ? -value : value;
+}
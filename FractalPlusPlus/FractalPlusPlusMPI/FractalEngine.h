@@ -0,0 +1,327 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "DoubleDouble.h"
+#include "Complex.h"
+#include "Kernel.h"
+
+/// <summary>
+/// Header-only engine calculating the escape time of the other fractals than the Mandelbrot set of power 2.
+/// The formula, the power, the escape radius, the color mode and the precision are template parameters,
+/// so each variant is compiled to its own loop without any test on them while iterating.
+/// The variant is chosen once per frame with GetFractalEngine.
+/// </summary>
+
+/// <summary>
+/// Fractals drawn by the engine, each one can be raised to the powers minFractalPower to maxFractalPower
+/// </summary>
+enum FractalType : uint32_t {
+	FRACTAL_MANDELBROT, // z^n + c from z = 0, c being the pixel, the Multibrot sets when n > 2
+	FRACTAL_JULIA, // z^n + c from z being the pixel, c being a parameter
+	FRACTAL_BURNING_SHIP, // (|Re(z)| + |Im(z)|i)^n + c from z = 0, c being the pixel
+	FRACTAL_COUNT
+};
+
+/// <summary>
+/// How the iteration counts are turned into the values colored by the palettes
+/// </summary>
+enum ColorMode : uint32_t {
+	COLOR_SMOOTH, // Fractional counts, the colors change continuously
+	COLOR_BANDS, // Whole counts, one band of color per iteration
+	COLOR_MODE_COUNT
+};
+
+/// <summary>
+/// Lowest power of the fractals
+/// </summary>
+constexpr int minFractalPower = 2;
+
+/// <summary>
+/// Highest power of the fractals, each power is a variant of the engine
+/// </summary>
+constexpr int maxFractalPower = 8;
+
+/// <summary>
+/// Escape radius of the smooth colors of the engine, the fractional counts are more exact with a big radius.
+/// The bands and the vectorized kernels of the Mandelbrot set use 2.
+/// </summary>
+constexpr int smoothEscapeRadius = 16;
+
+/// <summary>
+/// Fractal drawn in a frame
+/// </summary>
+typedef struct fractalParameters {
+	FractalType type;
+	int power; // n of z^n + c, from minFractalPower to maxFractalPower
+	ColorMode colorMode;
+	double juliaReal; // Real part of c for the Julia sets, its modulus is at most 2
+	double juliaImag; // Imaginary part of c for the Julia sets
+} fractalParameters;
+
+/// <summary>
+/// z(n+1) = z(n)^Exponent + c, from z(0) = 0 and c being the pixel
+/// </summary>
+typedef struct mandelbrotFormula {
+	static constexpr bool startsAtPixel = false;
+
+	template <int Exponent, class Number>
+	static Number Next(const Number& z, const Number& c)
+	{
+		return z.template Power<Exponent>() + c;
+	}
+} mandelbrotFormula;
+
+/// <summary>
+/// z(n+1) = z(n)^Exponent + c, from z(0) being the pixel and c the parameter of the Julia set
+/// </summary>
+typedef struct juliaFormula {
+	static constexpr bool startsAtPixel = true;
+
+	template <int Exponent, class Number>
+	static Number Next(const Number& z, const Number& c)
+	{
+		return z.template Power<Exponent>() + c;
+	}
+} juliaFormula;
+
+/// <summary>
+/// z(n+1) = (|Re(z(n))| + |Im(z(n))|i)^Exponent + c, from z(0) = 0 and c being the pixel
+/// </summary>
+typedef struct burningShipFormula {
+	static constexpr bool startsAtPixel = false;
+
+	template <int Exponent, class Number>
+	static Number Next(const Number& z, const Number& c)
+	{
+		return z.AbsoluteParts().template Power<Exponent>() + c;
+	}
+} burningShipFormula;
+
+/// <summary>
+/// Escape-time calculation of one variant of the fractals, one pixel at a time like EscapeTimeRowScalar
+/// </summary>
+/// <typeparam name="Formula">formula of the sequence, mandelbrotFormula, juliaFormula or burningShipFormula</typeparam>
+/// <typeparam name="Exponent">power of the formula</typeparam>
+/// <typeparam name="EscapeRadius">modulus above which the sequence diverges</typeparam>
+/// <typeparam name="Mode">how the iteration counts are colored</typeparam>
+/// <typeparam name="Real">precision of the calculation, double or DoubleDouble</typeparam>
+template <class Formula, int Exponent, int EscapeRadius, ColorMode Mode, typename Real = double>
+class FractalEngine
+{
+public:
+	/// <summary>
+	/// Calculate the sequence of consecutive pixels of a row, with the arguments of EscapeTimeRow.
+	/// Only the periodicity check of interiorChecks is used, the bulbs are those of the Mandelbrot set of power 2.
+	/// In double-double the pixels are placed from the center of the image, whose low parts hold the digits the ranges can't.
+	/// </summary>
+	static void EscapeTimeRow(const viewport& view, int iYpos, int firstColumn, int count, int maxIteration, int interiorChecks, int* iterations, double* modulusSquared)
+	{
+		typedef ComplexNumber<Real> Number;
+		constexpr double escape = EscapeRadius == 2 ? escapeModulusSquared : (double)EscapeRadius * EscapeRadius;
+		const Number parameter(view.juliaReal, view.juliaImag);
+		Real rangeYPos;
+		if constexpr (std::is_same_v<Real, double>) {
+			rangeYPos = (double)iYpos / (double)view.pixelHeight * (view.maxRangeY - view.minRangeY) + view.minRangeY;
+		}
+		else {
+			// The distance to the center is smaller than the range, a double is precise enough for it
+			rangeYPos = Real(view.centerY[0], view.centerY[1]) + ((double)iYpos / (double)view.pixelHeight - 0.5) * view.rangeHeight;
+		}
+
+		for (int i = 0; i < count; i++)
+		{
+			Real rangeXPos;
+			if constexpr (std::is_same_v<Real, double>) {
+				rangeXPos = (double)(firstColumn + i * view.columnStep) / (double)view.pixelWidth * (view.maxRangeX - view.minRangeX) + view.minRangeX;
+			}
+			else {
+				rangeXPos = Real(view.centerX[0], view.centerX[1]) + ((double)(firstColumn + i * view.columnStep) / (double)view.pixelWidth - 0.5) * view.rangeWidth;
+			}
+			Number pixel(rangeXPos, rangeYPos);
+			Number z = Formula::startsAtPixel ? pixel : Number(0, 0);
+			Number c = Formula::startsAtPixel ? parameter : pixel;
+
+			// Same periodicity check as EscapeTimeRowScalar
+			Number savedZ = z;
+			int savedAge = 0;
+			int checkLength = periodicityFirstCheck;
+
+			int iteration = 0;
+			while (iteration < maxIteration && z.ModulusSquared() <= escape)
+			{
+				z = Formula::template Next<Exponent>(z, c);
+				iteration++;
+
+				if (interiorChecks & INTERIOR_CHECK_PERIODICITY) {
+					if (z == savedZ) {
+						iteration = maxIteration; // z loops forever without diverging
+						break;
+					}
+					if (++savedAge == checkLength) {
+						savedZ = z;
+						savedAge = 0;
+						checkLength *= 2;
+					}
+				}
+			}
+
+			iterations[i] = iteration;
+			modulusSquared[i] = (double)z.ModulusSquared();
+		}
+	}
+
+	/// <summary>
+	/// Calculate the value colored by the palettes of a pixel whose sequence diverged
+	/// </summary>
+	/// <param name="iteration">number of iterations done before diverging</param>
+	/// <param name="modulusSquared">squared modulus of the last z of the sequence</param>
+	/// <returns>smooth iteration count, or whole one with COLOR_BANDS</returns>
+	static float SmoothIteration(int iteration, double modulusSquared)
+	{
+		if constexpr (Mode == COLOR_BANDS) {
+			return (float)iteration;
+		}
+		else {
+			// The modulus escaped between EscapeRadius and EscapeRadius^Exponent, nu goes from 0 to 1 between them
+			double log_zn = log(sqrt(modulusSquared));
+			double nu = log(log_zn / log((double)EscapeRadius)) / log((double)Exponent);
+			return (float)(iteration + 1 - nu);
+		}
+	}
+};
+
+/// <summary>
+/// Functions of the variant of the engine chosen for a frame
+/// </summary>
+typedef struct fractalEngine {
+	escapeTimeRowFunction escapeTimeRow; // nullptr for the Mandelbrot set of power 2, calculated by the kernels of Kernel.h
+	escapeTimeRowFunction escapeTimeRowDoubleDouble; // Same variant in double-double, for every fractal
+	float (*smoothIteration)(int, double); // Value colored by the palettes of a diverged pixel
+} fractalEngine;
+
+/// <summary>
+/// Get the functions of a formula and a power for a color mode
+/// </summary>
+/// <param name="colorMode">how the iteration counts are colored</param>
+/// <returns>functions of the variant</returns>
+template <class Formula, int Exponent>
+fractalEngine GetFormulaEngine(ColorMode colorMode)
+{
+	if (colorMode == COLOR_BANDS) {
+		return { &FractalEngine<Formula, Exponent, 2, COLOR_BANDS>::EscapeTimeRow, &FractalEngine<Formula, Exponent, 2, COLOR_BANDS, DoubleDouble>::EscapeTimeRow,
+			&FractalEngine<Formula, Exponent, 2, COLOR_BANDS>::SmoothIteration };
+	}
+	return { &FractalEngine<Formula, Exponent, smoothEscapeRadius, COLOR_SMOOTH>::EscapeTimeRow,
+		&FractalEngine<Formula, Exponent, smoothEscapeRadius, COLOR_SMOOTH, DoubleDouble>::EscapeTimeRow,
+		&FractalEngine<Formula, Exponent, smoothEscapeRadius, COLOR_SMOOTH>::SmoothIteration };
+}
+
+/// <summary>
+/// Get the functions of a formula for a power known at runtime, instantiating every power from Exponent to maxFractalPower
+/// </summary>
+/// <param name="power">power of the formula</param>
+/// <param name="colorMode">how the iteration counts are colored</param>
+/// <returns>functions of the variant</returns>
+template <class Formula, int Exponent = minFractalPower>
+fractalEngine GetPowerEngine(int power, ColorMode colorMode)
+{
+	if constexpr (Exponent < maxFractalPower) {
+		if (power > Exponent) {
+			return GetPowerEngine<Formula, Exponent + 1>(power, colorMode);
+		}
+	}
+	return GetFormulaEngine<Formula, Exponent>(colorMode);
+}
+
+/// <summary>
+/// Choose the variant of the engine of a fractal, called once per frame
+/// </summary>
+/// <param name="parameters">fractal of the frame</param>
+/// <returns>functions of the variant</returns>
+inline fractalEngine GetFractalEngine(const fractalParameters& parameters)
+{
+	switch (parameters.type) {
+		case FRACTAL_JULIA:
+			return GetPowerEngine<juliaFormula>(parameters.power, parameters.colorMode);
+		case FRACTAL_BURNING_SHIP:
+			return GetPowerEngine<burningShipFormula>(parameters.power, parameters.colorMode);
+		default:
+			if (parameters.power == 2) {
+				// The vectorized kernels, the perturbation and the bulbs of Kernel.h only calculate this one, with an escape radius of 2
+				if (parameters.colorMode == COLOR_BANDS) {
+					return { nullptr, &FractalEngine<mandelbrotFormula, 2, 2, COLOR_BANDS, DoubleDouble>::EscapeTimeRow,
+						&FractalEngine<mandelbrotFormula, 2, 2, COLOR_BANDS>::SmoothIteration };
+				}
+				return { nullptr, &FractalEngine<mandelbrotFormula, 2, 2, COLOR_SMOOTH, DoubleDouble>::EscapeTimeRow,
+					&FractalEngine<mandelbrotFormula, 2, 2, COLOR_SMOOTH>::SmoothIteration };
+			}
+			return GetPowerEngine<mandelbrotFormula>(parameters.power, parameters.colorMode);
+	}
+}
+
+/// <summary>
+/// Get the name of a fractal
+/// </summary>
+/// <param name="type">fractal</param>
+/// <returns>name of the fractal</returns>
+inline const char* GetFractalName(FractalType type)
+{
+	switch (type) {
+		case FRACTAL_JULIA:
+			return "Julia set";
+		case FRACTAL_BURNING_SHIP:
+			return "Burning Ship";
+		default:
+			return "Mandelbrot set";
+	}
+}
+
+/// <summary>
+/// Check if the parameters of a fractal can be calculated by the engine
+/// </summary>
+/// <param name="parameters">fractal to check</param>
+/// <returns>false if a parameter is out of range</returns>
+inline bool AreFractalParametersValid(const fractalParameters& parameters)
+{
+	// The escape radius must be at least |c| for the Julia sets
+	return parameters.type < FRACTAL_COUNT && parameters.colorMode < COLOR_MODE_COUNT
+		&& parameters.power >= minFractalPower && parameters.power <= maxFractalPower
+		&& parameters.juliaReal * parameters.juliaReal + parameters.juliaImag * parameters.juliaImag <= 4;
+}
+
+/// <summary>
+/// Check if a fractal is symmetric about the real axis : the sequence of the conjugate of a pixel is the conjugate of its sequence,
+/// since the conjugate of z^n + c is conj(z)^n + conj(c). The Julia sets are only symmetric when c is real,
+/// and the absolute values of the Burning Ship break the symmetry.
+/// </summary>
+/// <param name="parameters">fractal to check</param>
+/// <returns>true if the pixels mirrored across the real axis have the same iteration count</returns>
+inline bool IsConjugateSymmetric(const fractalParameters& parameters)
+{
+	return parameters.type == FRACTAL_MANDELBROT || (parameters.type == FRACTAL_JULIA && parameters.juliaImag == 0);
+}
+
+/// <summary>
+/// Hash the parameters of a fractal changing the colored values, for the keys of the tile cache
+/// </summary>
+/// <param name="parameters">fractal to hash</param>
+/// <returns>FNV-1a hash of the parameters</returns>
+inline uint32_t HashFractalParameters(const fractalParameters& parameters)
+{
+	// c is only used by the Julia sets
+	bool isJulia = parameters.type == FRACTAL_JULIA;
+	double c[2] = { isJulia ? parameters.juliaReal : 0, isJulia ? parameters.juliaImag : 0 };
+	uint32_t fields[3] = { parameters.type, (uint32_t)parameters.power, parameters.colorMode };
+	unsigned char bytes[sizeof(fields) + sizeof(c)];
+	std::memcpy(bytes, fields, sizeof(fields));
+	std::memcpy(bytes + sizeof(fields), c, sizeof(c));
+
+	uint32_t hash = 2166136261u;
+	for (unsigned char byte : bytes) {
+		hash = (hash ^ byte) * 16777619u;
+	}
+	return hash;
+}
@@ -1,35 +1,33 @@
 #include <iostream>
+#include <stdexcept>
 #include <string>
-#include <cmath>
-#include <filesystem>
 #include <mpi.h>
-#include <SDL/SDL.h>
-#undef main // Needed to overwrite the overwritten main method by SDL
 
-#include "Complex.h"
+#include "FractalRenderer.h"
+#include "RenderServer.h"
+#include "LargeImageRenderer.h"
+#include "AnimationRenderer.h"
+#include "BatchRenderer.h"
+#include "Benchmark.h"
 
 
-typedef struct color {
-	int r;
-	int g;
-	int b;
-} color;
-
-int main(int, char* []);
-bool IsDiverging(color);
-void CreateMandelbrotImage(color**);
-color GetPixelColor(int, int, int, int, double, double, double, double);
-void DefineColorStruct(MPI_Datatype*);
-
 /// <summary>
-/// Width of the image
+/// Options of the command line choosing what the program renders, the options of the frames being kept by the FractalRenderer
 /// </summary>
-int pixelWidth;
+typedef struct programOptions {
+	int serverPort = 0; // Port of the loopback interface the render server listens on, 0 to render one image and exit
+	std::string animationPath; // Keyframe file of the zoom animation rendered in one run, empty to render one image
+	std::string animationDirectory = "animation"; // Directory where the frames of the animation are saved, as frame_00000.bmp, frame_00001.bmp...
+	std::string batchPath; // Job file of the batch rendered in one run, - for the standard input, empty to render one image
+	largeImageOptions output; // Image file of --output, empty to write /tmp/Mandelbrot.bmp from rank 0
+	benchmarkOptions benchmark; // Results file of --benchmark, empty to render images
+	std::string tracePath; // Chrome trace file where rank 0 writes the phases of every rank at the end, empty to record nothing
+	int cacheSize = 0; // Memory of the tile cache in MB, 0 to disable it
+	std::string cacheDirectory; // Directory where the tiles removed from the memory of the cache are written, empty to forget them
+} programOptions;
 
-/// <summary>
-/// Height of the image
-/// </summary>
-int pixelHeight;
+int main(int, char* []);
+void ParseOptions(int, char* [], int, FractalRenderer&, programOptions&);
 
 /// <summary>
 /// Main method of the program
@@ -42,39 +40,45 @@ int pixelHeight;
 /// Third is minRangeX
 /// Fourth is maxRangeX
 /// Fifth is minRangeY
-/// Sixth is maxRangeY</param>
-/// <returns>exit code</returns>
+/// Sixth is maxRangeY
+/// The ranges are read with all their digits, for the deep zooms.
+/// Then optional options, see ParseOptions.
+/// The 6 first arguments are omitted with --server, the viewports are then sent by the GUI, and with --batch, each job having its own.</param>
+/// <returns>exit code, 1 if a job of the batch failed or if the render server couldn't listen</returns>
 int main(int argc, char* argv[])
 {
 	// MPI vars
 	int numtasks, rank;
-	// Initialize MPI
-	MPI_Init(&argc, &argv);
+	// Initialize MPI, only the main thread makes MPI calls, the threads of the pool only calculate
+	int threadSupport;
+	MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &threadSupport);
 	// Get number of tasks
 	MPI_Comm_size(MPI_COMM_WORLD, &numtasks);
 	// Get my rank
 	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
-	// Declare MPI type for the color struct
-	MPI_Datatype colorType;
-	// Initialize MPI type for the color struct
-	DefineColorStruct(&colorType);
-	// Message parsing
-	MPI_Status status;
 
-	if (argc != 7) { // Not 6 because argv[0] is the path of the exe file
-		throw new std::invalid_argument("You must pass 6 arguments : number of pixels per row, number of pixels per column, minRangeX, maxRangeX, minRangeY, maxRangeY");
-	}
+	FractalRenderer renderer;
+	programOptions options;
 
-	pixelWidth = std::stoi(argv[1]);
-	pixelHeight = std::stoi(argv[2]);
-	double minRangeX = std::atof(argv[3]);
-	double maxRangeX = std::atof(argv[4]);
-	double minRangeY = std::atof(argv[5]);
-	double maxRangeY = std::atof(argv[6]);
+	if (argc >= 2 && std::string(argv[1]).rfind("--", 0) == 0) { // Only options
+		ParseOptions(argc, argv, 1, renderer, options);
+	}
+	else {
+		if (argc < 7) { // Not 6 because argv[0] is the path of the exe file
+			throw std::invalid_argument("You must pass 6 arguments : number of pixels per row, number of pixels per column, minRangeX, maxRangeX, minRangeY, maxRangeY");
+		}
 
-	// Calculate the whole Mandelbrot
-	int numberOfPixels = pixelWidth * pixelHeight;
-	int nPerProc = numberOfPixels / numtasks;
+		renderer.pixelWidth = std::stoi(argv[1]);
+		renderer.pixelHeight = std::stoi(argv[2]);
+		renderer.SetViewport(argv[3], argv[4], argv[5], argv[6]);
+		ParseOptions(argc, argv, 7, renderer, options);
+	}
+	if (rank == 0) {
+		renderer.tileCache.Configure(cacheTileSize, (size_t)options.cacheSize << 20, options.cacheDirectory);
+	}
+	if (!options.tracePath.empty()) {
+		renderer.phaseTrace.Start();
+	}
 
 	if (rank == 0) {
 		// Display args
@@ -88,222 +92,342 @@ int main(int argc, char* argv[])
 				std::cout << argv[i] << std::endl;
 			}
 		}
-		std::cout << "Calculating the Mandelbrot set" << std::endl;
-		std::cout << "--------------------------------------------------" << std::endl;
-
-		// Create array of pixels
-		color** pixels = new color * [pixelWidth];
-		for (int i = 0; i < pixelWidth; i++) {
-
-			// Declare a memory block of size n
-			pixels[i] = new color[pixelHeight];
-		}
-
-		// Calculate rank 0's part
-		for (int i = 0; i < nPerProc; i++)
-		{
-			int iXPos = i % pixelWidth;
-			int iYPos = i / pixelWidth;
-
-			color px = GetPixelColor(iXPos, iYPos, pixelWidth, pixelHeight, minRangeX, maxRangeX, minRangeY, maxRangeY);
-			pixels[iXPos][iYPos] = px;
-		}
-
-		// Receive localPixels from other ranks
-		for (int i = 1; i < numtasks; i++)
-		{
-			color* localPixels;
-			int localPixelsSize = 0;
-
-			if (i == numtasks - 1) { // Last task (nPerProc + numberOfPixels % nPerProc) pixels
-				localPixelsSize = nPerProc + numberOfPixels % nPerProc + 1;
-				localPixels = (color*)malloc(sizeof(color) * localPixelsSize);
-				MPI_Recv(localPixels, localPixelsSize, colorType, i, 10, MPI_COMM_WORLD, &status);
-			}
-			else {
-				localPixelsSize = nPerProc + 1;
-				localPixels = (color*)malloc(sizeof(color) * localPixelsSize);
-				MPI_Recv(localPixels, localPixelsSize, colorType, i, 10, MPI_COMM_WORLD, &status);
-			}
-			int rank = localPixels[0].r;
-			int posFirstValue = rank * nPerProc;
-
-			std::cout << "Rank 0 received " << localPixelsSize << " pixels from rank " << rank << std::endl;
-
-			for (int j = 1; j < localPixelsSize; j++)
-			{
-				int iXPos = ((j - 1) + posFirstValue) % pixelWidth;
-				int iYPos = ((j - 1) + posFirstValue) / pixelWidth;
-				pixels[iXPos][iYPos] = localPixels[j]; // Error here, impossible to receive the struct
-			}
-
-			free(localPixels);
-		}
+	}
 
-		// Display pixels
-		CreateMandelbrotImage(pixels);
+	int exitCode = 0;
+	if (options.serverPort != 0) {
+		exitCode = RunServer(renderer, rank, numtasks, options.serverPort) ? 0 : 1;
+	}
+	else if (!options.batchPath.empty()) {
+		exitCode = RenderBatch(renderer, rank, numtasks, options.batchPath) ? 0 : 1;
+	}
+	else if (!options.benchmark.path.empty()) {
+		exitCode = RunBenchmark(renderer, rank, numtasks, options.benchmark) ? 0 : 1;
+	}
+	else if (renderer.pixelWidth <= 0 || renderer.pixelHeight <= 0) {
+		throw std::invalid_argument("You must pass the size of the image, --server, --batch or --benchmark");
+	}
+	else if (!options.animationPath.empty()) {
+		RenderAnimation(renderer, rank, numtasks, options.animationPath, options.animationDirectory);
+	}
+	else if (!options.output.path.empty()) {
+		RenderLargeImage(renderer, rank, numtasks, options.output);
 	}
 	else {
-		int posFirstValue = rank * nPerProc;
-		if (rank == numtasks - 1)
-		{
-			nPerProc += numberOfPixels % nPerProc;
-		}
-
-		color* localPixels = new color[nPerProc + 1]; // + 1 cell to include the rank number
-
-		localPixels[0] = { rank, rank, rank }; // Put rank number in the first cell
-		for (int i = 1; i < nPerProc + 1; i++)
-		{
-			int iXPos = ((i - 1) + posFirstValue) % pixelWidth;
-			int iYPos = ((i - 1) + posFirstValue) / pixelWidth;
-			color px = GetPixelColor(iXPos, iYPos, pixelWidth, pixelHeight, minRangeX, maxRangeX, minRangeY, maxRangeY);
-			localPixels[i] = px;
-		}
+		renderer.RenderFrame(rank, numtasks, nullptr);
+	}
 
-		// Send localPixels to rank 0
-		std::cout << "Rank " << rank << " is ready to send " << nPerProc + 1 << " pixels" << std::endl;
-		MPI_Send(localPixels, nPerProc + 1, colorType, 0, 10, MPI_COMM_WORLD); // (nPerProc + 1)*3 --> 3 is for r, g and b Int
+	if (renderer.phaseTrace.IsEnabled()) {
+		renderer.phaseTrace.Write(rank, numtasks, options.tracePath);
 	}
 
+	renderer.threadPool.reset();
+
 	// Done with MPI
 	MPI_Finalize();
-	return 0;
-}
-
-/// <summary>
-/// Define MPI type with struct color
-/// </summary>
-/// <param name="tstype">MPI type</param>
-void DefineColorStruct(MPI_Datatype* colorType) {
-	const int count = 3;
-	int blocklens[count] = { 1, 1, 1 };
-	MPI_Datatype types[count] = { MPI_INT, MPI_INT, MPI_INT };
-	MPI_Aint disps[count] = { offsetof(color,r), offsetof(color,g), offsetof(color,b) };
-
-	MPI_Type_create_struct(count, blocklens, disps, types, colorType);
-	MPI_Type_commit(colorType);
+	return exitCode;
 }
 
 /// <summary>
-/// Method to know if the Mandelbrot sequence diverge
+/// Read the optional options passed after the 6 arguments of the image :
+/// --schedule dynamic|static : hand out chunks of rows on demand (default) or split the image in one contiguous part per rank
+/// --chunk-rows N : number of rows in a chunk of the dynamic schedule, and in a chunk sent by the static schedule (default 4)
+/// --coordinator on|off : rank 0 only hands out and assembles the chunks of the other ranks, or calculates its share too (default off)
+/// --kernel auto|scalar|avx2|avx512 : version of the escape-time kernel (default auto, the fastest one supported by the CPU)
+/// --threads N : number of threads calculating in each rank (default 0, the cores of the node divided by the number of ranks on it)
+/// --server PORT : keep running and render the viewports sent by the GUI on PORT of the loopback interface
+/// --shared-frame NAME : write the image in the shared memory NAME instead of a BMP file
+/// --palette linear|sqrt|histogram|cyclic : colors of the image (default sqrt)
+/// --interior-checks all|bulbs|periodicity|none : shortcuts finding the pixels inside the set without iterating them up to maxIteration (default all)
+/// --render-mode pixel|subdivide : calculate every pixel (default) or only the borders of tiles, filling the tiles whose border has one iteration count
+/// --symmetry on|off : copy the rows mirrored across the real axis instead of calculating them, for the fractals symmetric about it (default on)
+/// --tile-size N : width and height of the tiles of the subdivide mode (default 32)
+/// --perturbation auto|on|off : calculate the pixels as differences from a reference orbit calculated at full precision,
+/// auto (default) uses it when the pixels are too close for the precision of a double
+/// --precision auto|float|double|double-double : precision of the pixels, auto (default) using the lowest one telling two pixels apart
+/// --max-iteration N : number of iterations after which a pixel is considered as not diverging (default 1000), deep zooms need more
+/// --passes N : passes of the progressive rendering, the image being saved after each one (default 1, the server uses the passes asked by the GUI)
+/// --cache-size MB : memory of the cache of tiles kept between the frames of the render server (default 0, disabled)
+/// --cache-directory DIR : write the tiles removed from the memory of the cache in DIR, and read them back when they are needed again
+/// --fractal mandelbrot|julia|burning-ship : formula of the sequence (default mandelbrot)
+/// --power N : power of the formula, z^N + c, from 2 (default) to 8, the Multibrot sets with mandelbrot
+/// --julia X,Y : c = X + Yi of the Julia set, its modulus must be at most 2 (default 0,0)
+/// --color-mode smooth|bands : color the fractional iteration counts (default) or one band per iteration
+/// --benchmark FILE : replace the 6 arguments, run the benchmarks and append their results to FILE, as JSON lines if it ends with .json, otherwise as CSV. Exits with 1 if a check of the benchmarks fails
+/// --benchmark-repeat N : runs of each benchmark, the fastest one is kept (default 3)
+/// --benchmark-suites LIST : comma-separated suites run by --benchmark among micro, frames, precision, interior and scaling (default all of them)
+/// --trace FILE : record the phases of every rank and write them at the end in FILE, a Chrome trace
+/// --antialias N : calculate N more jittered samples in the pixels on the edges, 0 to disable it (default)
+/// --antialias-threshold T : difference of smooth iteration count with a neighbor above which a pixel is refined (default 1)
+/// --size WIDTHxHEIGHT : size of the image when only options are passed, for --animation
+/// --animation FILE : replace the 4 ranges, render the zoom animation of the keyframe file FILE in one run
+/// --animation-output DIR : directory where the frames of --animation are saved (default animation)
+/// --batch FILE : replace the 6 arguments, render the jobs of FILE (- for the standard input) one per line in one run
+/// --output FILE : every rank writes its tiles of the image straight in FILE with MPI-IO instead of rank 0 writing /tmp/Mandelbrot.bmp, for images of any size
+/// --output-format raw|tiled : order of the pixels in the file of --output, rows of the whole image or square tiles (default)
+/// --output-tile-size N : width and height of the tiles of --output (default 256)
+/// --checkpoint DIR : journal the units of --output written in DIR, so a killed render started again only calculates the missing ones
 /// </summary>
-/// <returns>true if diverging (color isn't black)</returns>
-bool IsDiverging(color pixel)
-{
-	return (pixel.r != 0 || pixel.g != 0 || pixel.b != 0);
-}
-
-/// <summary>
-/// This method creates a Bitmap image with the pixels passed in parameter
-/// </summary>
-/// <param name="pixels">2D array of color (r,g,b) which contains the color of each pixel</param>
-void CreateMandelbrotImage(color** pixels)
+/// <param name="argc">number of arguments</param>
+/// <param name="argv">arguments passed to the program</param>
+/// <param name="firstOption">index of the first option in argv</param>
+/// <param name="renderer">filled with the options of the frames</param>
+/// <param name="options">filled with the options choosing what the program renders</param>
+void ParseOptions(int argc, char* argv[], int firstOption, FractalRenderer& renderer, programOptions& options)
 {
-	// Create the surface
-	SDL_Surface* surface;
-	Uint32 rmask, gmask, bmask, amask;
-
-#if SDL_BYTEORDER == SDL_BIG_ENDIAN
-	rmask = 0xff000000;
-	gmask = 0x00ff0000;
-	bmask = 0x0000ff00;
-	amask = 0x00000000;
-#else
-	rmask = 0x000000ff;
-	gmask = 0x0000ff00;
-	bmask = 0x00ff0000;
-	amask = 0x00000000;
-#endif
-	surface = SDL_CreateRGBSurface(SDL_SWSURFACE, pixelWidth, pixelHeight, 32, rmask, gmask, bmask, amask);
-	if (surface == NULL) {
-		fprintf(stderr, "CreateRGBSurface failed: %s\n", SDL_GetError());
-		exit(1);
-	}
-
-	// Fill the Bitmap with black, so we only need to set the pixels where Mandelbrot is diverging
-	SDL_FillRect(surface, NULL, SDL_MapRGB(surface->format, 0, 0, 0));
+	KernelType kernel = KERNEL_AUTO;
+	int threadCount = 0;
+	for (int i = firstOption; i < argc; i++) {
+		std::string option = argv[i];
+		if (i + 1 >= argc) {
+			throw std::invalid_argument("Missing value for option " + option);
+		}
+		std::string value = argv[++i];
 
-	// Set diverging pixels
-	for (int i = 0; i < pixelWidth; i++)
-	{
-		for (int j = 0; j < pixelHeight; j++)
-		{
-			if (IsDiverging(pixels[i][j]))
-			{
-				unsigned char* surfacePixels = (unsigned char*)surface->pixels;
-				surfacePixels[4 * (j * pixelWidth + i) + 0] = pixels[i][j].b; // Blue
-				surfacePixels[4 * (j * pixelWidth + i) + 1] = pixels[i][j].g; // Green
-				surfacePixels[4 * (j * pixelWidth + i) + 2] = pixels[i][j].r; // Red
+		if (option == "--schedule") {
+			if (value != "dynamic" && value != "static") {
+				throw std::invalid_argument("--schedule must be dynamic or static");
+			}
+			renderer.dynamicSchedule = value == "dynamic";
+		}
+		else if (option == "--chunk-rows") {
+			renderer.chunkRows = std::stoi(value);
+			if (renderer.chunkRows < 1) {
+				throw std::invalid_argument("--chunk-rows must be greater than 0");
+			}
+		}
+		else if (option == "--coordinator") {
+			if (value != "on" && value != "off") {
+				throw std::invalid_argument("--coordinator must be on or off");
+			}
+			renderer.coordinator = value == "on";
+		}
+		else if (option == "--server") {
+			options.serverPort = std::stoi(value);
+			if (options.serverPort < 1 || options.serverPort > 65535) {
+				throw std::invalid_argument("--server must be a port between 1 and 65535");
 			}
 		}
+		else if (option == "--shared-frame") {
+			renderer.sharedFrameName = value;
+		}
+		else if (option == "--interior-checks") {
+			if (value == "all") {
+				SetInteriorChecks(INTERIOR_CHECK_ALL);
+			}
+			else if (value == "bulbs") {
+				SetInteriorChecks(INTERIOR_CHECK_BULBS);
+			}
+			else if (value == "periodicity") {
+				SetInteriorChecks(INTERIOR_CHECK_PERIODICITY);
+			}
+			else if (value == "none") {
+				SetInteriorChecks(INTERIOR_CHECK_NONE);
+			}
+			else {
+				throw std::invalid_argument("--interior-checks must be all, bulbs, periodicity or none");
+			}
+		}
+		else if (option == "--render-mode") {
+			if (value != "pixel" && value != "subdivide") {
+				throw std::invalid_argument("--render-mode must be pixel or subdivide");
+			}
+			renderer.subdivide = value == "subdivide";
+		}
+		else if (option == "--symmetry") {
+			if (value != "on" && value != "off") {
+				throw std::invalid_argument("--symmetry must be on or off");
+			}
+			renderer.symmetry = value == "on";
+		}
+		else if (option == "--tile-size") {
+			renderer.tileSize = std::stoi(value);
+			if (renderer.tileSize < 3) {
+				throw std::invalid_argument("--tile-size must be greater than 2");
+			}
+		}
+		else if (option == "--perturbation") {
+			if (value == "auto") {
+				renderer.perturbationMode = PERTURBATION_AUTO;
+			}
+			else if (value == "on") {
+				renderer.perturbationMode = PERTURBATION_ON;
+			}
+			else if (value == "off") {
+				renderer.perturbationMode = PERTURBATION_OFF;
+			}
+			else {
+				throw std::invalid_argument("--perturbation must be auto, on or off");
+			}
+		}
+		else if (option == "--precision") {
+			int i = PRECISION_AUTO;
+			while (i <= PRECISION_DOUBLE_DOUBLE && value != GetPrecisionName((PrecisionType)i)) {
+				i++;
+			}
+			if (i > PRECISION_DOUBLE_DOUBLE) {
+				throw std::invalid_argument("--precision must be auto, float, double or double-double");
+			}
+			renderer.precisionMode = (PrecisionType)i;
+		}
+		else if (option == "--max-iteration") {
+			renderer.maxIteration = std::stoi(value);
+			if (renderer.maxIteration < 1) {
+				throw std::invalid_argument("--max-iteration must be greater than 0");
+			}
+		}
+		else if (option == "--passes") {
+			renderer.passes = std::stoi(value);
+			if (renderer.passes < 1 || renderer.passes > maxPasses) {
+				throw std::invalid_argument("--passes must be between 1 and " + std::to_string(maxPasses));
+			}
+		}
+		else if (option == "--cache-size") {
+			options.cacheSize = std::stoi(value);
+			if (options.cacheSize < 0) {
+				throw std::invalid_argument("--cache-size must be 0 or greater");
+			}
+		}
+		else if (option == "--cache-directory") {
+			options.cacheDirectory = value;
+		}
+		else if (option == "--fractal") {
+			if (value == "mandelbrot") {
+				renderer.fractal.type = FRACTAL_MANDELBROT;
+			}
+			else if (value == "julia") {
+				renderer.fractal.type = FRACTAL_JULIA;
+			}
+			else if (value == "burning-ship") {
+				renderer.fractal.type = FRACTAL_BURNING_SHIP;
+			}
+			else {
+				throw std::invalid_argument("--fractal must be mandelbrot, julia or burning-ship");
+			}
+		}
+		else if (option == "--power") {
+			renderer.fractal.power = std::stoi(value);
+			if (renderer.fractal.power < minFractalPower || renderer.fractal.power > maxFractalPower) {
+				throw std::invalid_argument("--power must be between " + std::to_string(minFractalPower) + " and " + std::to_string(maxFractalPower));
+			}
+		}
+		else if (option == "--julia") {
+			size_t separator = value.find(',');
+			if (separator == std::string::npos) {
+				throw std::invalid_argument("--julia must be X,Y");
+			}
+			renderer.fractal.juliaReal = std::stod(value.substr(0, separator));
+			renderer.fractal.juliaImag = std::stod(value.substr(separator + 1));
+			if (!AreFractalParametersValid(renderer.fractal)) {
+				throw std::invalid_argument("The modulus of --julia must be at most 2");
+			}
+		}
+		else if (option == "--color-mode") {
+			if (value != "smooth" && value != "bands") {
+				throw std::invalid_argument("--color-mode must be smooth or bands");
+			}
+			renderer.fractal.colorMode = value == "smooth" ? COLOR_SMOOTH : COLOR_BANDS;
+		}
+		else if (option == "--benchmark") {
+			options.benchmark.path = value;
+		}
+		else if (option == "--antialias") {
+			renderer.antialiasSamples = std::stoi(value);
+			if (renderer.antialiasSamples < 0 || renderer.antialiasSamples > 64) {
+				throw std::invalid_argument("--antialias must be between 0 and 64");
+			}
+		}
+		else if (option == "--antialias-threshold") {
+			renderer.antialiasThreshold = std::stof(value);
+			if (renderer.antialiasThreshold < 0) {
+				throw std::invalid_argument("--antialias-threshold must be 0 or greater");
+			}
+		}
+		else if (option == "--size") {
+			size_t separator = value.find('x');
+			if (separator == std::string::npos) {
+				throw std::invalid_argument("--size must be WIDTHxHEIGHT");
+			}
+			renderer.pixelWidth = std::stoi(value.substr(0, separator));
+			renderer.pixelHeight = std::stoi(value.substr(separator + 1));
+		}
+		else if (option == "--animation") {
+			options.animationPath = value;
+		}
+		else if (option == "--animation-output") {
+			options.animationDirectory = value;
+		}
+		else if (option == "--batch") {
+			options.batchPath = value;
+		}
+		else if (option == "--output") {
+			options.output.path = value;
+		}
+		else if (option == "--output-format") {
+			if (!FindImageLayout(value, &options.output.layout)) {
+				throw std::invalid_argument("--output-format must be raw or tiled");
+			}
+		}
+		else if (option == "--checkpoint") {
+			options.output.checkpointDirectory = value;
+		}
+		else if (option == "--output-tile-size") {
+			options.output.tileSize = std::stoi(value);
+			if (options.output.tileSize < 1 || options.output.tileSize > 8192) {
+				throw std::invalid_argument("--output-tile-size must be between 1 and 8192");
+			}
+		}
+		else if (option == "--trace") {
+			options.tracePath = value;
+		}
+		else if (option == "--benchmark-repeat") {
+			options.benchmark.repeat = std::stoi(value);
+			if (options.benchmark.repeat < 1) {
+				throw std::invalid_argument("--benchmark-repeat must be greater than 0");
+			}
+		}
+		else if (option == "--benchmark-suites") {
+			options.benchmark.suites = value;
+		}
+		else if (option == "--palette") {
+			if (!FindPalette(value, &renderer.palette)) {
+				throw std::invalid_argument("--palette must be linear, sqrt, histogram or cyclic");
+			}
+		}
+		else if (option == "--threads") {
+			threadCount = std::stoi(value);
+			if (threadCount < 0) {
+				throw std::invalid_argument("--threads must be 0 or greater");
+			}
+		}
+		else if (option == "--kernel") {
+			if (value == "auto") {
+				kernel = KERNEL_AUTO;
+			}
+			else if (value == "scalar") {
+				kernel = KERNEL_SCALAR;
+			}
+			else if (value == "avx2") {
+				kernel = KERNEL_AVX2;
+			}
+			else if (value == "avx512") {
+				kernel = KERNEL_AVX512;
+			}
+			else {
+				throw std::invalid_argument("--kernel must be auto, scalar, avx2 or avx512");
+			}
+		}
+		else {
+			throw std::invalid_argument("Unknown option " + option);
+		}
 	}
 
-	// Save Mandelbrot image as a file
-#if defined(WIN32) || defined(_WIN32) || defined(__WIN32) && !defined(__CYGWIN__)
-	std::string path = std::filesystem::temp_directory_path().string() + "Mandelbrot.bmp";
-#else
-	std::string path = "/tmp/Mandelbrot.bmp";
-#endif
-	SDL_SaveBMP(surface, path.c_str());
-#if !defined(WIN32) && !defined(_WIN32) && !defined(__WIN32) || defined(__CYGWIN__)
-	// Use chmod to give all permissions to everyone
-	// By default only the current user has write rights, which stops us from using the same machine as different users
-	std::string chmodCommande = "chmod 777 " + path;
-	system(chmodCommande.c_str());
-#endif
-	std::cout << "Mandelbrot image saved in " << path << std::endl;
-	std::cout << "--------------------------------------------------" << std::endl;
-}
-
-
-
-/// <summary>
-/// This method calculates the color of a pixel and returns it.
-/// The pixel is black if the sequence converge.
-/// The pixel is in other colors (gray scale) if the sequence diverge.
-/// </summary>
-/// <param name="iXpos">X position of the pixel</param>
-/// <param name="iYpos">Y position of the pixel</param>
-/// <param name="pixelWidth">number of pixels in width</param>
-/// <param name="pixelHeight">number of pixels in height</param>
-/// <param name="minRangeX">minimum range of the X axis</param>
-/// <param name="maxRangeX">maximum range of the X axis</param>
-/// <param name="minRangeY">minimum range of the Y axis</param>
-/// <param name="maxRangeY">maximum range of the Y axis</param>
-/// <returns>color of the pixel</returns>
-color GetPixelColor(int iXpos, int iYpos, int pixelWidth, int pixelHeight, double minRangeX, double maxRangeX, double minRangeY, double maxRangeY)
-{
-	// Calculate if Mandelbrot sequence diverge
-
-	double rangeXPos = (double)iXpos / (double)pixelWidth * (maxRangeX - minRangeX) + minRangeX;
-	double rangeYPos = (double)iYpos / (double)pixelHeight * (maxRangeY - minRangeY) + minRangeY;
-
-	Complex c = Complex(rangeXPos, rangeYPos);
-	Complex z = Complex(0, 0);
-
-	int iteration = 0;
-	const int maxIteration = 1000;
-	while (iteration < maxIteration && z.Modulus() <= 2) // AND Z mod 2 < 2
-	{
-		// Max iteration --> If not diverge
-		// z mod 2 < 2 --> If diverge
-		z = z.NextIteration(c);
-		iteration++;
+	if (!SetKernel(kernel)) {
+		throw std::invalid_argument("The CPU doesn't support the requested kernel");
 	}
-	if (iteration == maxIteration)
-	{
-		return color{ 0, 0, 0 };
+	if (!options.output.checkpointDirectory.empty() && options.output.path.empty()) {
+		throw std::invalid_argument("--checkpoint can only be used with --output");
 	}
-	else
-	{
-		// Color smoothing Mandelbrot (a little bit)
-		double log_zn = log(z.Modulus());
-		double nu = log(log_zn / log(2)) / log(2);
-		iteration = iteration + 1 - (int)nu;
 
-		// Gray gradient with color smoothing
-		int colorValue = (int)(255.0 * sqrt((double)iteration / (double)maxIteration));
-		return color{ colorValue, colorValue, colorValue };
-	}
+	renderer.StartThreads(threadCount);
 }
@@ -0,0 +1,1192 @@
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <mpi.h>
+#include <SDL/SDL.h>
+
+#include "FractalRenderer.h"
+#include "Schedules.h"
+
+
+/// <summary>
+/// Width or height under which a rectangle of the subdivision is calculated pixel by pixel instead of being split again
+/// </summary>
+constexpr int subdivideMinSize = 6;
+
+/// <summary>
+/// Number of positions of the subsamples on each axis of a pixel, the kernels only calculating whole pixels
+/// the subsamples are pixels of an image antialiasGrid times bigger
+/// </summary>
+constexpr int antialiasGrid = 16;
+
+/// <summary>
+/// Start the threads calculating the pixels of the current rank, replacing the ones already started
+/// </summary>
+/// <param name="count">number of threads, 0 for GetDefaultThreadCount</param>
+void FractalRenderer::StartThreads(int count)
+{
+	threadPool.reset();
+	threadPool = std::make_unique<ThreadPool>(count > 0 ? count : GetDefaultThreadCount());
+}
+
+/// <summary>
+/// Calculate the smooth iteration counts of the current viewport with every rank, then color and save the image.
+/// With the progressive rendering, the image is colored and saved after each pass, every calculated pixel filling
+/// the square of passStep * passStep pixels under it until the next passes calculate them.
+/// With the tile cache, the tiles found in the cache are copied in the image and the schedules only calculate the missing ones.
+/// Otherwise, when the image straddles the real axis of a fractal symmetric about it, the schedules only calculate the rows
+/// on the largest side of the axis, and rank 0 copies them to the rows of the other side.
+/// A frame cancelled by the render server stops at the end of the current pass, frameCancelled is then true.
+/// </summary>
+/// <param name="rank">rank of the current process</param>
+/// <param name="numtasks">number of MPI ranks</param>
+/// <param name="coarsePassDone">called on rank 0 once each pass but the last one is saved, can be empty</param>
+void FractalRenderer::RenderFrame(int rank, int numtasks, const std::function<void()>& coarsePassDone)
+{
+	engine = GetFractalEngine(fractal);
+	SetFormulaKernel(engine.escapeTimeRow);
+	phaseTrace.NextFrame();
+	frameCancelled = false;
+
+	if (rank == 0) {
+		std::cout << "Calculating the " << GetFractalName(fractal.type);
+		if (fractal.power != 2) {
+			std::cout << " of power " << fractal.power;
+		}
+		if (fractal.type == FRACTAL_JULIA) {
+			std::cout << " of c = " << fractal.juliaReal << " + " << fractal.juliaImag << "i";
+		}
+		std::cout << " with the " << GetKernelName() << " kernel and " << threadPool->GetThreadCount() << " threads per rank" << std::endl;
+		std::cout << "--------------------------------------------------" << std::endl;
+		iterationBuffer.resize((size_t)pixelWidth * pixelHeight);
+	}
+
+	PrepareReferenceOrbit(rank);
+	PreparePrecision(rank);
+	if (rank == 0 && !referenceReal.empty()) {
+		std::cout << "Perturbation from a reference orbit of " << referenceReal.size() - 1 << " iterations calculated with "
+			<< 32 * BigFloat::FractionLimbsFor(std::min(rangeWidth / pixelWidth, rangeHeight / pixelHeight)) << " bits" << std::endl;
+	}
+	else if (rank == 0) {
+		std::cout << "Pixels calculated in " << GetPrecisionName(GetPrecision()) << ", " << GetRelativeSpacing() << " apart relative to the center" << std::endl;
+	}
+
+	PrepareWorkTiles(rank);
+	frameStatistics = { 0, 0, 0, 0, 0 };
+
+	// The tiles of the subdivision need the full resolution, and there is nothing to show progressively when every tile is cached
+	int framePasses = subdivide || workHeight == 0 ? 1 : passes;
+	for (int pass = 0; pass < framePasses; pass++) {
+		passStep = 1 << (framePasses - 1 - pass);
+		passReuse = pass > 0;
+		passWidth = (workWidth + passStep - 1) / passStep;
+		passHeight = (workHeight + passStep - 1) / passStep;
+
+		// Smooth iteration counts of the pass assembled by rank 0, straight in the work image when it's calculated in one pass
+		float* iterations = nullptr;
+		if (rank == 0) {
+			if (framePasses > 1) {
+				std::cout << "Pass " << pass + 1 << " of " << framePasses << ", 1 pixel out of " << passStep * passStep << std::endl;
+				passBuffer.resize((size_t)passWidth * passHeight);
+				iterations = passBuffer.data();
+			}
+			else {
+				iterations = GetWorkBuffer();
+			}
+		}
+
+		// Work done by this rank
+		rankStatistics statistics = { 0, 0, 0, 0, 0 };
+		kernelIterations = 0;
+		if (dynamicSchedule) {
+			if (rank == 0) {
+				RunDynamicMaster(*this, iterations, numtasks, &statistics);
+			}
+			else {
+				RunDynamicWorker(*this, &statistics);
+			}
+		}
+		else {
+			RunStaticSchedule(*this, rank, numtasks, iterations, &statistics);
+		}
+		if (framePasses > 1) {
+			// A worker of the dynamic schedule mustn't ask rank 0 for work of the next pass while it still hands out this one
+			double waitStart = phaseTrace.Now();
+			MPI_Barrier(MPI_COMM_WORLD);
+			phaseTrace.Add(PHASE_WAIT, waitStart, 0);
+		}
+		if (ShareFrameCancellation()) {
+			break; // The pixels of the pass are incomplete, the image keeps the previous pass
+		}
+
+		statistics.iterations = (double)kernelIterations;
+		rankStatistics passStatistics = ReportStatistics(*this, rank, numtasks, statistics);
+		frameStatistics.busyTime += passStatistics.busyTime;
+		frameStatistics.chunks += passStatistics.chunks;
+		frameStatistics.pixels += passStatistics.pixels;
+		frameStatistics.iteratedPixels += passStatistics.iteratedPixels;
+		frameStatistics.iterations += passStatistics.iterations;
+
+		if (rank == 0) {
+			double assembleStart = phaseTrace.Now();
+			if (framePasses > 1) {
+				StorePass();
+			}
+			if (cachedFrame) {
+				for (size_t i = 0; i < workTileKeys.size(); i++) {
+					const float* tileIterations = tileBuffer.data() + i * cacheTileSize * cacheTileSize;
+					CopyTileToImage(tileIterations, workTiles[2 * i], workTiles[2 * i + 1]);
+					if (pass == framePasses - 1) {
+						tileCache.Insert(workTileKeys[i], tileIterations);
+					}
+				}
+			}
+			if (!workRows.empty()) {
+				CopyRowsToImage();
+			}
+			if (!mirroredRows.empty()) {
+				MirrorRows();
+			}
+			if (framePasses > 1 || cachedFrame || !mirroredRows.empty()) {
+				phaseTrace.Add(PHASE_ASSEMBLE, assembleStart, (double)workWidth * workHeight);
+			}
+		}
+		if (pass == framePasses - 1) {
+			RefineEdges(rank, numtasks);
+		}
+		if (rank == 0) {
+			ColorizeFrame();
+			if (pass < framePasses - 1 && coarsePassDone) {
+				coarsePassDone();
+			}
+		}
+	}
+	passStep = 1;
+	passReuse = false;
+	workRows.clear();
+	mirroredRows.clear();
+}
+
+/// <summary>
+/// Set the area of the complex plane from its ranges written in decimal, keeping all their digits
+/// </summary>
+/// <param name="minX">minRangeX</param>
+/// <param name="maxX">maxRangeX</param>
+/// <param name="minY">minRangeY</param>
+/// <param name="maxY">maxRangeY</param>
+void FractalRenderer::SetViewport(const std::string& minX, const std::string& maxX, const std::string& minY, const std::string& maxY)
+{
+	// About 3.3 bits per decimal digit
+	size_t digits = std::max({ minX.size(), maxX.size(), minY.size(), maxY.size() });
+	int fractionLimbs = (int)(digits * 10 / 3 / 32) + 2;
+
+	BigFloat ranges[4];
+	const std::string* texts[4] = { &minX, &maxX, &minY, &maxY };
+	for (int i = 0; i < 4; i++) {
+		if (!BigFloat::Parse(*texts[i], fractionLimbs, &ranges[i])) {
+			throw std::invalid_argument("Invalid range " + *texts[i]);
+		}
+	}
+
+	centerX = (ranges[0] + ranges[1]).Half();
+	centerY = (ranges[2] + ranges[3]).Half();
+	rangeWidth = (ranges[1] - ranges[0]).ToDouble();
+	rangeHeight = (ranges[3] - ranges[2]).ToDouble();
+	minRangeX = ranges[0].ToDouble();
+	maxRangeX = ranges[1].ToDouble();
+	minRangeY = ranges[2].ToDouble();
+	maxRangeY = ranges[3].ToDouble();
+}
+
+/// <summary>
+/// Choose if the current frame uses the perturbation, and if so calculate the reference orbit on rank 0 and send it to every rank
+/// </summary>
+/// <param name="rank">rank of the current process</param>
+void FractalRenderer::PrepareReferenceOrbit(int rank)
+{
+	double spacing = std::min(rangeWidth / pixelWidth, rangeHeight / pixelHeight);
+	// The reference orbit is the one of the Mandelbrot set of power 2, the other fractals are calculated in double-double
+	// when they are too deep for a double. The perturbation is faster, it's only replaced by double-double when asked.
+	bool perturbation = engine.escapeTimeRow == nullptr && (perturbationMode == PERTURBATION_ON
+		|| (perturbationMode == PERTURBATION_AUTO && precisionMode != PRECISION_DOUBLE_DOUBLE && GetRelativeSpacing() < perturbationSpacing));
+
+	referenceReal.clear();
+	referenceImag.clear();
+	if (!perturbation) {
+		return;
+	}
+
+	if (rank == 0) {
+		ComputeReferenceOrbit(spacing);
+	}
+	int length = (int)referenceReal.size();
+	MPI_Bcast(&length, 1, MPI_INT, 0, MPI_COMM_WORLD);
+	referenceReal.resize(length);
+	referenceImag.resize(length);
+	MPI_Bcast(referenceReal.data(), length, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+	MPI_Bcast(referenceImag.data(), length, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+	reference = { referenceReal.data(), referenceImag.data(), length, rangeWidth, rangeHeight };
+}
+
+/// <summary>
+/// Choose the precision of the current frame, the lowest one telling two pixels apart with PRECISION_AUTO,
+/// and send the center of the image in double-double to every rank when it's needed.
+/// The perturbation calculates the differences with the reference orbit in double.
+/// </summary>
+/// <param name="rank">rank of the current process</param>
+void FractalRenderer::PreparePrecision(int rank)
+{
+	PrecisionType precision = precisionMode;
+	if (!referenceReal.empty()) {
+		precision = PRECISION_DOUBLE;
+	}
+	else if (precision == PRECISION_AUTO) {
+		double relativeSpacing = GetRelativeSpacing();
+		precision = relativeSpacing >= floatSpacing ? PRECISION_FLOAT : relativeSpacing >= perturbationSpacing ? PRECISION_DOUBLE : PRECISION_DOUBLE_DOUBLE;
+	}
+	// Only the kernels of the Mandelbrot set of power 2 have a float version
+	if (precision == PRECISION_FLOAT && engine.escapeTimeRow != nullptr) {
+		precision = PRECISION_DOUBLE;
+	}
+	SetPrecision(precision);
+	SetFormulaKernel(precision == PRECISION_DOUBLE_DOUBLE ? engine.escapeTimeRowDoubleDouble : engine.escapeTimeRow);
+
+	if (precision == PRECISION_DOUBLE_DOUBLE) {
+		// Only rank 0 knows the exact center of the frames of the render server
+		if (rank == 0) {
+			int fractionLimbs = std::max({ 4, centerX.GetFractionLimbs(), centerY.GetFractionLimbs() });
+			preciseCenterX[0] = centerX.ToDouble();
+			preciseCenterX[1] = (centerX - BigFloat(preciseCenterX[0], fractionLimbs)).ToDouble();
+			preciseCenterY[0] = centerY.ToDouble();
+			preciseCenterY[1] = (centerY - BigFloat(preciseCenterY[0], fractionLimbs)).ToDouble();
+		}
+		double center[4] = { preciseCenterX[0], preciseCenterX[1], preciseCenterY[0], preciseCenterY[1] };
+		MPI_Bcast(center, 4, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+		preciseCenterX[0] = center[0];
+		preciseCenterX[1] = center[1];
+		preciseCenterY[0] = center[2];
+		preciseCenterY[1] = center[3];
+	}
+}
+
+/// <summary>
+/// Get the distance between two pixels of the current frame relative to the magnitude of its center,
+/// which tells how many significant digits are needed to tell them apart
+/// </summary>
+/// <returns>smallest distance between two pixels divided by the magnitude of the center, at least 1</returns>
+double FractalRenderer::GetRelativeSpacing() const
+{
+	double spacing = std::min(rangeWidth / pixelWidth, rangeHeight / pixelHeight);
+	double centerMagnitude = std::max({ 1.0, fabs(minRangeX + maxRangeX) / 2, fabs(minRangeY + maxRangeY) / 2 });
+	return spacing / centerMagnitude;
+}
+
+/// <summary>
+/// Calculate the Mandelbrot sequence of the center of the image at full precision, until it diverges or maxIteration.
+/// Only rounding the values of z to double loses precision, not the calculation of the sequence.
+/// </summary>
+/// <param name="spacing">distance between two pixels, to choose the precision</param>
+void FractalRenderer::ComputeReferenceOrbit(double spacing)
+{
+	int fractionLimbs = std::max({ BigFloat::FractionLimbsFor(spacing), centerX.GetFractionLimbs(), centerY.GetFractionLimbs() });
+	BigFloat real(0, fractionLimbs);
+	BigFloat imag(0, fractionLimbs);
+
+	for (int iteration = 0; ; iteration++) {
+		double z[2] = { real.ToDouble(), imag.ToDouble() };
+		referenceReal.push_back(z[0]);
+		referenceImag.push_back(z[1]);
+		if (iteration == maxIteration || z[0] * z[0] + z[1] * z[1] > escapeModulusSquared) {
+			break;
+		}
+
+		BigFloat realImag = real * imag;
+		real = real * real - imag * imag + centerX;
+		imag = realImag + realImag + centerY;
+	}
+}
+
+/// <summary>
+/// Get the area of the complex plane of the current frame, as given to the escape-time kernel
+/// </summary>
+/// <returns>viewport of the current frame</returns>
+viewport FractalRenderer::GetViewport() const
+{
+	return { pixelWidth, pixelHeight, minRangeX, maxRangeX, minRangeY, maxRangeY, referenceReal.empty() ? nullptr : &reference, passStep,
+		fractal.juliaReal, fractal.juliaImag, { preciseCenterX[0], preciseCenterX[1] }, { preciseCenterY[0], preciseCenterY[1] }, rangeWidth, rangeHeight };
+}
+
+/// <summary>
+/// Get the number of threads to use in each rank to use every core of the node without oversubscribing it,
+/// the cores being shared between the ranks running on the same node
+/// </summary>
+/// <returns>number of threads per rank</returns>
+int GetDefaultThreadCount()
+{
+	MPI_Comm nodeComm;
+	MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &nodeComm);
+	int ranksOnNode;
+	MPI_Comm_size(nodeComm, &ranksOnNode);
+	MPI_Comm_free(&nodeComm);
+
+	int cores = (int)std::thread::hardware_concurrency(); // 0 if unknown
+	return std::max(1, cores / ranksOnNode);
+}
+
+/// <summary>
+/// Whether rank 0 calculates a share of the image, always when it's the only rank
+/// </summary>
+/// <param name="numtasks">number of MPI ranks</param>
+/// <returns>false if rank 0 is only the coordinator of the other ranks</returns>
+bool FractalRenderer::RankZeroComputes(int numtasks) const
+{
+	return !coordinator || numtasks == 1;
+}
+
+/// <summary>
+/// Get the number of rows in a chunk of the dynamic schedule
+/// </summary>
+/// <returns>chunkRows, or the height of a row of tiles with the subdivision</returns>
+int FractalRenderer::GetChunkRows() const
+{
+	return subdivide ? tileSize : chunkRows;
+}
+
+/// <summary>
+/// Check whether the frame being calculated is cancelled, called by the main thread of each rank before each chunk.
+/// Rank 0 asks cancelRequested and tells the other ranks with TAG_CANCEL, which they look for without waiting.
+/// The ranks still send the chunks they skip, so the schedules end as usual, only sooner.
+/// </summary>
+/// <returns>true if the rest of the frame mustn't be calculated</returns>
+bool FractalRenderer::IsFrameCancelled()
+{
+	if (!cancellable || frameCancelled) {
+		return frameCancelled;
+	}
+
+	int rank, numtasks;
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+	MPI_Comm_size(MPI_COMM_WORLD, &numtasks);
+	if (rank == 0) {
+		if (cancelRequested && cancelRequested()) {
+			frameCancelled = true;
+			for (int i = 1; i < numtasks; i++) {
+				MPI_Send(nullptr, 0, MPI_BYTE, i, TAG_CANCEL, MPI_COMM_WORLD);
+			}
+		}
+	}
+	else {
+		int cancelled = 0;
+		MPI_Iprobe(0, TAG_CANCEL, MPI_COMM_WORLD, &cancelled, MPI_STATUS_IGNORE);
+		if (cancelled) {
+			MPI_Recv(nullptr, 0, MPI_BYTE, 0, TAG_CANCEL, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+			frameCancelled = true;
+		}
+	}
+	return frameCancelled;
+}
+
+/// <summary>
+/// Make every rank agree at the end of a pass on whether the frame is cancelled,
+/// a rank may have finished its part before rank 0 cancelled the frame
+/// </summary>
+/// <returns>true if the frame is cancelled</returns>
+bool FractalRenderer::ShareFrameCancellation()
+{
+	if (!cancellable) {
+		return false;
+	}
+
+	int cancelled = frameCancelled ? 1 : 0;
+	MPI_Bcast(&cancelled, 1, MPI_INT, 0, MPI_COMM_WORLD);
+	if (cancelled && !frameCancelled) {
+		// The message of rank 0 hasn't been read yet
+		MPI_Recv(nullptr, 0, MPI_BYTE, 0, TAG_CANCEL, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+	}
+	frameCancelled = cancelled != 0;
+	return frameCancelled;
+}
+
+/// <summary>
+/// Calculate the smooth iteration count of every pixel of consecutive rows of the grid of the current pass.
+/// With the subdivision the rows are split in tiles of tileSize * tileSize pixels shared between the threads of the pool.
+/// </summary>
+/// <param name="firstRow">index of the first row to calculate</param>
+/// <param name="rowCount">number of rows to calculate</param>
+/// <param name="rowIterations">row-major array of rowCount * passWidth smooth iteration counts filled with the result, left as it is when the frame is cancelled</param>
+/// <returns>number of pixels calculated by the kernel, the others were filled by the subdivision</returns>
+long long FractalRenderer::ComputeRows(int firstRow, int rowCount, float* rowIterations)
+{
+	if (IsFrameCancelled()) {
+		return 0;
+	}
+	if (!subdivide) {
+		ComputePixels(firstRow * passWidth, rowCount * passWidth, rowIterations);
+		return (long long)rowCount * passWidth;
+	}
+
+	int tilesPerRow = (pixelWidth + tileSize - 1) / tileSize;
+	int tileRows = (rowCount + tileSize - 1) / tileSize;
+	std::vector<long long> iteratedPixels(tilesPerRow * tileRows);
+	threadPool->ParallelFor(tilesPerRow * tileRows, [&](int task) {
+		int left = task % tilesPerRow * tileSize;
+		int top = task / tilesPerRow * tileSize;
+		iteratedPixels[task] = ComputeTile(left, firstRow + top, std::min(tileSize, pixelWidth - left), std::min(tileSize, rowCount - top),
+			rowIterations + (size_t)top * pixelWidth + left);
+	});
+
+	long long sum = 0;
+	for (long long pixels : iteratedPixels) {
+		sum += pixels;
+	}
+	return sum;
+}
+
+/// <summary>
+/// Calculate the smooth iteration count of consecutive pixels, the grid of the current pass being read row by row.
+/// The pixels are split in parts of rows of at most taskPixels pixels shared between the threads of the pool,
+/// each part is given to the escape-time kernel in one call so it can calculate several pixels at once.
+/// The pixels reused from the previous pass are skipped, their smooth iteration count is left as it is.
+/// </summary>
+/// <param name="firstPixel">index of the first pixel to calculate in the grid of the pass</param>
+/// <param name="count">number of pixels to calculate</param>
+/// <param name="localIterations">array of count smooth iteration counts filled with the result, left as it is when the frame is cancelled</param>
+void FractalRenderer::ComputePixels(int firstPixel, int count, float* localIterations)
+{
+	if (IsFrameCancelled()) {
+		return;
+	}
+	const viewport view = GetViewport();
+
+	// First pixel of each task, the last one ending at the end of a row or of the pixels to calculate
+	std::vector<int> taskFirstPixels;
+	int endPixel = firstPixel + count;
+	for (int pixel = firstPixel; pixel < endPixel;)
+	{
+		taskFirstPixels.push_back(pixel);
+		int rowEnd = (pixel / passWidth + 1) * passWidth;
+		pixel = std::min({ pixel + taskPixels, rowEnd, endPixel });
+	}
+	taskFirstPixels.push_back(endPixel);
+
+	threadPool->ParallelFor((int)taskFirstPixels.size() - 1, [&](int task) {
+		int pixel = taskFirstPixels[task];
+		int taskCount = taskFirstPixels[task + 1] - pixel;
+		int row = pixel / passWidth;
+		int column = pixel % passWidth;
+		int iterations[taskPixels];
+		double modulusSquared[taskPixels];
+
+		// In the even rows of a pass reusing the previous one, only the odd columns are new
+		int firstColumn = column;
+		int stride = 1;
+		if (passReuse && row % 2 == 0) {
+			firstColumn = column | 1;
+			stride = 2;
+		}
+		int newCount = (column + taskCount - firstColumn + stride - 1) / stride;
+		viewport taskView = view;
+		taskView.columnStep = stride * passStep;
+
+		// Position of the row in the image, the rows of the work image being stacked tiles with the tile cache or the rows not mirrored
+		int workRow = row * passStep;
+		int imageRow = workRows.empty() ? workRow : workRows[workRow];
+		int imageColumn = 0;
+		if (cachedFrame) {
+			int workTile = workRow / cacheTileSize;
+			imageRow = workTiles[2 * workTile + 1] + workRow % cacheTileSize;
+			imageColumn = workTiles[2 * workTile];
+		}
+
+		EscapeTimeRow(taskView, imageRow, imageColumn + firstColumn * passStep, newCount, maxIteration, iterations, modulusSquared);
+		long long taskIterations = 0;
+		for (int i = 0; i < newCount; i++)
+		{
+			localIterations[pixel - firstPixel + firstColumn - column + i * stride] = GetSmoothIteration(iterations[i], modulusSquared[i]);
+			taskIterations += iterations[i];
+		}
+		kernelIterations += taskIterations;
+	});
+}
+
+/// <summary>
+/// Calculate the smooth iteration count of every pixel of a rectangle of the image at full resolution,
+/// each row being split in parts of at most taskPixels pixels shared between the threads of the pool
+/// </summary>
+/// <param name="left">X position of the first column of the rectangle in the image</param>
+/// <param name="top">Y position of the first row of the rectangle in the image</param>
+/// <param name="width">width of the rectangle in pixels</param>
+/// <param name="height">height of the rectangle in pixels</param>
+/// <param name="stride">distance between two rows of the rectangle in regionIterations</param>
+/// <param name="regionIterations">smooth iteration counts of the rectangle filled with the result, row by row</param>
+void FractalRenderer::ComputeRegion(int left, int top, int width, int height, int stride, float* regionIterations)
+{
+	const viewport view = GetViewport();
+	int rowParts = (width + taskPixels - 1) / taskPixels;
+
+	threadPool->ParallelFor(rowParts * height, [&](int task) {
+		int row = task / rowParts;
+		int column = task % rowParts * taskPixels;
+		int count = std::min(taskPixels, width - column);
+		int iterations[taskPixels];
+		double modulusSquared[taskPixels];
+
+		EscapeTimeRow(view, top + row, left + column, count, maxIteration, iterations, modulusSquared);
+		long long taskIterations = 0;
+		float* target = regionIterations + (size_t)row * stride + column;
+		for (int i = 0; i < count; i++)
+		{
+			target[i] = GetSmoothIteration(iterations[i], modulusSquared[i]);
+			taskIterations += iterations[i];
+		}
+		kernelIterations += taskIterations;
+	});
+}
+
+/// <summary>
+/// Copy the pixels calculated by the current pass from passBuffer to the work image,
+/// each one filling the square of passStep * passStep pixels under it so the image can be displayed before the next passes
+/// </summary>
+void FractalRenderer::StorePass()
+{
+	float* work = GetWorkBuffer();
+	threadPool->ParallelFor(passHeight, [&](int row) {
+		int top = row * passStep;
+		int bottom = std::min(top + passStep, workHeight);
+		for (int column = 0; column < passWidth; column++) {
+			if (passReuse && row % 2 == 0 && column % 2 == 0) {
+				continue; // Calculated by the previous pass, its square is already filled
+			}
+			float value = passBuffer[(size_t)row * passWidth + column];
+			int left = column * passStep;
+			int right = std::min(left + passStep, workWidth);
+			for (int y = top; y < bottom; y++) {
+				std::fill(work + (size_t)y * workWidth + left, work + (size_t)y * workWidth + right, value);
+			}
+		}
+	});
+}
+
+/// <summary>
+/// Find the grid of tiles of the current frame in the tile cache
+/// </summary>
+/// <param name="grid">filled with the key of the tiles of the frame, without their position</param>
+/// <param name="originX">filled with the column of the grid of the first column of the image</param>
+/// <param name="originY">filled with the row of the grid of the first row of the image</param>
+/// <returns>false if the frame can't use the cache</returns>
+bool FractalRenderer::GetTileGrid(tileKey* grid, long long* originX, long long* originY)
+{
+	// The tiles of the subdivision are interpolated, and the ranges of the deep zooms are too imprecise to place them in the grid
+	if (!tileCache.IsEnabled() || subdivide || !referenceReal.empty()) {
+		return false;
+	}
+
+	// Position of the first pixel in 1/256 of a pixel from 0
+	double spacingX = rangeWidth / pixelWidth;
+	double spacingY = rangeHeight / pixelHeight;
+	double positionX = minRangeX / spacingX * 256;
+	double positionY = minRangeY / spacingY * 256;
+	if (!(fabs(positionX) < 1e15 && fabs(positionY) < 1e15)) {
+		return false;
+	}
+	long long subpixelX = llround(positionX);
+	long long subpixelY = llround(positionY);
+	int phaseX = (int)(((subpixelX % 256) + 256) % 256);
+	int phaseY = (int)(((subpixelY % 256) + 256) % 256);
+	*originX = (subpixelX - phaseX) / 256;
+	*originY = (subpixelY - phaseY) / 256;
+
+	// The precision changes the iteration counts a little, the tiles of another precision aren't used
+	*grid = { spacingX, spacingY, 0, 0, phaseX, phaseY, maxIteration, HashFractalParameters(fractal) ^ ((uint32_t)GetPrecision() << 24) };
+	return true;
+}
+
+/// <summary>
+/// Choose what the schedules calculate for the current frame, the rows mirrored across the real axis being copied afterwards.
+/// With the tile cache, rank 0 copies the tiles of the frame found in the cache in the image,
+/// and every rank gets the position of the missing tiles which are stacked in the work image, without the tiles only made of mirrored rows.
+/// Otherwise the work image is the image, or its rows not mirrored stacked when some are.
+/// </summary>
+/// <param name="rank">rank of the current process</param>
+void FractalRenderer::PrepareWorkTiles(int rank)
+{
+	workTiles.clear();
+	workTileKeys.clear();
+	workRows.clear();
+
+	PrepareMirroredRows(rank);
+	std::vector<bool> mirrored(pixelHeight);
+	for (int row : mirroredRows) {
+		mirrored[row] = true;
+	}
+
+	int useCache = 0;
+	if (rank == 0) {
+		tileKey grid;
+		long long originX, originY;
+		useCache = GetTileGrid(&grid, &originX, &originY);
+		if (useCache) {
+			uint64_t hits = tileCache.GetHits();
+			uint64_t diskHits = tileCache.GetDiskHits();
+			int mirroredTiles = 0;
+
+			// Tiles covering the image, the first and last ones can be partly outside of it
+			auto floorDivide = [](long long a, long long b) { return a / b - (a % b < 0 ? 1 : 0); };
+			std::vector<float> tileIterations((size_t)cacheTileSize * cacheTileSize);
+			for (long long tileY = floorDivide(originY, cacheTileSize); tileY <= floorDivide(originY + pixelHeight - 1, cacheTileSize); tileY++) {
+				for (long long tileX = floorDivide(originX, cacheTileSize); tileX <= floorDivide(originX + pixelWidth - 1, cacheTileSize); tileX++) {
+					tileKey key = grid;
+					key.tileX = tileX;
+					key.tileY = tileY;
+					int left = (int)(tileX * cacheTileSize - originX);
+					int top = (int)(tileY * cacheTileSize - originY);
+					bool onlyMirrored = !mirroredRows.empty();
+					for (int row = std::max(top, 0); row < std::min(top + cacheTileSize, pixelHeight) && onlyMirrored; row++) {
+						onlyMirrored = mirrored[row];
+					}
+					if (onlyMirrored) {
+						mirroredTiles++; // Copied by MirrorRows once the other tiles are in the image
+					}
+					else if (tileCache.Find(key, tileIterations.data())) {
+						CopyTileToImage(tileIterations.data(), left, top);
+					}
+					else {
+						workTiles.push_back(left);
+						workTiles.push_back(top);
+						workTileKeys.push_back(key);
+					}
+				}
+			}
+
+			std::cout << "Tile cache : " << tileCache.GetHits() - hits + tileCache.GetDiskHits() - diskHits << " tiles found ("
+				<< tileCache.GetDiskHits() - diskHits << " on disk), " << workTileKeys.size() << " to calculate, " << mirroredTiles << " mirrored, "
+				<< tileCache.GetTileCount() << " tiles in memory (" << (tileCache.GetMemoryBytes() >> 20) << " MB)" << std::endl;
+		}
+	}
+
+	int tileCount = (int)workTileKeys.size();
+	int header[2] = { useCache, tileCount };
+	MPI_Bcast(header, 2, MPI_INT, 0, MPI_COMM_WORLD);
+	cachedFrame = header[0] != 0;
+	workTiles.resize(2 * (size_t)header[1]);
+	MPI_Bcast(workTiles.data(), 2 * header[1], MPI_INT, 0, MPI_COMM_WORLD);
+
+	if (cachedFrame) {
+		workWidth = cacheTileSize;
+		workHeight = cacheTileSize * header[1];
+	}
+	else {
+		workWidth = pixelWidth;
+		workHeight = pixelHeight - (int)mirroredRows.size();
+		for (int row = 0; row < pixelHeight && !mirroredRows.empty(); row++) {
+			if (!mirrored[row]) {
+				workRows.push_back(row);
+			}
+		}
+	}
+	if (rank == 0 && (cachedFrame || !workRows.empty())) {
+		tileBuffer.resize((size_t)workWidth * workHeight);
+	}
+}
+
+/// <summary>
+/// Find the rows of the current frame mirrored across the real axis, once its precision is chosen.
+/// Rows r and r' are mirrors when the axis is halfway between them, and a row is only copied when its imaginary part,
+/// rounded like the kernel of the frame rounds it, is exactly the opposite of the one of its mirror, so the image is the one
+/// calculated without the symmetry. The frame isn't moved, so when the axis isn't on a row or halfway between two rows
+/// no row is copied, and in double some of the rows of the smallest side keep being calculated.
+/// </summary>
+/// <param name="rank">rank of the current process</param>
+void FractalRenderer::PrepareMirroredRows(int rank)
+{
+	mirroredRows.clear();
+	if (!symmetry || !IsConjugateSymmetric(fractal) || subdivide) {
+		return;
+	}
+
+	// The perturbation and the double-double place the pixels from the center of the image, they are only symmetric when it's on the axis
+	bool fromCenter = !referenceReal.empty() || GetPrecision() == PRECISION_DOUBLE_DOUBLE;
+	if (!referenceReal.empty() && std::any_of(referenceImag.begin(), referenceImag.end(), [](double imag) { return imag != 0; })) {
+		return;
+	}
+	if (referenceReal.empty() && GetPrecision() == PRECISION_DOUBLE_DOUBLE && (preciseCenterY[0] != 0 || preciseCenterY[1] != 0)) {
+		return;
+	}
+
+	// Row of the axis times 2
+	double rowSum = fromCenter ? pixelHeight : -2 * minRangeY / (maxRangeY - minRangeY) * pixelHeight;
+	if (!(rowSum > 0.5 && rowSum < 2.0 * pixelHeight - 2.5)) {
+		return; // No row has its mirror in the image
+	}
+	mirrorRowSum = (int)llround(rowSum);
+
+	// Imaginary part of the pixels of a row, with the expressions of the kernels
+	auto rowImaginary = [this, fromCenter](int row) {
+		if (fromCenter) {
+			return ((double)row / (double)pixelHeight - 0.5) * rangeHeight;
+		}
+		double y = (double)row / (double)pixelHeight * (maxRangeY - minRangeY) + minRangeY;
+		return GetPrecision() == PRECISION_FLOAT ? (double)(float)y : y;
+	};
+	// The rows after the axis are copied from the ones before it
+	for (int row = mirrorRowSum / 2 + 1; row < std::min(mirrorRowSum + 1, pixelHeight); row++) {
+		if (rowImaginary(row) == -rowImaginary(mirrorRowSum - row)) {
+			mirroredRows.push_back(row);
+		}
+	}
+	if (rank == 0 && !mirroredRows.empty()) {
+		std::cout << "Symmetry : " << mirroredRows.size() << " rows of " << pixelHeight << " copied from their mirror across the real axis" << std::endl;
+	}
+}
+
+/// <summary>
+/// Copy the rows calculated by the schedules to their mirror across the real axis, on rank 0
+/// </summary>
+void FractalRenderer::MirrorRows()
+{
+	threadPool->ParallelFor((int)mirroredRows.size(), [&](int i) {
+		int row = mirroredRows[i];
+		auto source = iterationBuffer.begin() + (size_t)(mirrorRowSum - row) * pixelWidth;
+		std::copy(source, source + pixelWidth, iterationBuffer.begin() + (size_t)row * pixelWidth);
+	});
+}
+
+/// <summary>
+/// Copy the rows of the work image to their place in the image, on rank 0, when the mirrored rows aren't in the work image
+/// </summary>
+void FractalRenderer::CopyRowsToImage()
+{
+	threadPool->ParallelFor(workHeight, [&](int row) {
+		auto source = tileBuffer.begin() + (size_t)row * pixelWidth;
+		std::copy(source, source + pixelWidth, iterationBuffer.begin() + (size_t)workRows[row] * pixelWidth);
+	});
+}
+
+/// <summary>
+/// Copy the part of a tile of the cache inside the image
+/// </summary>
+/// <param name="tileIterations">smooth iteration counts of the tile row by row</param>
+/// <param name="left">X position of the first column of the tile in the image, can be negative</param>
+/// <param name="top">Y position of the first row of the tile in the image, can be negative</param>
+void FractalRenderer::CopyTileToImage(const float* tileIterations, int left, int top)
+{
+	int firstColumn = std::max(0, -left);
+	int lastColumn = std::min(cacheTileSize, pixelWidth - left);
+	for (int row = std::max(0, -top); row < std::min(cacheTileSize, pixelHeight - top); row++) {
+		std::copy(tileIterations + (size_t)row * cacheTileSize + firstColumn, tileIterations + (size_t)row * cacheTileSize + lastColumn,
+			iterationBuffer.begin() + (size_t)(top + row) * pixelWidth + left + firstColumn);
+	}
+}
+
+/// <summary>
+/// Get the smooth iteration counts of the work image calculated by the schedules on rank 0
+/// </summary>
+/// <returns>the stacked missing tiles with the tile cache, the stacked rows not mirrored, otherwise the image</returns>
+float* FractalRenderer::GetWorkBuffer()
+{
+	return cachedFrame || !workRows.empty() ? tileBuffer.data() : iterationBuffer.data();
+}
+
+/// <summary>
+/// Calculate a tile with the Mariani-Silver subdivision : the border of the tile is calculated,
+/// then SubdivideRectangle fills it or splits it until every pixel is known
+/// </summary>
+/// <param name="left">X position of the first column of the tile in the image</param>
+/// <param name="top">Y position of the first row of the tile in the image</param>
+/// <param name="width">width of the tile in pixels</param>
+/// <param name="height">height of the tile in pixels</param>
+/// <param name="tileIterations">smooth iteration count of the top left pixel of the tile, filled with the result. The rows are pixelWidth floats apart.</param>
+/// <returns>number of pixels calculated by the kernel</returns>
+long long FractalRenderer::ComputeTile(int left, int top, int width, int height, float* tileIterations)
+{
+	tile rectangle = { left, top, width, height, tileIterations, std::vector<int>((size_t)width * height, -1), 0 };
+
+	ComputeTileRow(rectangle, 0, 0, width);
+	ComputeTileRow(rectangle, 0, height - 1, width);
+	for (int y = 1; y < height - 1; y++) {
+		ComputeTileRow(rectangle, 0, y, 1);
+		ComputeTileRow(rectangle, width - 1, y, 1);
+	}
+	SubdivideRectangle(rectangle, 0, 0, width, height);
+
+	return rectangle.iteratedPixels;
+}
+
+/// <summary>
+/// Fill the inside of a rectangle of a tile whose border is already calculated.
+/// If every pixel of the border has the same whole iteration count, the inside has it too (the set is connected) and is filled :
+/// black inside the set, otherwise interpolated between the left and right borders so the colors stay smooth.
+/// Otherwise the rectangle is split in two along its longest side and each half is filled the same way.
+/// </summary>
+/// <param name="rectangle">tile containing the rectangle</param>
+/// <param name="x">X position of the rectangle in the tile</param>
+/// <param name="y">Y position of the rectangle in the tile</param>
+/// <param name="width">width of the rectangle, border included</param>
+/// <param name="height">height of the rectangle, border included</param>
+void FractalRenderer::SubdivideRectangle(tile& rectangle, int x, int y, int width, int height)
+{
+	if (width <= 2 || height <= 2) {
+		return; // Only border
+	}
+
+	auto dwell = [&](int pixelX, int pixelY) { return rectangle.dwells[(size_t)pixelY * rectangle.width + pixelX]; };
+	auto iterations = [&](int pixelX, int pixelY) -> float& { return rectangle.iterations[(size_t)pixelY * pixelWidth + pixelX]; };
+
+	int borderDwell = dwell(x, y);
+	bool uniform = true;
+	for (int i = 0; i < width && uniform; i++) {
+		uniform = dwell(x + i, y) == borderDwell && dwell(x + i, y + height - 1) == borderDwell;
+	}
+	for (int i = 1; i < height - 1 && uniform; i++) {
+		uniform = dwell(x, y + i) == borderDwell && dwell(x + width - 1, y + i) == borderDwell;
+	}
+
+	if (uniform) {
+		for (int pixelY = y + 1; pixelY < y + height - 1; pixelY++) {
+			float leftIterations = iterations(x, pixelY);
+			float rightIterations = iterations(x + width - 1, pixelY);
+			for (int pixelX = x + 1; pixelX < x + width - 1; pixelX++) {
+				float ratio = (float)(pixelX - x) / (float)(width - 1);
+				iterations(pixelX, pixelY) = borderDwell == maxIteration ? interiorIteration : leftIterations + (rightIterations - leftIterations) * ratio;
+				rectangle.dwells[(size_t)pixelY * rectangle.width + pixelX] = borderDwell;
+			}
+		}
+	}
+	else if (width <= subdivideMinSize || height <= subdivideMinSize) {
+		// Too small to save anything by splitting it
+		for (int pixelY = y + 1; pixelY < y + height - 1; pixelY++) {
+			ComputeTileRow(rectangle, x + 1, pixelY, width - 2);
+		}
+	}
+	else if (width > height) {
+		// Split with a column shared by both halves
+		int middle = x + width / 2;
+		for (int pixelY = y + 1; pixelY < y + height - 1; pixelY++) {
+			ComputeTileRow(rectangle, middle, pixelY, 1);
+		}
+		SubdivideRectangle(rectangle, x, y, middle - x + 1, height);
+		SubdivideRectangle(rectangle, middle, y, x + width - middle, height);
+	}
+	else {
+		// Split with a row shared by both halves
+		int middle = y + height / 2;
+		ComputeTileRow(rectangle, x + 1, middle, width - 2);
+		SubdivideRectangle(rectangle, x, y, width, middle - y + 1);
+		SubdivideRectangle(rectangle, x, middle, width, y + height - middle);
+	}
+}
+
+/// <summary>
+/// Calculate consecutive pixels of a row of a tile with the escape-time kernel
+/// </summary>
+/// <param name="rectangle">tile containing the pixels</param>
+/// <param name="x">X position of the first pixel in the tile</param>
+/// <param name="y">Y position of the row in the tile</param>
+/// <param name="count">number of pixels</param>
+void FractalRenderer::ComputeTileRow(tile& rectangle, int x, int y, int count)
+{
+	const viewport view = GetViewport();
+	int iterations[taskPixels];
+	double modulusSquared[taskPixels];
+
+	for (int first = 0; first < count; first += taskPixels) {
+		int partCount = std::min(taskPixels, count - first);
+		EscapeTimeRow(view, rectangle.top + y, rectangle.left + x + first, partCount, maxIteration, iterations, modulusSquared);
+		long long partIterations = 0;
+		for (int i = 0; i < partCount; i++) {
+			rectangle.dwells[(size_t)y * rectangle.width + x + first + i] = iterations[i];
+			rectangle.iterations[(size_t)y * pixelWidth + x + first + i] = GetSmoothIteration(iterations[i], modulusSquared[i]);
+			partIterations += iterations[i];
+		}
+		kernelIterations += partIterations;
+	}
+	rectangle.iteratedPixels += count;
+}
+
+/// <summary>
+/// Adaptive anti-aliasing of the finished frame : rank 0 finds the pixels whose smooth iteration count differs
+/// from a neighbor by more than antialiasThreshold and sends the list to every rank. The ranks calculate antialiasSamples
+/// jittered subsamples in each of them, by chunks of refineChunkPixels pixels handed out by rank 0 like the dynamic schedule,
+/// the edges being gathered in a few parts of the image, so ColorizeFrame averages their colors.
+/// A cancelled frame stops between two chunks and keeps its pixels without subsamples.
+/// </summary>
+/// <param name="rank">rank of the current process</param>
+/// <param name="numtasks">number of MPI ranks</param>
+void FractalRenderer::RefineEdges(int rank, int numtasks)
+{
+	refinedPixels.clear();
+	subsampleIterations.clear();
+	if (antialiasSamples == 0) {
+		return;
+	}
+
+	double startTime = MPI_Wtime();
+	if (rank == 0) {
+		refinedPixels = FindEdgePixels();
+	}
+	int count = (int)refinedPixels.size();
+	MPI_Bcast(&count, 1, MPI_INT, 0, MPI_COMM_WORLD);
+
+	// The chunks are then only a range of the list
+	double traceStart = phaseTrace.Now();
+	refinedPixels.resize(count);
+	MPI_Bcast(refinedPixels.data(), count, MPI_INT, 0, MPI_COMM_WORLD);
+	phaseTrace.Add(rank == 0 ? PHASE_SEND : PHASE_RECEIVE, traceStart, count);
+
+	if (rank == 0) {
+		subsampleIterations.resize((size_t)count * antialiasSamples);
+		RunRefinementMaster(*this, refinedPixels, subsampleIterations.data(), numtasks);
+	}
+	else {
+		RunRefinementWorker(*this, refinedPixels);
+		refinedPixels.clear();
+	}
+	if (ShareFrameCancellation()) {
+		refinedPixels.clear();
+		subsampleIterations.clear();
+		return;
+	}
+
+	if (rank == 0) {
+		std::cout << "Anti-aliasing : " << count << " pixels refined (" << 100.0 * count / ((double)pixelWidth * pixelHeight) << " %) with "
+			<< antialiasSamples << " samples in " << (MPI_Wtime() - startTime) * 1000 << " ms" << std::endl;
+	}
+}
+
+/// <summary>
+/// Find the pixels of the last frame to refine, those whose smooth iteration count differs from one of their 4 neighbors
+/// by more than antialiasThreshold. The pixels inside the set count maxIteration, so the border of the set is refined.
+/// </summary>
+/// <returns>index of the pixels to refine in iterationBuffer, in order</returns>
+std::vector<int> FractalRenderer::FindEdgePixels()
+{
+	auto value = [this](float iteration) { return iteration == interiorIteration ? (float)maxIteration : iteration; };
+	std::vector<unsigned char> refined(iterationBuffer.size());
+	threadPool->ParallelFor(pixelHeight, [&](int row) {
+		const float* line = iterationBuffer.data() + (size_t)row * pixelWidth;
+		for (int column = 0; column < pixelWidth; column++) {
+			float center = value(line[column]);
+			bool edge = (column > 0 && fabs(center - value(line[column - 1])) > antialiasThreshold)
+				|| (column < pixelWidth - 1 && fabs(center - value(line[column + 1])) > antialiasThreshold)
+				|| (row > 0 && fabs(center - value(line[column - pixelWidth])) > antialiasThreshold)
+				|| (row < pixelHeight - 1 && fabs(center - value(line[column + pixelWidth])) > antialiasThreshold);
+			refined[(size_t)row * pixelWidth + column] = edge;
+		}
+	});
+
+	std::vector<int> pixels;
+	for (size_t i = 0; i < refined.size(); i++) {
+		if (refined[i]) {
+			pixels.push_back((int)i);
+		}
+	}
+	return pixels;
+}
+
+/// <summary>
+/// Calculate the smooth iteration counts of the subsamples of pixels of the current frame.
+/// The subsamples of a pixel are spread over a grid of ceil(sqrt(antialiasSamples)) cells on each axis, each one at a random
+/// position of its cell, the same for every frame so the images can be reproduced.
+/// </summary>
+/// <param name="pixels">index of the pixels in the image</param>
+/// <param name="count">number of pixels</param>
+/// <param name="samples">filled with antialiasSamples smooth iteration counts per pixel</param>
+void FractalRenderer::ComputeSubsamples(const int* pixels, int count, float* samples)
+{
+	constexpr int taskPixelCount = 64;
+	// The pixel (x, y) of the image is the pixel (x * antialiasGrid, y * antialiasGrid) of the bigger one, and its subsamples the pixels after it
+	viewport view = GetViewport();
+	view.pixelWidth *= antialiasGrid;
+	view.pixelHeight *= antialiasGrid;
+	view.columnStep = 1;
+	int cells = (int)ceil(sqrt((double)antialiasSamples));
+
+	threadPool->ParallelFor((count + taskPixelCount - 1) / taskPixelCount, [&](int task) {
+		long long taskIterations = 0;
+		for (int i = task * taskPixelCount; i < std::min(count, (task + 1) * taskPixelCount); i++) {
+			int row = pixels[i] / pixelWidth;
+			int column = pixels[i] % pixelWidth;
+			for (int sample = 0; sample < antialiasSamples; sample++) {
+				// Jitter from a hash of the pixel and of the sample
+				uint32_t hash = (uint32_t)pixels[i] * 2654435761u ^ (uint32_t)sample * 40503u;
+				hash = (hash ^ (hash >> 15)) * 2246822519u;
+				hash ^= hash >> 13;
+				int x = (int)(((sample % cells) + (hash & 0xffff) / 65536.0) / cells * antialiasGrid);
+				int y = (int)(((sample / cells % cells) + (hash >> 16) / 65536.0) / cells * antialiasGrid);
+
+				int iteration;
+				double modulusSquared;
+				EscapeTimeRow(view, row * antialiasGrid + y, column * antialiasGrid + x, 1, maxIteration, &iteration, &modulusSquared);
+				samples[(size_t)i * antialiasSamples + sample] = GetSmoothIteration(iteration, modulusSquared);
+				taskIterations += iteration;
+			}
+		}
+		kernelIterations += taskIterations;
+	});
+}
+
+/// <summary>
+/// Color the smooth iteration counts of the last frame with the current palette and save the image.
+/// Only rank 0 is needed, so a frame can be recolored without calculating it again.
+/// </summary>
+void FractalRenderer::ColorizeFrame()
+{
+	double startTime = MPI_Wtime();
+	double traceStart = phaseTrace.Now();
+	color* pixels = GetImageBuffer();
+	if (refinedPixels.empty()) {
+		Colorize(iterationBuffer.data(), iterationBuffer.size(), maxIteration, palette, (unsigned char*)pixels);
+	}
+	else {
+		// The subsamples are colored with the pixels, so the histogram palette counts them too
+		std::vector<float> samples(iterationBuffer.size() + subsampleIterations.size());
+		std::copy(iterationBuffer.begin(), iterationBuffer.end(), samples.begin());
+		std::copy(subsampleIterations.begin(), subsampleIterations.end(), samples.begin() + iterationBuffer.size());
+		std::vector<color> sampleColors(samples.size());
+		Colorize(samples.data(), samples.size(), maxIteration, palette, (unsigned char*)sampleColors.data());
+		std::copy(sampleColors.begin(), sampleColors.begin() + iterationBuffer.size(), pixels);
+
+		// Each refined pixel is the mean of its color and of the colors of its subsamples
+		const color* subsampleColors = sampleColors.data() + iterationBuffer.size();
+		threadPool->ParallelFor((int)refinedPixels.size(), [&](int i) {
+			color& pixel = pixels[refinedPixels[i]];
+			int sums[3] = { pixel.b, pixel.g, pixel.r };
+			for (int sample = 0; sample < antialiasSamples; sample++) {
+				const color& subsample = subsampleColors[(size_t)i * antialiasSamples + sample];
+				sums[0] += subsample.b;
+				sums[1] += subsample.g;
+				sums[2] += subsample.r;
+			}
+			int colorCount = antialiasSamples + 1;
+			pixel.b = (unsigned char)((sums[0] + colorCount / 2) / colorCount);
+			pixel.g = (unsigned char)((sums[1] + colorCount / 2) / colorCount);
+			pixel.r = (unsigned char)((sums[2] + colorCount / 2) / colorCount);
+		});
+	}
+	phaseTrace.Add(PHASE_ENCODE, traceStart, (double)(iterationBuffer.size() + subsampleIterations.size()));
+	std::cout << "Colored with the " << GetPaletteName(palette) << " palette in " << (MPI_Wtime() - startTime) * 1000 << " ms" << std::endl;
+
+	// Display pixels
+	if (saveFrames) {
+		traceStart = phaseTrace.Now();
+		CreateMandelbrotImage(pixels);
+		phaseTrace.Add(PHASE_WRITE, traceStart, (double)iterationBuffer.size());
+	}
+}
+
+/// <summary>
+/// Get the memory where rank 0 assembles the image of pixelWidth * pixelHeight pixels :
+/// straight in the shared memory when --shared-frame is used, otherwise in framebuffer
+/// </summary>
+/// <returns>pixels of the image row by row</returns>
+color* FractalRenderer::GetImageBuffer()
+{
+	if (!sharedFrameName.empty()) {
+		unsigned char* framePixels = sharedFrame.BeginWrite(pixelWidth, pixelHeight);
+		if (framePixels == nullptr) {
+			// Not opened yet or too small for this frame
+			if (!sharedFrame.Open(sharedFrameName, pixelWidth, pixelHeight)) {
+				throw std::runtime_error("Unable to open the shared memory " + sharedFrameName);
+			}
+			framePixels = sharedFrame.BeginWrite(pixelWidth, pixelHeight);
+			if (framePixels == nullptr) {
+				throw std::runtime_error("The shared memory " + sharedFrameName + " is too small for the image");
+			}
+		}
+		return (color*)framePixels;
+	}
+
+	framebuffer.resize((size_t)pixelWidth * pixelHeight);
+	return framebuffer.data();
+}
+
+/// <summary>
+/// This method creates a Bitmap image with the pixels passed in parameter,
+/// or marks the frame as ready when the pixels are already in the shared memory
+/// </summary>
+/// <param name="pixels">image returned by GetImageBuffer, which contains the color of each pixel row by row</param>
+void FractalRenderer::CreateMandelbrotImage(color* pixels)
+{
+	if (!sharedFrameName.empty()) {
+		sharedFrame.EndWrite();
+
+		std::cout << "Mandelbrot image written in the shared memory " << sharedFrameName << " (frame " << sharedFrame.GetSequence() << ")" << std::endl;
+		std::cout << "--------------------------------------------------" << std::endl;
+		return;
+	}
+
+	// Save Mandelbrot image as a file
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32) && !defined(__CYGWIN__)
+	std::string path = std::filesystem::temp_directory_path().string() + "Mandelbrot.bmp";
+#else
+	std::string path = "/tmp/Mandelbrot.bmp";
+#endif
+	SaveBitmap(pixels, pixelWidth, pixelHeight, path);
+#if !defined(WIN32) && !defined(_WIN32) && !defined(__WIN32) || defined(__CYGWIN__)
+	// Use chmod to give all permissions to everyone
+	// By default only the current user has write rights, which stops us from using the same machine as different users
+	std::string chmodCommande = "chmod 777 " + path;
+	system(chmodCommande.c_str());
+#endif
+	std::cout << "Mandelbrot image saved in " << path << std::endl;
+	std::cout << "--------------------------------------------------" << std::endl;
+}
+
+/// <summary>
+/// Save pixels in a Bitmap file
+/// </summary>
+/// <param name="pixels">color of each pixel row by row</param>
+/// <param name="width">width of the image</param>
+/// <param name="height">height of the image</param>
+/// <param name="path">path of the file</param>
+/// <returns>false if the file couldn't be written</returns>
+bool SaveBitmap(color* pixels, int width, int height, const std::string& path)
+{
+	// Create the surface using the pixels as they are
+	SDL_Surface* surface;
+	Uint32 rmask, gmask, bmask, amask;
+
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+	rmask = 0x0000ff00;
+	gmask = 0x00ff0000;
+	bmask = 0xff000000;
+	amask = 0x00000000;
+#else
+	rmask = 0x00ff0000;
+	gmask = 0x0000ff00;
+	bmask = 0x000000ff;
+	amask = 0x00000000;
+#endif
+	surface = SDL_CreateRGBSurfaceFrom(pixels, width, height, 32, width * sizeof(color), rmask, gmask, bmask, amask);
+	if (surface == NULL) {
+		fprintf(stderr, "CreateRGBSurface failed: %s\n", SDL_GetError());
+		exit(1);
+	}
+	bool saved = SDL_SaveBMP(surface, path.c_str()) == 0;
+	SDL_FreeSurface(surface);
+	return saved;
+}
+
+/// <summary>
+/// This method calculates the smooth iteration count of a pixel from the result of its sequence and returns it.
+/// The count is interiorIteration if the sequence converge.
+/// Otherwise the fractional part smooths the bands between the pixels escaping after a different number of iterations,
+/// as calculated by the variant of the fractal engine of the frame.
+/// </summary>
+/// <param name="iteration">number of iterations done by the escape-time kernel</param>
+/// <param name="modulusSquared">squared modulus of the last z of the sequence</param>
+/// <returns>smooth iteration count of the pixel</returns>
+float FractalRenderer::GetSmoothIteration(int iteration, double modulusSquared) const
+{
+	if (iteration == maxIteration)
+	{
+		return interiorIteration;
+	}
+	else
+	{
+		return engine.smoothIteration(iteration, modulusSquared);
+	}
+}
@@ -0,0 +1,435 @@
+#pragma once
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Kernel.h"
+#include "FractalEngine.h"
+#include "ThreadPool.h"
+#include "SharedFrame.h"
+#include "Palette.h"
+#include "BigFloat.h"
+#include "TileCache.h"
+#include "PhaseTrace.h"
+
+/// <summary>
+/// Color of a pixel, in the order of the bytes of the image (blue, green, red, unused)
+/// so the image can be saved or shared without any conversion
+/// </summary>
+typedef struct color {
+	unsigned char b;
+	unsigned char g;
+	unsigned char r;
+	unsigned char unused;
+} color;
+
+/// <summary>
+/// Time spent calculating and amount of work done by one rank
+/// </summary>
+typedef struct rankStatistics {
+	double busyTime;
+	double chunks;
+	double pixels;
+	double iteratedPixels; // Pixels calculated by the kernel, the others were filled by the subdivision
+	double iterations; // Sum of the iteration counts of the pixels calculated by the kernel, maxIteration for the pixels inside the set
+} rankStatistics;
+
+/// <summary>
+/// When the pixels are calculated with the perturbation from a reference orbit
+/// </summary>
+enum PerturbationMode {
+	PERTURBATION_AUTO, // When the pixels are too close for the precision of a double
+	PERTURBATION_ON,
+	PERTURBATION_OFF
+};
+
+/// <summary>
+/// Distance between two pixels, relative to the magnitude of the center, under which PERTURBATION_AUTO uses the perturbation.
+/// A double has about 16 significant digits, so a few digits are left to tell two pixels apart.
+/// </summary>
+constexpr double perturbationSpacing = 1e-13;
+
+/// <summary>
+/// Distance between two pixels, relative to the magnitude of the center, from which PRECISION_AUTO calculates in float.
+/// A float has about 7 significant digits, the rounding errors growing with the iterations need the 3 left.
+/// Even so they change about 0.25 % of the pixels of the unzoomed view, on the edge of the set, which RunPrecisionBenchmarks checks.
+/// Under perturbationSpacing, PRECISION_AUTO calculates in double-double the frames which can't use the perturbation.
+/// </summary>
+constexpr double floatSpacing = 1e-4;
+
+/// <summary>
+/// Maximum number of passes of the progressive rendering
+/// </summary>
+constexpr int maxPasses = 4;
+
+/// <summary>
+/// Width and height of the tiles of the cache, a multiple of the step of the first progressive pass
+/// </summary>
+constexpr int cacheTileSize = 64;
+
+/// <summary>
+/// Maximum number of pixels calculated by one task of the thread pool.
+/// Small enough for the threads to share the work of a chunk, big enough to fill the vector registers of the kernel.
+/// </summary>
+constexpr int taskPixels = 256;
+
+/// <summary>
+/// Frame calculated by every rank : the viewport and the options of the image, the buffers assembled by rank 0 and the work of the
+/// current pass. The render modes of the program set the viewport and call RenderFrame, or hand out the rows with their own schedule.
+/// </summary>
+class FractalRenderer
+{
+private:
+	/// <summary>
+	/// Rectangle of the image calculated by the subdivision, with the iteration counts of its pixels
+	/// </summary>
+	typedef struct tile {
+		int left; // X position of the first column in the image
+		int top; // Y position of the first row in the image
+		int width;
+		int height;
+		float* iterations; // Smooth iteration count of the top left pixel, the rows being pixelWidth floats apart
+		std::vector<int> dwells; // Whole iteration count of each pixel of the tile row by row, -1 until it's calculated
+		long long iteratedPixels; // Number of pixels calculated by the kernel
+	} tile;
+
+	/// <summary>
+	/// High and low parts of the center of the image in double-double, for PRECISION_DOUBLE_DOUBLE
+	/// </summary>
+	double preciseCenterX[2] = { 0, 0 };
+
+	/// <summary>
+	/// High and low parts of the imaginary part of the center of the image in double-double
+	/// </summary>
+	double preciseCenterY[2] = { 0, 0 };
+
+	/// <summary>
+	/// Reference orbit given to the kernel, pointing to referenceReal and referenceImag
+	/// </summary>
+	referenceOrbit reference = {};
+
+	/// <summary>
+	/// Smooth iteration counts of the grid of the current pass gathered by rank 0,
+	/// unused when the whole image is calculated in one pass straight in iterationBuffer
+	/// </summary>
+	std::vector<float> passBuffer;
+
+	/// <summary>
+	/// Whether the current frame is assembled from the tile cache, only the missing tiles being calculated
+	/// </summary>
+	bool cachedFrame = false;
+
+	/// <summary>
+	/// Left and top position in the image of each missing tile of the current frame, they can be partly outside the image.
+	/// The tiles are stacked in a work image of cacheTileSize columns calculated by the schedules instead of the image.
+	/// </summary>
+	std::vector<int> workTiles;
+
+	/// <summary>
+	/// Keys of the missing tiles of the current frame, to insert them in the cache once calculated
+	/// </summary>
+	std::vector<tileKey> workTileKeys;
+
+	/// <summary>
+	/// Smooth iteration counts of the stacked missing tiles assembled by rank 0
+	/// </summary>
+	std::vector<float> tileBuffer;
+
+	/// <summary>
+	/// Width of the image calculated by the schedules, pixelWidth or cacheTileSize
+	/// </summary>
+	int workWidth = 0;
+
+	/// <summary>
+	/// Height of the image calculated by the schedules, pixelHeight, the rows not mirrored or cacheTileSize times the number of missing tiles
+	/// </summary>
+	int workHeight = 0;
+
+	/// <summary>
+	/// Rows of the image calculated by the schedules when some rows are mirrored, row i of the work image being row workRows[i] of the image.
+	/// Empty when the work image is the image or the stacked tiles of the cache.
+	/// </summary>
+	std::vector<int> workRows;
+
+	/// <summary>
+	/// Rows of the current frame copied from their mirror across the real axis, row r being copied from row mirrorRowSum - r
+	/// </summary>
+	std::vector<int> mirroredRows;
+
+	/// <summary>
+	/// Sum of the indexes of two mirrored rows, the row of the real axis being mirrorRowSum / 2
+	/// </summary>
+	int mirrorRowSum = 0;
+
+	/// <summary>
+	/// Shared memory where rank 0 writes the image when sharedFrameName is set
+	/// </summary>
+	SharedFrame sharedFrame;
+
+	/// <summary>
+	/// Pixels of the last frame refined by the anti-aliasing, kept by rank 0 to color it again
+	/// </summary>
+	std::vector<int> refinedPixels;
+
+	/// <summary>
+	/// Smooth iteration counts of the antialiasSamples subsamples of each pixel of refinedPixels
+	/// </summary>
+	std::vector<float> subsampleIterations;
+
+	void ComputeReferenceOrbit(double);
+	void StorePass();
+	bool GetTileGrid(tileKey*, long long*, long long*);
+	void PrepareWorkTiles(int);
+	void PrepareMirroredRows(int);
+	void MirrorRows();
+	void CopyRowsToImage();
+	void CopyTileToImage(const float*, int, int);
+	float* GetWorkBuffer();
+	long long ComputeTile(int, int, int, int, float*);
+	void SubdivideRectangle(tile&, int, int, int, int);
+	void ComputeTileRow(tile&, int, int, int);
+	void RefineEdges(int, int);
+	std::vector<int> FindEdgePixels();
+	color* GetImageBuffer();
+	void CreateMandelbrotImage(color*);
+public:
+	/// <summary>
+	/// Width of the image
+	/// </summary>
+	int pixelWidth = 0;
+
+	/// <summary>
+	/// Height of the image
+	/// </summary>
+	int pixelHeight = 0;
+
+	/// <summary>
+	/// Minimum range of the X axis
+	/// </summary>
+	double minRangeX = 0;
+
+	/// <summary>
+	/// Maximum range of the X axis
+	/// </summary>
+	double maxRangeX = 0;
+
+	/// <summary>
+	/// Minimum range of the Y axis
+	/// </summary>
+	double minRangeY = 0;
+
+	/// <summary>
+	/// Maximum range of the Y axis
+	/// </summary>
+	double maxRangeY = 0;
+
+	/// <summary>
+	/// Real part of the center of the image at full precision, the reference orbit of the perturbation starts from it
+	/// </summary>
+	BigFloat centerX;
+
+	/// <summary>
+	/// Imaginary part of the center of the image at full precision
+	/// </summary>
+	BigFloat centerY;
+
+	/// <summary>
+	/// Width of the area of the complex plane, exact even when the zoom is too deep for minRangeX and maxRangeX
+	/// </summary>
+	double rangeWidth = 0;
+
+	/// <summary>
+	/// Height of the area of the complex plane, exact even when the zoom is too deep for minRangeY and maxRangeY
+	/// </summary>
+	double rangeHeight = 0;
+
+	/// <summary>
+	/// Number of iterations after which a pixel is considered as not diverging
+	/// </summary>
+	int maxIteration = 1000;
+
+	/// <summary>
+	/// Fractal drawn in the image
+	/// </summary>
+	fractalParameters fractal = { FRACTAL_MANDELBROT, 2, COLOR_SMOOTH, 0, 0 };
+
+	/// <summary>
+	/// Variant of the fractal engine of the current frame, chosen once per frame from fractal
+	/// </summary>
+	fractalEngine engine = {};
+
+	/// <summary>
+	/// When the pixels are calculated with the perturbation
+	/// </summary>
+	PerturbationMode perturbationMode = PERTURBATION_AUTO;
+
+	/// <summary>
+	/// Precision of the pixels, PRECISION_AUTO choosing it for each frame from the distance between two pixels
+	/// </summary>
+	PrecisionType precisionMode = PRECISION_AUTO;
+
+	/// <summary>
+	/// Real parts of the reference orbit of the current frame, empty when the frame doesn't use the perturbation
+	/// </summary>
+	std::vector<double> referenceReal;
+
+	/// <summary>
+	/// Imaginary parts of the reference orbit of the current frame
+	/// </summary>
+	std::vector<double> referenceImag;
+
+	/// <summary>
+	/// Whether rank 0 hands out chunks of rows on demand (true)
+	/// or gives each rank one contiguous part of the image (false)
+	/// </summary>
+	bool dynamicSchedule = true;
+
+	/// <summary>
+	/// Number of rows in a chunk handed out by the dynamic schedule, or sent by the static schedule as soon as it's calculated
+	/// </summary>
+	int chunkRows = 4;
+
+	/// <summary>
+	/// Whether rank 0 only hands out and assembles the chunks of the other ranks (true) or calculates its share too (false)
+	/// </summary>
+	bool coordinator = false;
+
+	/// <summary>
+	/// Whether the image is calculated by tiles with the Mariani-Silver subdivision (true) or pixel by pixel (false)
+	/// </summary>
+	bool subdivide = false;
+
+	/// <summary>
+	/// Width and height of the tiles of the subdivision, a chunk of the dynamic schedule is one row of tiles
+	/// </summary>
+	int tileSize = 32;
+
+	/// <summary>
+	/// Number of passes of the progressive rendering, each pass calculating twice as many rows and columns as the previous one.
+	/// The first pass calculates 1 pixel out of 4^(passes - 1), the last one the full resolution.
+	/// </summary>
+	int passes = 1;
+
+	/// <summary>
+	/// Distance in pixels between two pixels calculated by the current pass, in both directions, 1 for the full resolution
+	/// </summary>
+	int passStep = 1;
+
+	/// <summary>
+	/// Whether the current pass reuses the pixels of the previous pass, found in its even rows and even columns
+	/// </summary>
+	bool passReuse = false;
+
+	/// <summary>
+	/// Number of columns of the grid of pixels calculated by the current pass, the width handed out by the schedules
+	/// </summary>
+	int passWidth = 0;
+
+	/// <summary>
+	/// Number of rows of the grid of pixels calculated by the current pass
+	/// </summary>
+	int passHeight = 0;
+
+	/// <summary>
+	/// Tiles of smooth iteration counts kept by rank 0 between the frames, so the parts of a frame already calculated aren't calculated again
+	/// </summary>
+	TileCache tileCache;
+
+	/// <summary>
+	/// Whether the rows mirrored across the real axis are copied instead of calculated, for the fractals symmetric about it
+	/// </summary>
+	bool symmetry = true;
+
+	/// <summary>
+	/// Name of the shared memory where rank 0 writes the image, empty to save it as a BMP file
+	/// </summary>
+	std::string sharedFrameName;
+
+	/// <summary>
+	/// Whether the frames can be cancelled while they are calculated, set on every rank by the render server
+	/// </summary>
+	bool cancellable = false;
+
+	/// <summary>
+	/// Called by rank 0 between two chunks to know whether the GUI cancelled the frame being calculated
+	/// </summary>
+	std::function<bool()> cancelRequested;
+
+	/// <summary>
+	/// Whether the frame being calculated is cancelled, the ranks then skip the rest of its pixels
+	/// </summary>
+	bool frameCancelled = false;
+
+	/// <summary>
+	/// Phases of the frames of this rank, recorded when --trace is set
+	/// </summary>
+	PhaseTrace phaseTrace;
+
+	/// <summary>
+	/// Whether ColorizeFrame saves the image, false while benchmarking so writing the file isn't measured
+	/// </summary>
+	bool saveFrames = true;
+
+	/// <summary>
+	/// Sum of the iteration counts returned by the kernel to the threads of the current rank during the current pass
+	/// </summary>
+	std::atomic<long long> kernelIterations{ 0 };
+
+	/// <summary>
+	/// Work done by every rank for the last frame, summed over its passes by rank 0
+	/// </summary>
+	rankStatistics frameStatistics = {};
+
+	/// <summary>
+	/// Image colored by rank 0 when it isn't written straight in the shared memory, row by row
+	/// </summary>
+	std::vector<color> framebuffer;
+
+	/// <summary>
+	/// Smooth iteration counts of the last frame assembled by rank 0 row by row, kept to color it again with another palette
+	/// </summary>
+	std::vector<float> iterationBuffer;
+
+	/// <summary>
+	/// Extra samples calculated in each pixel refined by the anti-aliasing, 0 to disable it
+	/// </summary>
+	int antialiasSamples = 0;
+
+	/// <summary>
+	/// Difference of smooth iteration count with a neighbor above which a pixel is refined by the anti-aliasing
+	/// </summary>
+	float antialiasThreshold = 1;
+
+	/// <summary>
+	/// Palette used to color the smooth iteration counts
+	/// </summary>
+	PaletteType palette = PALETTE_SQRT;
+
+	/// <summary>
+	/// Threads calculating the pixels of the current rank
+	/// </summary>
+	std::unique_ptr<ThreadPool> threadPool;
+
+	void StartThreads(int);
+	void RenderFrame(int, int, const std::function<void()>&);
+	void SetViewport(const std::string&, const std::string&, const std::string&, const std::string&);
+	void PrepareReferenceOrbit(int);
+	void PreparePrecision(int);
+	double GetRelativeSpacing() const;
+	viewport GetViewport() const;
+	bool RankZeroComputes(int) const;
+	int GetChunkRows() const;
+	bool IsFrameCancelled();
+	bool ShareFrameCancellation();
+	long long ComputeRows(int, int, float*);
+	void ComputePixels(int, int, float*);
+	void ComputeRegion(int, int, int, int, int, float*);
+	void ComputeSubsamples(const int*, int, float*);
+	void ColorizeFrame();
+	float GetSmoothIteration(int, double) const;
+};
+
+int GetDefaultThreadCount();
+bool SaveBitmap(color*, int, int, const std::string&);
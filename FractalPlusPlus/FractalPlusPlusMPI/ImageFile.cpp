@@ -0,0 +1,162 @@
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "ImageFile.h"
+
+
+/// <summary>
+/// Create the image file and set its final size, called by every rank at the same time.
+/// Rank 0 writes the header, the pixels are written later by the ranks calculating them.
+/// </summary>
+/// <param name="path">path of the file, its pixels are kept if it already has the same size so a render can be resumed</param>
+/// <param name="width">width of the image in pixels</param>
+/// <param name="height">height of the image in pixels</param>
+/// <param name="layout">order of the pixels in the file</param>
+/// <param name="tileSize">width and height of the tiles, and number of pixels of a unit of LAYOUT_RAW divided by tileSize</param>
+void ImageFile::Open(const std::string& path, int width, int height, ImageLayout layout, int tileSize)
+{
+	std::memcpy(header.magic, "FPPIMAGE", sizeof(header.magic));
+	header.width = (uint64_t)width;
+	header.height = (uint64_t)height;
+	header.layout = layout;
+	header.tileSize = layout == LAYOUT_TILED ? (uint32_t)tileSize : 0;
+	unitRows = (int)std::clamp((long long)tileSize * tileSize / width, 1LL, (long long)height);
+	tilesPerRow = ((long long)width + tileSize - 1) / tileSize;
+
+	// MPI_File_open fails when the file exists without MPI_MODE_CREATE, and doesn't truncate it, MPI_File_set_size does.
+	// The file is also readable to check the units of a checkpoint
+	int rank;
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+	if (MPI_File_open(MPI_COMM_WORLD, path.c_str(), MPI_MODE_CREATE | MPI_MODE_RDWR, MPI_INFO_NULL, &file) != MPI_SUCCESS) {
+		throw std::runtime_error("Unable to create the image file " + path);
+	}
+	if (MPI_File_set_size(file, GetFileSize()) != MPI_SUCCESS) {
+		throw std::runtime_error("Unable to set the size of the image file " + path + ", the disk may be full");
+	}
+	if (rank == 0) {
+		MPI_File_write_at(file, 0, &header, sizeof(header), MPI_BYTE, MPI_STATUS_IGNORE);
+	}
+}
+
+/// <summary>
+/// Get the number of units of the image
+/// </summary>
+/// <returns>number of tiles, or of bands of rows for LAYOUT_RAW</returns>
+long long ImageFile::GetUnitCount() const
+{
+	if (header.layout == LAYOUT_TILED) {
+		return tilesPerRow * (long long)((header.height + header.tileSize - 1) / header.tileSize);
+	}
+	return (long long)((header.height + unitRows - 1) / unitRows);
+}
+
+/// <summary>
+/// Get the size of the buffer of a unit
+/// </summary>
+/// <returns>number of pixels of the largest unit</returns>
+long long ImageFile::GetUnitPixels() const
+{
+	if (header.layout == LAYOUT_TILED) {
+		return (long long)header.tileSize * header.tileSize;
+	}
+	return (long long)unitRows * header.width;
+}
+
+/// <summary>
+/// Get the position of a unit in the image and in the file
+/// </summary>
+/// <param name="index">index of the unit, from 0 to GetUnitCount() - 1</param>
+/// <returns>unit</returns>
+imageUnit ImageFile::GetUnit(long long index) const
+{
+	imageUnit unit;
+	if (header.layout == LAYOUT_TILED) {
+		int tileSize = (int)header.tileSize;
+		unit.left = (int)(index % tilesPerRow) * tileSize;
+		unit.top = (int)(index / tilesPerRow) * tileSize;
+		unit.width = (int)std::min((long long)tileSize, (long long)header.width - unit.left);
+		unit.height = (int)std::min((long long)tileSize, (long long)header.height - unit.top);
+		unit.stride = tileSize;
+		unit.pixels = (long long)tileSize * tileSize;
+		unit.offset = (MPI_Offset)(sizeof(header) + (uint64_t)index * unit.pixels * 4);
+	}
+	else {
+		unit.left = 0;
+		unit.top = (int)(index * unitRows);
+		unit.width = (int)header.width;
+		unit.height = (int)std::min((long long)unitRows, (long long)header.height - unit.top);
+		unit.stride = (int)header.width;
+		unit.pixels = (long long)unit.height * unit.width;
+		unit.offset = (MPI_Offset)(sizeof(header) + (uint64_t)unit.top * header.width * 4);
+	}
+	return unit;
+}
+
+/// <summary>
+/// Start writing a unit without waiting for the end, so the next one can be calculated meanwhile
+/// </summary>
+/// <param name="unit">unit returned by GetUnit</param>
+/// <param name="pixels">colors of the unit, unit.pixels * 4 bytes which must not change until the request is done</param>
+/// <param name="request">filled with the request to wait for with MPI_Wait</param>
+void ImageFile::BeginWrite(const imageUnit& unit, const void* pixels, MPI_Request* request)
+{
+	// Counted in pixels of 4 bytes so a band of rows wider than 512 million pixels doesn't overflow the int of MPI
+	MPI_File_iwrite_at(file, unit.offset, pixels, (int)unit.pixels, MPI_UINT32_T, request);
+}
+
+/// <summary>
+/// Read back the colors of a unit written by an earlier run
+/// </summary>
+/// <param name="unit">unit returned by GetUnit</param>
+/// <param name="pixels">filled with the colors of the unit, unit.pixels * 4 bytes</param>
+/// <returns>false if the unit couldn't be read entirely</returns>
+bool ImageFile::ReadUnit(const imageUnit& unit, void* pixels)
+{
+	MPI_Status status;
+	int count = 0;
+	if (MPI_File_read_at(file, unit.offset, pixels, (int)unit.pixels, MPI_UINT32_T, &status) != MPI_SUCCESS) {
+		return false;
+	}
+	MPI_Get_count(&status, MPI_UINT32_T, &count);
+	return count == unit.pixels;
+}
+
+/// <summary>
+/// Get the size of the whole file
+/// </summary>
+/// <returns>size of the header and of the pixels in bytes</returns>
+MPI_Offset ImageFile::GetFileSize() const
+{
+	uint64_t pixels = header.layout == LAYOUT_TILED ? (uint64_t)GetUnitCount() * header.tileSize * header.tileSize : header.width * header.height;
+	return (MPI_Offset)(sizeof(header) + pixels * 4);
+}
+
+/// <summary>
+/// Close the file once every write is done, called by every rank at the same time
+/// </summary>
+void ImageFile::Close()
+{
+	if (file != MPI_FILE_NULL) {
+		MPI_File_close(&file);
+	}
+}
+
+/// <summary>
+/// Find a layout from its name
+/// </summary>
+/// <param name="name">raw or tiled</param>
+/// <param name="layout">filled with the layout when it's found</param>
+/// <returns>false if no layout has this name</returns>
+bool FindImageLayout(const std::string& name, ImageLayout* layout)
+{
+	if (name == "raw") {
+		*layout = LAYOUT_RAW;
+		return true;
+	}
+	if (name == "tiled") {
+		*layout = LAYOUT_TILED;
+		return true;
+	}
+	return false;
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <mpi.h>
+
+/// <summary>
+/// Order of the pixels in an image file written by --output
+/// </summary>
+enum ImageLayout : uint32_t {
+	LAYOUT_RAW, // Rows from top to bottom, like a raw BGRA image
+	LAYOUT_TILED, // Square tiles of tileSize * tileSize pixels, row by row of tiles, the tiles of the right and bottom edges padded to full size
+	LAYOUT_COUNT
+};
+
+/// <summary>
+/// Header at the start of an image file written by --output, followed by the pixels (blue, green, red, unused) in the order of the layout.
+/// Every size is 64 bits so the files aren't limited to 4 GB like BMP files.
+/// </summary>
+typedef struct imageFileHeader {
+	char magic[8]; // "FPPIMAGE"
+	uint64_t width;
+	uint64_t height;
+	uint32_t layout; // ImageLayout
+	uint32_t tileSize; // Width and height of the tiles of LAYOUT_TILED, 0 for LAYOUT_RAW
+} imageFileHeader;
+
+/// <summary>
+/// Part of the image calculated and written at once : a tile, or a band of whole rows for LAYOUT_RAW
+/// </summary>
+typedef struct imageUnit {
+	int left; // X position of the first column of the unit in the image
+	int top; // Y position of the first row of the unit in the image
+	int width; // Size of the part of the unit inside the image
+	int height;
+	int stride; // Distance between two rows of the unit in its buffer, in pixels
+	long long pixels; // Pixels of the buffer written in the file, with the padding of the tiles
+	MPI_Offset offset; // Position of the unit in the file in bytes
+} imageUnit;
+
+/// <summary>
+/// Image file shared by every rank, each rank writing its units at their precomputed offsets with MPI-IO
+/// so no rank holds the whole image and the size is only limited by the disk
+/// </summary>
+class ImageFile
+{
+private:
+	/// <summary>
+	/// File opened by every rank
+	/// </summary>
+	MPI_File file = MPI_FILE_NULL;
+
+	/// <summary>
+	/// Size and layout of the image
+	/// </summary>
+	imageFileHeader header = {};
+
+	/// <summary>
+	/// Rows of a unit of LAYOUT_RAW, chosen so a band has about as many pixels as a tile
+	/// </summary>
+	int unitRows = 0;
+
+	/// <summary>
+	/// Number of tiles in a row of tiles, for LAYOUT_TILED
+	/// </summary>
+	long long tilesPerRow = 0;
+public:
+	void Open(const std::string&, int, int, ImageLayout, int);
+	long long GetUnitCount() const;
+	long long GetUnitPixels() const;
+	imageUnit GetUnit(long long) const;
+	void BeginWrite(const imageUnit&, const void*, MPI_Request*);
+	bool ReadUnit(const imageUnit&, void*);
+	MPI_Offset GetFileSize() const;
+	void Close();
+};
+
+bool FindImageLayout(const std::string&, ImageLayout*);
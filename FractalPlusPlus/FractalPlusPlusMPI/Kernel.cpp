@@ -0,0 +1,387 @@
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "Kernel.h"
+#include "Complex.h"
+
+
+/// <summary>
+/// Version of the kernel called by EscapeTimeRow
+/// </summary>
+static KernelType currentKernel = KERNEL_SCALAR;
+
+/// <summary>
+/// InteriorCheck flags used by EscapeTimeRow
+/// </summary>
+static int currentInteriorChecks = INTERIOR_CHECK_ALL;
+
+/// <summary>
+/// Variant of FractalEngine.h called by EscapeTimeRow instead of the kernels of the Mandelbrot set, nullptr to use them
+/// </summary>
+static escapeTimeRowFunction currentFormulaKernel = nullptr;
+
+/// <summary>
+/// Precision of the kernels of the Mandelbrot set used by EscapeTimeRow, float or double
+/// </summary>
+static PrecisionType currentPrecision = PRECISION_DOUBLE;
+
+/// <summary>
+/// Check if the CPU and the OS support a set of instructions
+/// </summary>
+/// <param name="kernel">version of the kernel which needs the instructions</param>
+/// <returns>true if the kernel can run on this computer</returns>
+static bool IsKernelSupported(KernelType kernel)
+{
+	if (kernel == KERNEL_SCALAR) {
+		return true;
+	}
+#if !defined(FPP_KERNEL_X86)
+	return false;
+#elif defined(_MSC_VER)
+	int cpuInfo[4];
+	__cpuid(cpuInfo, 1);
+	bool osSavesAvx = (cpuInfo[2] & (1 << 27)) && (cpuInfo[2] & (1 << 28)) && (_xgetbv(0) & 0x06) == 0x06;
+	__cpuidex(cpuInfo, 7, 0);
+	if (kernel == KERNEL_AVX2) {
+		return osSavesAvx && (cpuInfo[1] & (1 << 5));
+	}
+	return osSavesAvx && (cpuInfo[1] & (1 << 16)) && (_xgetbv(0) & 0xE6) == 0xE6;
+#else
+	__builtin_cpu_init();
+	if (kernel == KERNEL_AVX2) {
+		return __builtin_cpu_supports("avx2");
+	}
+	return __builtin_cpu_supports("avx512f");
+#endif
+}
+
+/// <summary>
+/// Choose the version of the kernel used by EscapeTimeRow
+/// </summary>
+/// <param name="kernel">version to use, KERNEL_AUTO for the fastest one supported by the CPU</param>
+/// <returns>false if the CPU doesn't support the requested version</returns>
+bool SetKernel(KernelType kernel)
+{
+	if (kernel == KERNEL_AUTO) {
+		if (IsKernelSupported(KERNEL_AVX512)) {
+			kernel = KERNEL_AVX512;
+		}
+		else if (IsKernelSupported(KERNEL_AVX2)) {
+			kernel = KERNEL_AVX2;
+		}
+		else {
+			kernel = KERNEL_SCALAR;
+		}
+	}
+	if (!IsKernelSupported(kernel)) {
+		return false;
+	}
+	currentKernel = kernel;
+	return true;
+}
+
+/// <summary>
+/// Get the version of the kernel used by EscapeTimeRow, to choose it again after using another one
+/// </summary>
+/// <returns>version of the kernel, never KERNEL_AUTO</returns>
+KernelType GetKernel()
+{
+	return currentKernel;
+}
+
+/// <summary>
+/// Get the name of the version of the kernel used by EscapeTimeRow
+/// </summary>
+/// <returns>name of the kernel</returns>
+const char* GetKernelName()
+{
+	if (currentFormulaKernel != nullptr) {
+		return "scalar formula";
+	}
+	switch (currentKernel) {
+		case KERNEL_AVX2:
+			return "AVX2";
+		case KERNEL_AVX512:
+			return "AVX-512";
+		default:
+			return "scalar";
+	}
+}
+
+/// <summary>
+/// Choose the shortcuts used by EscapeTimeRow to find the pixels inside the set
+/// </summary>
+/// <param name="interiorChecks">InteriorCheck flags, INTERIOR_CHECK_NONE to iterate every pixel up to maxIteration</param>
+void SetInteriorChecks(int interiorChecks)
+{
+	currentInteriorChecks = interiorChecks & INTERIOR_CHECK_ALL;
+}
+
+/// <summary>
+/// Get the shortcuts used by EscapeTimeRow to find the pixels inside the set
+/// </summary>
+/// <returns>InteriorCheck flags set by SetInteriorChecks</returns>
+int GetInteriorChecks()
+{
+	return currentInteriorChecks;
+}
+
+/// <summary>
+/// Choose the variant of FractalEngine.h called by EscapeTimeRow, set once per frame
+/// </summary>
+/// <param name="formulaKernel">variant calculating another fractal than the Mandelbrot set of power 2, nullptr for the Mandelbrot set</param>
+void SetFormulaKernel(escapeTimeRowFunction formulaKernel)
+{
+	currentFormulaKernel = formulaKernel;
+}
+
+/// <summary>
+/// Choose the precision of the current frame, set once per frame.
+/// Only the kernels of the Mandelbrot set of power 2 have a float version, the double-double variants are set with SetFormulaKernel.
+/// </summary>
+/// <param name="precision">precision of the frame, never PRECISION_AUTO</param>
+void SetPrecision(PrecisionType precision)
+{
+	currentPrecision = precision;
+}
+
+/// <summary>
+/// Get the precision of the current frame
+/// </summary>
+/// <returns>precision set by SetPrecision</returns>
+PrecisionType GetPrecision()
+{
+	return currentPrecision;
+}
+
+/// <summary>
+/// Get the name of a precision
+/// </summary>
+/// <param name="precision">precision</param>
+/// <returns>name of the precision, as written in the options</returns>
+const char* GetPrecisionName(PrecisionType precision)
+{
+	switch (precision) {
+		case PRECISION_FLOAT:
+			return "float";
+		case PRECISION_DOUBLE:
+			return "double";
+		case PRECISION_DOUBLE_DOUBLE:
+			return "double-double";
+		default:
+			return "auto";
+	}
+}
+
+/// <summary>
+/// Calculate the sequence of consecutive pixels of a row
+/// </summary>
+/// <param name="view">area of the complex plane and size of the image</param>
+/// <param name="iYpos">Y position of the row</param>
+/// <param name="firstColumn">X position of the first pixel, the next ones being view.columnStep pixels apart</param>
+/// <param name="count">number of pixels</param>
+/// <param name="maxIteration">number of iterations after which a pixel is considered as not diverging</param>
+/// <param name="iterations">filled with the number of iterations done for each pixel (maxIteration if not diverging)</param>
+/// <param name="modulusSquared">filled with the squared modulus of the last z of each pixel</param>
+void EscapeTimeRow(const viewport& view, int iYpos, int firstColumn, int count, int maxIteration, int* iterations, double* modulusSquared)
+{
+	if (currentFormulaKernel != nullptr) {
+		currentFormulaKernel(view, iYpos, firstColumn, count, maxIteration, currentInteriorChecks, iterations, modulusSquared);
+		return;
+	}
+	if (view.reference != nullptr) {
+		EscapeTimeRowPerturbation(view, iYpos, firstColumn, count, maxIteration, iterations, modulusSquared);
+		return;
+	}
+
+	bool useFloat = currentPrecision == PRECISION_FLOAT;
+	switch (currentKernel) {
+#if defined(FPP_KERNEL_X86)
+		case KERNEL_AVX2:
+			(useFloat ? EscapeTimeRowAvx2Float : EscapeTimeRowAvx2)(view, iYpos, firstColumn, count, maxIteration, currentInteriorChecks, iterations, modulusSquared);
+			break;
+		case KERNEL_AVX512:
+			(useFloat ? EscapeTimeRowAvx512Float : EscapeTimeRowAvx512)(view, iYpos, firstColumn, count, maxIteration, currentInteriorChecks, iterations, modulusSquared);
+			break;
+#endif
+		default:
+			(useFloat ? EscapeTimeRowScalarFloat : EscapeTimeRowScalar)(view, iYpos, firstColumn, count, maxIteration, currentInteriorChecks, iterations, modulusSquared);
+			break;
+	}
+}
+
+/// <summary>
+/// Check if a point is strictly inside the main cardioid or the period-2 bulb of the Mandelbrot set,
+/// where the sequence converges to a cycle of 1 or 2 values
+/// </summary>
+/// <param name="x">real part of c</param>
+/// <param name="y">imaginary part of c</param>
+/// <returns>true if the point is inside the set</returns>
+static bool IsInMainBulbs(double x, double y)
+{
+	double shiftedX = x - 0.25;
+	double q = shiftedX * shiftedX + y * y;
+	return q * (q + shiftedX) < 0.25 * y * y || (x + 1) * (x + 1) + y * y < 0.0625;
+}
+
+/// <summary>
+/// Scalar version of EscapeTimeRow, one pixel at a time
+/// </summary>
+void EscapeTimeRowScalar(const viewport& view, int iYpos, int firstColumn, int count, int maxIteration, int interiorChecks, int* iterations, double* modulusSquared)
+{
+	double rangeYPos = (double)iYpos / (double)view.pixelHeight * (view.maxRangeY - view.minRangeY) + view.minRangeY;
+
+	for (int i = 0; i < count; i++)
+	{
+		double rangeXPos = (double)(firstColumn + i * view.columnStep) / (double)view.pixelWidth * (view.maxRangeX - view.minRangeX) + view.minRangeX;
+
+		if ((interiorChecks & INTERIOR_CHECK_BULBS) && IsInMainBulbs(rangeXPos, rangeYPos)) {
+			iterations[i] = maxIteration;
+			modulusSquared[i] = 0;
+			continue;
+		}
+
+		Complex c = Complex(rangeXPos, rangeYPos);
+		Complex z = Complex(0, 0);
+
+		// Value of z compared with the next ones, replaced after 8, 16, 32... iterations so cycles of any length are found
+		Complex savedZ = z;
+		int savedAge = 0;
+		int checkLength = periodicityFirstCheck;
+
+		int iteration = 0;
+		while (iteration < maxIteration && z.ModulusSquared() <= escapeModulusSquared)
+		{
+			z = z.NextIteration(c);
+			iteration++;
+
+			if (interiorChecks & INTERIOR_CHECK_PERIODICITY) {
+				if (z == savedZ) {
+					iteration = maxIteration; // z loops forever without diverging
+					break;
+				}
+				if (++savedAge == checkLength) {
+					savedZ = z;
+					savedAge = 0;
+					checkLength *= 2;
+				}
+			}
+		}
+
+		iterations[i] = iteration;
+		modulusSquared[i] = z.ModulusSquared();
+	}
+}
+
+/// <summary>
+/// Float version of EscapeTimeRowScalar, one pixel at a time.
+/// The position of the pixel is calculated in float too, so the vectorized float kernels give exactly the same results.
+/// </summary>
+void EscapeTimeRowScalarFloat(const viewport& view, int iYpos, int firstColumn, int count, int maxIteration, int interiorChecks, int* iterations, double* modulusSquared)
+{
+	float rangeX = (float)(view.maxRangeX - view.minRangeX);
+	float minRangeX = (float)view.minRangeX;
+	float rangeYPos = (float)((double)iYpos / (double)view.pixelHeight * (view.maxRangeY - view.minRangeY) + view.minRangeY);
+
+	for (int i = 0; i < count; i++)
+	{
+		float rangeXPos = (float)(firstColumn + i * view.columnStep) / (float)view.pixelWidth * rangeX + minRangeX;
+
+		// Same test as IsInMainBulbs
+		float shiftedX = rangeXPos - 0.25f;
+		float q = shiftedX * shiftedX + rangeYPos * rangeYPos;
+		if ((interiorChecks & INTERIOR_CHECK_BULBS)
+			&& (q * (q + shiftedX) < 0.25f * (rangeYPos * rangeYPos) || (rangeXPos + 1) * (rangeXPos + 1) + rangeYPos * rangeYPos < 0.0625f)) {
+			iterations[i] = maxIteration;
+			modulusSquared[i] = 0;
+			continue;
+		}
+
+		float real = 0;
+		float imag = 0;
+		float savedReal = 0;
+		float savedImag = 0;
+		int savedAge = 0;
+		int checkLength = periodicityFirstCheck;
+
+		int iteration = 0;
+		while (iteration < maxIteration && real * real + imag * imag <= escapeModulusSquaredFloat)
+		{
+			float nextReal = real * real - imag * imag + rangeXPos;
+			imag = real * imag + imag * real + rangeYPos;
+			real = nextReal;
+			iteration++;
+
+			if (interiorChecks & INTERIOR_CHECK_PERIODICITY) {
+				if (real == savedReal && imag == savedImag) {
+					iteration = maxIteration; // z loops forever without diverging
+					break;
+				}
+				if (++savedAge == checkLength) {
+					savedReal = real;
+					savedImag = imag;
+					savedAge = 0;
+					checkLength *= 2;
+				}
+			}
+		}
+
+		iterations[i] = iteration;
+		modulusSquared[i] = real * real + imag * imag;
+	}
+}
+
+/// <summary>
+/// Version of EscapeTimeRow for the deep zooms, one pixel at a time.
+/// Each pixel calculates in double the difference delta between its z and the z of the reference orbit :
+/// delta(n+1) = 2 * Z(n) * delta(n) + delta(n)^2 + deltaC, with deltaC the distance between the pixel and the center of the image.
+/// When z gets closer to 0 than delta, the difference can't be calculated precisely anymore (a glitch),
+/// so the pixel starts again from the beginning of the reference orbit with delta = z. It does the same at the end of the orbit.
+/// The interior checks aren't used, the pixels inside the set are iterated up to maxIteration.
+/// </summary>
+void EscapeTimeRowPerturbation(const viewport& view, int iYpos, int firstColumn, int count, int maxIteration, int* iterations, double* modulusSquared)
+{
+	const referenceOrbit& reference = *view.reference;
+	double deltaImagC = ((double)iYpos / (double)view.pixelHeight - 0.5) * reference.rangeHeight;
+
+	for (int i = 0; i < count; i++)
+	{
+		double deltaRealC = ((double)(firstColumn + i * view.columnStep) / (double)view.pixelWidth - 0.5) * reference.rangeWidth;
+		double deltaReal = 0;
+		double deltaImag = 0;
+		int referenceIteration = 0;
+
+		int iteration = 0;
+		double real = 0;
+		double imag = 0;
+		while (true)
+		{
+			real = reference.real[referenceIteration] + deltaReal;
+			imag = reference.imag[referenceIteration] + deltaImag;
+			double zModulusSquared = real * real + imag * imag;
+			if (iteration == maxIteration || zModulusSquared > escapeModulusSquared) {
+				break;
+			}
+
+			if (zModulusSquared < deltaReal * deltaReal + deltaImag * deltaImag || referenceIteration == reference.length - 1) {
+				// Rebase on the beginning of the reference orbit, where Z is 0
+				deltaReal = real;
+				deltaImag = imag;
+				referenceIteration = 0;
+			}
+
+			double referenceReal = reference.real[referenceIteration];
+			double referenceImag = reference.imag[referenceIteration];
+			double nextDeltaReal = 2 * (referenceReal * deltaReal - referenceImag * deltaImag) + (deltaReal * deltaReal - deltaImag * deltaImag) + deltaRealC;
+			double nextDeltaImag = 2 * (referenceReal * deltaImag + referenceImag * deltaReal) + 2 * deltaReal * deltaImag + deltaImagC;
+			deltaReal = nextDeltaReal;
+			deltaImag = nextDeltaImag;
+			referenceIteration++;
+			iteration++;
+		}
+
+		iterations[i] = iteration;
+		modulusSquared[i] = real * real + imag * imag;
+	}
+}
@@ -0,0 +1,117 @@
+#pragma once
+/// <summary>
+/// Escape-time kernel calculating the Mandelbrot sequence of several pixels of a row at once.
+/// The scalar, AVX2 (4 pixels) and AVX-512 (8 pixels) versions give exactly the same results,
+/// the fastest one supported by the CPU is chosen at runtime.
+/// Each one has a float version calculating twice as many pixels at once, for the frames whose pixels are far enough apart.
+/// </summary>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define FPP_KERNEL_X86
+#endif
+
+/// <summary>
+/// Sequence of the center of the image calculated at full precision, for the perturbation :
+/// each pixel only calculates in double the small difference between its sequence and this one,
+/// so zooms deeper than the precision of a double still work
+/// </summary>
+typedef struct referenceOrbit {
+	const double* real; // Real part of z at each iteration, until it diverged or maxIteration
+	const double* imag; // Imaginary part of z at each iteration
+	int length; // Number of values of z
+	double rangeWidth; // Width of the area of the complex plane, exact however deep the zoom is
+	double rangeHeight; // Height of the area of the complex plane
+} referenceOrbit;
+
+/// <summary>
+/// Area of the complex plane drawn in the image and size of the image in pixels
+/// </summary>
+typedef struct viewport {
+	int pixelWidth;
+	int pixelHeight;
+	double minRangeX;
+	double maxRangeX;
+	double minRangeY;
+	double maxRangeY;
+	const referenceOrbit* reference; // Orbit of the center of the image for the perturbation, nullptr to calculate c from the ranges
+	int columnStep; // Distance in pixels between two consecutive pixels of a call to the kernel, more than 1 for the coarse passes of the progressive rendering
+	double juliaReal; // c of the Julia sets, only used by the variants of FractalEngine.h
+	double juliaImag;
+	double centerX[2]; // High and low parts of the DoubleDouble center of the image, only used by the double-double variants of FractalEngine.h
+	double centerY[2];
+	double rangeWidth; // Width of the area of the complex plane, exact however deep the zoom is, only used with centerX and centerY
+	double rangeHeight;
+} viewport;
+
+/// <summary>
+/// Versions of the kernel
+/// </summary>
+enum KernelType {
+	KERNEL_AUTO, // Fastest version supported by the CPU
+	KERNEL_SCALAR,
+	KERNEL_AVX2,
+	KERNEL_AVX512
+};
+
+/// <summary>
+/// Precision of the calculation of the pixels, chosen once per frame from the distance between two pixels
+/// </summary>
+enum PrecisionType {
+	PRECISION_AUTO, // The lowest precision still telling two pixels apart
+	PRECISION_FLOAT, // Twice as many pixels at once in the vectorized kernels, only for the Mandelbrot set of power 2
+	PRECISION_DOUBLE,
+	PRECISION_DOUBLE_DOUBLE // About 32 significant digits, calculated one pixel at a time by the variants of FractalEngine.h
+};
+
+/// <summary>
+/// Greatest squared modulus for which the sequence is considered as not diverging.
+/// sqrt(x) <= 2 is true exactly when x <= 4 + 2^-50 (the double following 4),
+/// so comparing the squared modulus with it gives the same result as comparing the modulus with 2.
+/// </summary>
+constexpr double escapeModulusSquared = 4.0000000000000008882;
+
+/// <summary>
+/// escapeModulusSquared of the float kernels, the float following 4 whose square root is rounded to 2
+/// </summary>
+constexpr float escapeModulusSquaredFloat = 4.000000476837158203125f;
+
+/// <summary>
+/// Shortcuts finding pixels inside the set without doing maxIteration iterations, combined with |.
+/// The pixels they find can't diverge, so the image is the same with or without them.
+/// </summary>
+enum InteriorCheck {
+	INTERIOR_CHECK_NONE = 0,
+	INTERIOR_CHECK_BULBS = 1, // c is inside the main cardioid or the period-2 bulb, tested before iterating
+	INTERIOR_CHECK_PERIODICITY = 2, // z comes back to exactly the same value as before (Brent's cycle detection), so it loops forever
+	INTERIOR_CHECK_ALL = 3
+};
+
+/// <summary>
+/// Number of iterations before the first value of z saved by the periodicity check, doubled at each new saved value
+/// </summary>
+constexpr int periodicityFirstCheck = 8;
+
+/// <summary>
+/// Signature of the versions of the kernel, the arguments of EscapeTimeRow with the InteriorCheck flags
+/// </summary>
+typedef void (*escapeTimeRowFunction)(const viewport&, int, int, int, int, int, int*, double*);
+
+bool SetKernel(KernelType);
+KernelType GetKernel();
+const char* GetKernelName();
+void SetInteriorChecks(int);
+int GetInteriorChecks();
+void SetFormulaKernel(escapeTimeRowFunction);
+void SetPrecision(PrecisionType);
+PrecisionType GetPrecision();
+const char* GetPrecisionName(PrecisionType);
+void EscapeTimeRow(const viewport&, int, int, int, int, int*, double*);
+
+// Versions of the kernel, use EscapeTimeRow to call the one chosen by SetKernel
+void EscapeTimeRowScalar(const viewport&, int, int, int, int, int, int*, double*);
+void EscapeTimeRowAvx2(const viewport&, int, int, int, int, int, int*, double*);
+void EscapeTimeRowAvx512(const viewport&, int, int, int, int, int, int*, double*);
+void EscapeTimeRowScalarFloat(const viewport&, int, int, int, int, int, int*, double*);
+void EscapeTimeRowAvx2Float(const viewport&, int, int, int, int, int, int*, double*);
+void EscapeTimeRowAvx512Float(const viewport&, int, int, int, int, int, int*, double*);
+void EscapeTimeRowPerturbation(const viewport&, int, int, int, int, int*, double*);
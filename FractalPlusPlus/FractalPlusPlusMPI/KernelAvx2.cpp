@@ -0,0 +1,180 @@
+#include "Kernel.h"
+
+#if defined(FPP_KERNEL_X86)
+#include <immintrin.h>
+
+// This file is compiled with AVX2 enabled (-mavx2 or /arch:AVX2), it must only be called when the CPU supports it.
+// It doesn't include any other header so no inline function compiled with AVX2 is shared with the rest of the program.
+
+/// <summary>
+/// AVX2 version of EscapeTimeRow, 4 pixels at a time.
+/// Every lane does the same operations in the same order as EscapeTimeRowScalar, so the results are identical.
+/// A lane stops changing once its pixel diverged or was found inside the set, and the loop ends when every lane stopped.
+/// </summary>
+void EscapeTimeRowAvx2(const viewport& view, int iYpos, int firstColumn, int count, int maxIteration, int interiorChecks, int* iterations, double* modulusSquared)
+{
+	constexpr int lanes = 4;
+	const __m256d pixelWidth = _mm256_set1_pd((double)view.pixelWidth);
+	const __m128i laneColumns = _mm_mullo_epi32(_mm_set1_epi32(view.columnStep), _mm_setr_epi32(0, 1, 2, 3));
+	const __m256d rangeX = _mm256_set1_pd(view.maxRangeX - view.minRangeX);
+	const __m256d minRangeX = _mm256_set1_pd(view.minRangeX);
+	const __m256d rangeYPos = _mm256_set1_pd((double)iYpos / (double)view.pixelHeight * (view.maxRangeY - view.minRangeY) + view.minRangeY);
+	const __m256d escape = _mm256_set1_pd(escapeModulusSquared);
+	const __m256d one = _mm256_set1_pd(1.0);
+	const __m256d quarter = _mm256_set1_pd(0.25);
+	const __m256d sixteenth = _mm256_set1_pd(0.0625);
+
+	for (int i = 0; i < count; i += lanes)
+	{
+		// The lanes after the end of the row are calculated but not stored
+		__m128i columns = _mm_add_epi32(_mm_set1_epi32(firstColumn + i * view.columnStep), laneColumns);
+		__m256d rangeXPos = _mm256_add_pd(_mm256_mul_pd(_mm256_div_pd(_mm256_cvtepi32_pd(columns), pixelWidth), rangeX), minRangeX);
+
+		// Lanes found inside the set, all bits set
+		__m256d interior = _mm256_setzero_pd();
+		if (interiorChecks & INTERIOR_CHECK_BULBS) {
+			// Same test as IsInMainBulbs
+			__m256d shiftedX = _mm256_sub_pd(rangeXPos, quarter);
+			__m256d imagSquared = _mm256_mul_pd(rangeYPos, rangeYPos);
+			__m256d q = _mm256_add_pd(_mm256_mul_pd(shiftedX, shiftedX), imagSquared);
+			__m256d cardioid = _mm256_cmp_pd(_mm256_mul_pd(q, _mm256_add_pd(q, shiftedX)), _mm256_mul_pd(quarter, imagSquared), _CMP_LT_OQ);
+			__m256d shiftedBulbX = _mm256_add_pd(rangeXPos, one);
+			__m256d bulb = _mm256_cmp_pd(_mm256_add_pd(_mm256_mul_pd(shiftedBulbX, shiftedBulbX), imagSquared), sixteenth, _CMP_LT_OQ);
+			interior = _mm256_or_pd(cardioid, bulb);
+		}
+
+		__m256d real = _mm256_setzero_pd();
+		__m256d imag = _mm256_setzero_pd();
+		__m256d iteration = _mm256_setzero_pd();
+		// Same periodicity check as EscapeTimeRowScalar, the saved values are replaced at the same iterations for every lane
+		__m256d savedReal = real;
+		__m256d savedImag = imag;
+		int savedAge = 0;
+		int checkLength = periodicityFirstCheck;
+		for (int n = 0; n < maxIteration; n++)
+		{
+			__m256d realSquared = _mm256_mul_pd(real, real);
+			__m256d imagSquared = _mm256_mul_pd(imag, imag);
+			__m256d running = _mm256_andnot_pd(interior, _mm256_cmp_pd(_mm256_add_pd(realSquared, imagSquared), escape, _CMP_LE_OQ));
+			if (_mm256_movemask_pd(running) == 0) {
+				break; // Every pixel diverged or is inside the set
+			}
+
+			__m256d realImag = _mm256_mul_pd(real, imag);
+			__m256d nextReal = _mm256_add_pd(_mm256_sub_pd(realSquared, imagSquared), rangeXPos);
+			__m256d nextImag = _mm256_add_pd(_mm256_add_pd(realImag, _mm256_mul_pd(imag, real)), rangeYPos);
+			real = _mm256_blendv_pd(real, nextReal, running);
+			imag = _mm256_blendv_pd(imag, nextImag, running);
+			iteration = _mm256_add_pd(iteration, _mm256_and_pd(running, one));
+
+			if (interiorChecks & INTERIOR_CHECK_PERIODICITY) {
+				// Only the lanes which just changed, a stopped lane stays equal to itself
+				__m256d cycle = _mm256_and_pd(_mm256_cmp_pd(real, savedReal, _CMP_EQ_OQ), _mm256_cmp_pd(imag, savedImag, _CMP_EQ_OQ));
+				interior = _mm256_or_pd(interior, _mm256_and_pd(cycle, running));
+				if (++savedAge == checkLength) {
+					savedReal = real;
+					savedImag = imag;
+					savedAge = 0;
+					checkLength *= 2;
+				}
+			}
+		}
+		iteration = _mm256_blendv_pd(iteration, _mm256_set1_pd((double)maxIteration), interior);
+
+		alignas(32) double laneIterations[lanes];
+		alignas(32) double laneModulusSquared[lanes];
+		_mm256_store_pd(laneIterations, iteration);
+		_mm256_store_pd(laneModulusSquared, _mm256_add_pd(_mm256_mul_pd(real, real), _mm256_mul_pd(imag, imag)));
+		for (int lane = 0; lane < lanes && i + lane < count; lane++)
+		{
+			iterations[i + lane] = (int)laneIterations[lane];
+			modulusSquared[i + lane] = laneModulusSquared[lane];
+		}
+	}
+}
+
+/// <summary>
+/// AVX2 version of EscapeTimeRowScalarFloat, 8 pixels at a time.
+/// Every lane does the same operations in the same order as EscapeTimeRowScalarFloat, so the results are identical.
+/// The iterations are counted in integers, a float only counting exactly up to 2^24.
+/// </summary>
+void EscapeTimeRowAvx2Float(const viewport& view, int iYpos, int firstColumn, int count, int maxIteration, int interiorChecks, int* iterations, double* modulusSquared)
+{
+	constexpr int lanes = 8;
+	const __m256 pixelWidth = _mm256_set1_ps((float)view.pixelWidth);
+	const __m256i laneColumns = _mm256_mullo_epi32(_mm256_set1_epi32(view.columnStep), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+	const __m256 rangeX = _mm256_set1_ps((float)(view.maxRangeX - view.minRangeX));
+	const __m256 minRangeX = _mm256_set1_ps((float)view.minRangeX);
+	const __m256 rangeYPos = _mm256_set1_ps((float)((double)iYpos / (double)view.pixelHeight * (view.maxRangeY - view.minRangeY) + view.minRangeY));
+	const __m256 escape = _mm256_set1_ps(escapeModulusSquaredFloat);
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 quarter = _mm256_set1_ps(0.25f);
+	const __m256 sixteenth = _mm256_set1_ps(0.0625f);
+
+	for (int i = 0; i < count; i += lanes)
+	{
+		// The lanes after the end of the row are calculated but not stored
+		__m256i columns = _mm256_add_epi32(_mm256_set1_epi32(firstColumn + i * view.columnStep), laneColumns);
+		__m256 rangeXPos = _mm256_add_ps(_mm256_mul_ps(_mm256_div_ps(_mm256_cvtepi32_ps(columns), pixelWidth), rangeX), minRangeX);
+
+		// Lanes found inside the set, all bits set
+		__m256 interior = _mm256_setzero_ps();
+		if (interiorChecks & INTERIOR_CHECK_BULBS) {
+			__m256 shiftedX = _mm256_sub_ps(rangeXPos, quarter);
+			__m256 imagSquared = _mm256_mul_ps(rangeYPos, rangeYPos);
+			__m256 q = _mm256_add_ps(_mm256_mul_ps(shiftedX, shiftedX), imagSquared);
+			__m256 cardioid = _mm256_cmp_ps(_mm256_mul_ps(q, _mm256_add_ps(q, shiftedX)), _mm256_mul_ps(quarter, imagSquared), _CMP_LT_OQ);
+			__m256 shiftedBulbX = _mm256_add_ps(rangeXPos, one);
+			__m256 bulb = _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(shiftedBulbX, shiftedBulbX), imagSquared), sixteenth, _CMP_LT_OQ);
+			interior = _mm256_or_ps(cardioid, bulb);
+		}
+
+		__m256 real = _mm256_setzero_ps();
+		__m256 imag = _mm256_setzero_ps();
+		__m256i iteration = _mm256_setzero_si256();
+		__m256 savedReal = real;
+		__m256 savedImag = imag;
+		int savedAge = 0;
+		int checkLength = periodicityFirstCheck;
+		for (int n = 0; n < maxIteration; n++)
+		{
+			__m256 realSquared = _mm256_mul_ps(real, real);
+			__m256 imagSquared = _mm256_mul_ps(imag, imag);
+			__m256 running = _mm256_andnot_ps(interior, _mm256_cmp_ps(_mm256_add_ps(realSquared, imagSquared), escape, _CMP_LE_OQ));
+			if (_mm256_movemask_ps(running) == 0) {
+				break; // Every pixel diverged or is inside the set
+			}
+
+			__m256 realImag = _mm256_mul_ps(real, imag);
+			__m256 nextReal = _mm256_add_ps(_mm256_sub_ps(realSquared, imagSquared), rangeXPos);
+			__m256 nextImag = _mm256_add_ps(_mm256_add_ps(realImag, _mm256_mul_ps(imag, real)), rangeYPos);
+			real = _mm256_blendv_ps(real, nextReal, running);
+			imag = _mm256_blendv_ps(imag, nextImag, running);
+			// The running lanes are -1
+			iteration = _mm256_sub_epi32(iteration, _mm256_castps_si256(running));
+
+			if (interiorChecks & INTERIOR_CHECK_PERIODICITY) {
+				__m256 cycle = _mm256_and_ps(_mm256_cmp_ps(real, savedReal, _CMP_EQ_OQ), _mm256_cmp_ps(imag, savedImag, _CMP_EQ_OQ));
+				interior = _mm256_or_ps(interior, _mm256_and_ps(cycle, running));
+				if (++savedAge == checkLength) {
+					savedReal = real;
+					savedImag = imag;
+					savedAge = 0;
+					checkLength *= 2;
+				}
+			}
+		}
+		iteration = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(iteration), _mm256_castsi256_ps(_mm256_set1_epi32(maxIteration)), interior));
+
+		alignas(32) int laneIterations[lanes];
+		alignas(32) float laneModulusSquared[lanes];
+		_mm256_store_si256((__m256i*)laneIterations, iteration);
+		_mm256_store_ps(laneModulusSquared, _mm256_add_ps(_mm256_mul_ps(real, real), _mm256_mul_ps(imag, imag)));
+		for (int lane = 0; lane < lanes && i + lane < count; lane++)
+		{
+			iterations[i + lane] = laneIterations[lane];
+			modulusSquared[i + lane] = laneModulusSquared[lane];
+		}
+	}
+}
+#endif
@@ -0,0 +1,184 @@
+#include "Kernel.h"
+
+#if defined(FPP_KERNEL_X86)
+#include <immintrin.h>
+
+// GCC 12 warns that the undefined vector of _mm512_cvtepi32_pd and _mm512_cvtepi32_ps may be used uninitialized
+// once they are inlined in the kernels, it is only the unused destination of their unmasked conversion
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+// This file is compiled with AVX-512 enabled (-mavx512f or /arch:AVX512), it must only be called when the CPU supports it.
+// It doesn't include any other header so no inline function compiled with AVX-512 is shared with the rest of the program.
+
+/// <summary>
+/// AVX-512 version of EscapeTimeRow, 8 pixels at a time.
+/// Every lane does the same operations in the same order as EscapeTimeRowScalar, so the results are identical.
+/// A lane stops changing once its pixel diverged or was found inside the set, and the loop ends when every lane stopped.
+/// </summary>
+void EscapeTimeRowAvx512(const viewport& view, int iYpos, int firstColumn, int count, int maxIteration, int interiorChecks, int* iterations, double* modulusSquared)
+{
+	constexpr int lanes = 8;
+	const __m512d pixelWidth = _mm512_set1_pd((double)view.pixelWidth);
+	const __m256i laneColumns = _mm256_mullo_epi32(_mm256_set1_epi32(view.columnStep), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+	const __m512d rangeX = _mm512_set1_pd(view.maxRangeX - view.minRangeX);
+	const __m512d minRangeX = _mm512_set1_pd(view.minRangeX);
+	const __m512d rangeYPos = _mm512_set1_pd((double)iYpos / (double)view.pixelHeight * (view.maxRangeY - view.minRangeY) + view.minRangeY);
+	const __m512d escape = _mm512_set1_pd(escapeModulusSquared);
+	const __m512d one = _mm512_set1_pd(1.0);
+	const __m512d quarter = _mm512_set1_pd(0.25);
+	const __m512d sixteenth = _mm512_set1_pd(0.0625);
+
+	for (int i = 0; i < count; i += lanes)
+	{
+		// The lanes after the end of the row are calculated but not stored
+		__m256i columns = _mm256_add_epi32(_mm256_set1_epi32(firstColumn + i * view.columnStep), laneColumns);
+		__m512d rangeXPos = _mm512_add_pd(_mm512_mul_pd(_mm512_div_pd(_mm512_cvtepi32_pd(columns), pixelWidth), rangeX), minRangeX);
+
+		// Lanes found inside the set
+		__mmask8 interior = 0;
+		if (interiorChecks & INTERIOR_CHECK_BULBS) {
+			// Same test as IsInMainBulbs
+			__m512d shiftedX = _mm512_sub_pd(rangeXPos, quarter);
+			__m512d imagSquared = _mm512_mul_pd(rangeYPos, rangeYPos);
+			__m512d q = _mm512_add_pd(_mm512_mul_pd(shiftedX, shiftedX), imagSquared);
+			__mmask8 cardioid = _mm512_cmp_pd_mask(_mm512_mul_pd(q, _mm512_add_pd(q, shiftedX)), _mm512_mul_pd(quarter, imagSquared), _CMP_LT_OQ);
+			__m512d shiftedBulbX = _mm512_add_pd(rangeXPos, one);
+			__mmask8 bulb = _mm512_cmp_pd_mask(_mm512_add_pd(_mm512_mul_pd(shiftedBulbX, shiftedBulbX), imagSquared), sixteenth, _CMP_LT_OQ);
+			interior = cardioid | bulb;
+		}
+
+		__m512d real = _mm512_setzero_pd();
+		__m512d imag = _mm512_setzero_pd();
+		__m512d iteration = _mm512_setzero_pd();
+		// Same periodicity check as EscapeTimeRowScalar, the saved values are replaced at the same iterations for every lane
+		__m512d savedReal = real;
+		__m512d savedImag = imag;
+		int savedAge = 0;
+		int checkLength = periodicityFirstCheck;
+		for (int n = 0; n < maxIteration; n++)
+		{
+			__m512d realSquared = _mm512_mul_pd(real, real);
+			__m512d imagSquared = _mm512_mul_pd(imag, imag);
+			__mmask8 running = _mm512_cmp_pd_mask(_mm512_add_pd(realSquared, imagSquared), escape, _CMP_LE_OQ) & ~interior;
+			if (running == 0) {
+				break; // Every pixel diverged or is inside the set
+			}
+
+			__m512d realImag = _mm512_mul_pd(real, imag);
+			__m512d nextReal = _mm512_add_pd(_mm512_sub_pd(realSquared, imagSquared), rangeXPos);
+			__m512d nextImag = _mm512_add_pd(_mm512_add_pd(realImag, _mm512_mul_pd(imag, real)), rangeYPos);
+			real = _mm512_mask_mov_pd(real, running, nextReal);
+			imag = _mm512_mask_mov_pd(imag, running, nextImag);
+			iteration = _mm512_mask_add_pd(iteration, running, iteration, one);
+
+			if (interiorChecks & INTERIOR_CHECK_PERIODICITY) {
+				// Only the lanes which just changed, a stopped lane stays equal to itself
+				interior |= _mm512_mask_cmp_pd_mask(running, real, savedReal, _CMP_EQ_OQ) & _mm512_cmp_pd_mask(imag, savedImag, _CMP_EQ_OQ);
+				if (++savedAge == checkLength) {
+					savedReal = real;
+					savedImag = imag;
+					savedAge = 0;
+					checkLength *= 2;
+				}
+			}
+		}
+		iteration = _mm512_mask_mov_pd(iteration, interior, _mm512_set1_pd((double)maxIteration));
+
+		alignas(64) double laneIterations[lanes];
+		alignas(64) double laneModulusSquared[lanes];
+		_mm512_store_pd(laneIterations, iteration);
+		_mm512_store_pd(laneModulusSquared, _mm512_add_pd(_mm512_mul_pd(real, real), _mm512_mul_pd(imag, imag)));
+		for (int lane = 0; lane < lanes && i + lane < count; lane++)
+		{
+			iterations[i + lane] = (int)laneIterations[lane];
+			modulusSquared[i + lane] = laneModulusSquared[lane];
+		}
+	}
+}
+
+/// <summary>
+/// AVX-512 version of EscapeTimeRowScalarFloat, 16 pixels at a time.
+/// Every lane does the same operations in the same order as EscapeTimeRowScalarFloat, so the results are identical.
+/// The iterations are counted in integers, a float only counting exactly up to 2^24.
+/// </summary>
+void EscapeTimeRowAvx512Float(const viewport& view, int iYpos, int firstColumn, int count, int maxIteration, int interiorChecks, int* iterations, double* modulusSquared)
+{
+	constexpr int lanes = 16;
+	const __m512 pixelWidth = _mm512_set1_ps((float)view.pixelWidth);
+	const __m512i laneColumns = _mm512_mullo_epi32(_mm512_set1_epi32(view.columnStep), _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+	const __m512 rangeX = _mm512_set1_ps((float)(view.maxRangeX - view.minRangeX));
+	const __m512 minRangeX = _mm512_set1_ps((float)view.minRangeX);
+	const __m512 rangeYPos = _mm512_set1_ps((float)((double)iYpos / (double)view.pixelHeight * (view.maxRangeY - view.minRangeY) + view.minRangeY));
+	const __m512 escape = _mm512_set1_ps(escapeModulusSquaredFloat);
+	const __m512 one = _mm512_set1_ps(1.0f);
+	const __m512 quarter = _mm512_set1_ps(0.25f);
+	const __m512 sixteenth = _mm512_set1_ps(0.0625f);
+	const __m512i increment = _mm512_set1_epi32(1);
+
+	for (int i = 0; i < count; i += lanes)
+	{
+		// The lanes after the end of the row are calculated but not stored
+		__m512i columns = _mm512_add_epi32(_mm512_set1_epi32(firstColumn + i * view.columnStep), laneColumns);
+		__m512 rangeXPos = _mm512_add_ps(_mm512_mul_ps(_mm512_div_ps(_mm512_cvtepi32_ps(columns), pixelWidth), rangeX), minRangeX);
+
+		// Lanes found inside the set
+		__mmask16 interior = 0;
+		if (interiorChecks & INTERIOR_CHECK_BULBS) {
+			__m512 shiftedX = _mm512_sub_ps(rangeXPos, quarter);
+			__m512 imagSquared = _mm512_mul_ps(rangeYPos, rangeYPos);
+			__m512 q = _mm512_add_ps(_mm512_mul_ps(shiftedX, shiftedX), imagSquared);
+			__mmask16 cardioid = _mm512_cmp_ps_mask(_mm512_mul_ps(q, _mm512_add_ps(q, shiftedX)), _mm512_mul_ps(quarter, imagSquared), _CMP_LT_OQ);
+			__m512 shiftedBulbX = _mm512_add_ps(rangeXPos, one);
+			__mmask16 bulb = _mm512_cmp_ps_mask(_mm512_add_ps(_mm512_mul_ps(shiftedBulbX, shiftedBulbX), imagSquared), sixteenth, _CMP_LT_OQ);
+			interior = cardioid | bulb;
+		}
+
+		__m512 real = _mm512_setzero_ps();
+		__m512 imag = _mm512_setzero_ps();
+		__m512i iteration = _mm512_setzero_si512();
+		__m512 savedReal = real;
+		__m512 savedImag = imag;
+		int savedAge = 0;
+		int checkLength = periodicityFirstCheck;
+		for (int n = 0; n < maxIteration; n++)
+		{
+			__m512 realSquared = _mm512_mul_ps(real, real);
+			__m512 imagSquared = _mm512_mul_ps(imag, imag);
+			__mmask16 running = _mm512_cmp_ps_mask(_mm512_add_ps(realSquared, imagSquared), escape, _CMP_LE_OQ) & ~interior;
+			if (running == 0) {
+				break; // Every pixel diverged or is inside the set
+			}
+
+			__m512 realImag = _mm512_mul_ps(real, imag);
+			__m512 nextReal = _mm512_add_ps(_mm512_sub_ps(realSquared, imagSquared), rangeXPos);
+			__m512 nextImag = _mm512_add_ps(_mm512_add_ps(realImag, _mm512_mul_ps(imag, real)), rangeYPos);
+			real = _mm512_mask_mov_ps(real, running, nextReal);
+			imag = _mm512_mask_mov_ps(imag, running, nextImag);
+			iteration = _mm512_mask_add_epi32(iteration, running, iteration, increment);
+
+			if (interiorChecks & INTERIOR_CHECK_PERIODICITY) {
+				interior |= _mm512_mask_cmp_ps_mask(running, real, savedReal, _CMP_EQ_OQ) & _mm512_cmp_ps_mask(imag, savedImag, _CMP_EQ_OQ);
+				if (++savedAge == checkLength) {
+					savedReal = real;
+					savedImag = imag;
+					savedAge = 0;
+					checkLength *= 2;
+				}
+			}
+		}
+		iteration = _mm512_mask_mov_epi32(iteration, interior, _mm512_set1_epi32(maxIteration));
+
+		alignas(64) int laneIterations[lanes];
+		alignas(64) float laneModulusSquared[lanes];
+		_mm512_store_si512(laneIterations, iteration);
+		_mm512_store_ps(laneModulusSquared, _mm512_add_ps(_mm512_mul_ps(real, real), _mm512_mul_ps(imag, imag)));
+		for (int lane = 0; lane < lanes && i + lane < count; lane++)
+		{
+			iterations[i + lane] = laneIterations[lane];
+			modulusSquared[i + lane] = laneModulusSquared[lane];
+		}
+	}
+}
+#endif
@@ -0,0 +1,199 @@
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <mpi.h>
+
+#include "LargeImageRenderer.h"
+#include "Schedules.h"
+
+static void ReadCheckpoint(const FractalRenderer&, int, RenderJournal&, const largeImageOptions&);
+static std::vector<long long> ResumeLargeImage(FractalRenderer&, int, int, ImageFile&, RenderJournal&, const largeImageOptions&);
+
+/// <summary>
+/// Calculate an image of any size in the file of options, without ever holding it in memory.
+/// The image is split in units (tiles, or bands of rows with the raw layout) handed out in turn to the ranks,
+/// each rank colors its units and writes them straight at their place in the file with MPI-IO,
+/// writing a unit while calculating the next one.
+/// The palette is applied to each unit alone, so the histogram palette which needs the whole image can't be used.
+/// With a checkpoint directory, each rank journals the units it has written, and the units of the journals still in the file
+/// are skipped, so a render killed before its end only calculates the missing units when started again.
+/// </summary>
+/// <param name="renderer">renderer calculating the image</param>
+/// <param name="rank">rank of the current process</param>
+/// <param name="numtasks">number of MPI ranks</param>
+/// <param name="options">image file and checkpoint of --output</param>
+void RenderLargeImage(FractalRenderer& renderer, int rank, int numtasks, const largeImageOptions& options)
+{
+	if (renderer.palette == PALETTE_HISTOGRAM) {
+		throw std::invalid_argument("The histogram palette needs the whole image, it can't be used with --output");
+	}
+	renderer.engine = GetFractalEngine(renderer.fractal);
+	SetFormulaKernel(renderer.engine.escapeTimeRow);
+	renderer.phaseTrace.NextFrame();
+
+	RenderJournal journal;
+	if (!options.checkpointDirectory.empty()) {
+		// Before opening the image file, which would be resized if the checkpoint is the one of another render
+		ReadCheckpoint(renderer, rank, journal, options);
+	}
+	ImageFile image;
+	image.Open(options.path, renderer.pixelWidth, renderer.pixelHeight, options.layout, options.tileSize);
+	long long unitCount = image.GetUnitCount();
+	if (rank == 0) {
+		std::cout << "Calculating " << (long long)renderer.pixelWidth * renderer.pixelHeight << " pixels in " << unitCount << " units of at most "
+			<< image.GetUnitPixels() << " pixels with the " << GetKernelName() << " kernel and " << renderer.threadPool->GetThreadCount() << " threads per rank" << std::endl;
+		std::cout << "--------------------------------------------------" << std::endl;
+	}
+	std::vector<long long> units;
+	if (options.checkpointDirectory.empty()) {
+		units.resize(unitCount);
+		std::iota(units.begin(), units.end(), 0LL);
+	}
+	else {
+		units = ResumeLargeImage(renderer, rank, numtasks, image, journal, options);
+	}
+	renderer.PrepareReferenceOrbit(rank);
+	renderer.PreparePrecision(rank);
+
+	// Two buffers of colors, one being written while the other one is colored
+	std::vector<float> unitIterations(image.GetUnitPixels());
+	std::vector<color> unitPixels[2] = { std::vector<color>(unitIterations.size()), std::vector<color>(unitIterations.size()) };
+	MPI_Request writes[2] = { MPI_REQUEST_NULL, MPI_REQUEST_NULL };
+	int buffer = 0;
+	// Unit being written from each buffer and its checksum, journaled once the write is done
+	long long writtenUnits[2] = { -1, -1 };
+	uint64_t writtenChecksums[2] = { 0, 0 };
+	auto journalWrite = [&](int done) {
+		if (!options.checkpointDirectory.empty() && writtenUnits[done] >= 0) {
+			journal.Append(writtenUnits[done], writtenChecksums[done]);
+		}
+		writtenUnits[done] = -1;
+	};
+
+	rankStatistics statistics = { 0, 0, 0, 0, 0 };
+	renderer.kernelIterations = 0;
+	for (size_t next = rank; next < units.size(); next += numtasks) {
+		long long index = units[next];
+		imageUnit unit = image.GetUnit(index);
+		if (unit.width < unit.stride || (long long)unit.height * unit.stride < unit.pixels) {
+			// The padding of the tiles of the edges is black
+			std::fill(unitIterations.begin(), unitIterations.end(), interiorIteration);
+		}
+
+		double startTime = MPI_Wtime();
+		double traceStart = renderer.phaseTrace.Now();
+		long long previousIterations = renderer.kernelIterations;
+		renderer.ComputeRegion(unit.left, unit.top, unit.width, unit.height, unit.stride, unitIterations.data());
+		statistics.busyTime += MPI_Wtime() - startTime;
+		statistics.chunks++;
+		statistics.pixels += (double)unit.width * unit.height;
+		statistics.iteratedPixels += (double)unit.width * unit.height;
+		renderer.phaseTrace.Add(PHASE_COMPUTE, traceStart, (double)(renderer.kernelIterations - previousIterations));
+
+		traceStart = renderer.phaseTrace.Now();
+		MPI_Wait(&writes[buffer], MPI_STATUS_IGNORE);
+		journalWrite(buffer);
+		renderer.phaseTrace.Add(PHASE_WRITE, traceStart, (double)unit.pixels);
+
+		traceStart = renderer.phaseTrace.Now();
+		Colorize(unitIterations.data(), (size_t)unit.pixels, renderer.maxIteration, renderer.palette, (unsigned char*)unitPixels[buffer].data());
+		if (!options.checkpointDirectory.empty()) {
+			writtenUnits[buffer] = index;
+			writtenChecksums[buffer] = ChecksumPixels((const uint32_t*)unitPixels[buffer].data(), unit.pixels);
+		}
+		renderer.phaseTrace.Add(PHASE_ENCODE, traceStart, (double)unit.pixels);
+		image.BeginWrite(unit, unitPixels[buffer].data(), &writes[buffer]);
+		buffer = 1 - buffer;
+	}
+	double traceStart = renderer.phaseTrace.Now();
+	MPI_Waitall(2, writes, MPI_STATUSES_IGNORE);
+	journalWrite(0);
+	journalWrite(1);
+	renderer.phaseTrace.Add(PHASE_WRITE, traceStart, 0);
+
+	statistics.iterations = (double)renderer.kernelIterations;
+	image.Close();
+	ReportStatistics(renderer, rank, numtasks, statistics);
+	if (rank == 0) {
+		std::cout << "Image of " << renderer.pixelWidth << "x" << renderer.pixelHeight << " pixels written in " << options.path << " ("
+			<< (double)image.GetFileSize() / (1 << 20) << " MB)" << std::endl;
+	}
+}
+
+/// <summary>
+/// Read the journals of the checkpoint directory, refusing the ones of another render
+/// </summary>
+/// <param name="renderer">renderer calculating the image</param>
+/// <param name="rank">rank of the current process</param>
+/// <param name="journal">filled with the journals read</param>
+/// <param name="options">image file and checkpoint of --output</param>
+static void ReadCheckpoint(const FractalRenderer& renderer, int rank, RenderJournal& journal, const largeImageOptions& options)
+{
+	if (rank == 0) {
+		std::filesystem::create_directories(options.checkpointDirectory);
+	}
+	MPI_Barrier(MPI_COMM_WORLD);
+
+	// Every parameter changing the colors of the units
+	std::ostringstream description;
+	int digits = (int)(renderer.centerX.GetFractionLimbs() * 32 * 0.30103) + 2;
+	description << std::hexfloat << renderer.pixelWidth << " " << renderer.pixelHeight << " " << options.layout << " " << options.tileSize << " "
+		<< renderer.centerX.ToString(digits) << " " << renderer.centerY.ToString(digits) << " " << renderer.rangeWidth << " " << renderer.rangeHeight << " "
+		<< renderer.maxIteration << " " << HashFractalParameters(renderer.fractal) << " " << renderer.palette << " " << renderer.precisionMode << " " << renderer.perturbationMode;
+	journal.Read(options.checkpointDirectory, description.str());
+}
+
+/// <summary>
+/// Find the units of the image still to calculate from the journals read by ReadCheckpoint, then start the journal of the rank.
+/// Each recorded unit is read back from the image file and kept only if its checksum matches, so the units whose write
+/// didn't reach the disk before the end of the program, or of an image file replaced since, are calculated again.
+/// The recorded units are checked by every rank in turn, which then share their results.
+/// </summary>
+/// <param name="renderer">renderer calculating the image</param>
+/// <param name="rank">rank of the current process</param>
+/// <param name="numtasks">number of MPI ranks</param>
+/// <param name="image">image file opened by every rank</param>
+/// <param name="journal">journals read, made ready to record the units written by the rank</param>
+/// <param name="options">image file and checkpoint of --output</param>
+/// <returns>index of each unit to calculate, in the order of the image, the same for every rank</returns>
+static std::vector<long long> ResumeLargeImage(FractalRenderer& renderer, int rank, int numtasks, ImageFile& image, RenderJournal& journal, const largeImageOptions& options)
+{
+	// Units in the order of the image so every rank checks the same ones
+	long long unitCount = image.GetUnitCount();
+	std::vector<long long> recorded;
+	for (const auto& record : journal.GetRecordedUnits()) {
+		if (record.first >= 0 && record.first < unitCount) {
+			recorded.push_back(record.first);
+		}
+	}
+	std::sort(recorded.begin(), recorded.end());
+
+	double traceStart = renderer.phaseTrace.Now();
+	std::vector<unsigned char> written(unitCount, 0);
+	std::vector<color> unitPixels(image.GetUnitPixels());
+	for (size_t i = rank; i < recorded.size(); i += numtasks) {
+		imageUnit unit = image.GetUnit(recorded[i]);
+		written[recorded[i]] = image.ReadUnit(unit, unitPixels.data())
+			&& ChecksumPixels((const uint32_t*)unitPixels.data(), unit.pixels) == journal.GetRecordedUnits().at(recorded[i]);
+	}
+	// Every rank has read the journals once this is done, so they can be written
+	MPI_Allreduce(MPI_IN_PLACE, written.data(), (int)unitCount, MPI_UNSIGNED_CHAR, MPI_MAX, MPI_COMM_WORLD);
+	renderer.phaseTrace.Add(PHASE_WRITE, traceStart, (double)recorded.size());
+	journal.StartWriting(rank);
+
+	std::vector<long long> units;
+	for (long long index = 0; index < unitCount; index++) {
+		if (!written[index]) {
+			units.push_back(index);
+		}
+	}
+	if (rank == 0) {
+		long long kept = unitCount - (long long)units.size();
+		std::cout << "Checkpoint " << options.checkpointDirectory << " : " << kept << " units already written, " << recorded.size() - kept
+			<< " recorded ones damaged, " << units.size() << " units to calculate" << std::endl;
+	}
+	return units;
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include <string>
+
+#include "FractalRenderer.h"
+#include "ImageFile.h"
+#include "RenderJournal.h"
+
+/// <summary>
+/// Image file of --output, written straight by every rank with MPI-IO
+/// </summary>
+typedef struct largeImageOptions {
+	std::string path; // Empty to write /tmp/Mandelbrot.bmp from rank 0
+	ImageLayout layout = LAYOUT_TILED; // Order of the pixels in the file
+	int tileSize = 256; // Width and height of the tiles, a unit of the raw layout has about as many pixels
+	std::string checkpointDirectory; // Directory of the journals of the units already written, empty to always calculate the whole image
+} largeImageOptions;
+
+void RenderLargeImage(FractalRenderer&, int, int, const largeImageOptions&);
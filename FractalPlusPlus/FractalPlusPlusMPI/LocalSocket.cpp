@@ -0,0 +1,208 @@
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32) && !defined(__CYGWIN__)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+typedef int socketLength;
+typedef SOCKET nativeSocket;
+#define MSG_NOSIGNAL 0 // Windows doesn't raise a signal when sending on a closed socket
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#define closesocket close
+typedef socklen_t socketLength;
+typedef int nativeSocket;
+#endif
+
+#include "LocalSocket.h"
+
+
+/// <summary>
+/// Initialize the socket library, needed once before using sockets on Windows
+/// </summary>
+/// <returns>false if the sockets can't be used</returns>
+bool InitializeSockets()
+{
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32) && !defined(__CYGWIN__)
+	WSADATA wsaData;
+	return WSAStartup(MAKEWORD(2, 2), &wsaData) == 0;
+#else
+	return true;
+#endif
+}
+
+/// <summary>
+/// Create the address of a port of the loopback interface
+/// </summary>
+/// <param name="port">port of the address</param>
+/// <returns>address 127.0.0.1:port</returns>
+static sockaddr_in LocalAddress(int port)
+{
+	sockaddr_in address = {};
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	address.sin_port = htons((unsigned short)port);
+	return address;
+}
+
+/// <summary>
+/// Disable the Nagle algorithm, the messages are small and must be sent right away
+/// </summary>
+/// <param name="socket">connected socket</param>
+static void DisableNagle(socketHandle socket)
+{
+	int noDelay = 1;
+	setsockopt((nativeSocket)socket, IPPROTO_TCP, TCP_NODELAY, (const char*)&noDelay, sizeof(noDelay));
+}
+
+/// <summary>
+/// Ask the system for a port of the loopback interface nobody is listening on
+/// </summary>
+/// <returns>free port, or 0 on error</returns>
+int FindFreeLocalPort()
+{
+	socketHandle listener = ListenLocal(0);
+	if (listener == invalidSocket) {
+		return 0;
+	}
+	sockaddr_in address = {};
+	socketLength length = sizeof(address);
+	int port = 0;
+	if (getsockname((nativeSocket)listener, (sockaddr*)&address, &length) == 0) {
+		port = ntohs(address.sin_port);
+	}
+	CloseSocket(listener);
+	return port;
+}
+
+/// <summary>
+/// Create a socket listening on a port of the loopback interface
+/// </summary>
+/// <param name="port">port to listen on, 0 to let the system choose</param>
+/// <returns>listening socket, or invalidSocket on error</returns>
+socketHandle ListenLocal(int port)
+{
+	nativeSocket listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if ((socketHandle)listener == invalidSocket) {
+		return invalidSocket;
+	}
+#if !(defined(WIN32) || defined(_WIN32) || defined(__WIN32) && !defined(__CYGWIN__))
+	// A server started again right after the previous one can bind its port while its connections are still in TIME_WAIT.
+	// Not on Windows, where SO_REUSEADDR would let two sockets listen on the same port
+	int reuse = 1;
+	setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+#endif
+	sockaddr_in address = LocalAddress(port);
+	if (bind(listener, (sockaddr*)&address, sizeof(address)) != 0 || listen(listener, 1) != 0) {
+		closesocket(listener);
+		return invalidSocket;
+	}
+	return (socketHandle)listener;
+}
+
+/// <summary>
+/// Wait for a client to connect to a listening socket
+/// </summary>
+/// <param name="listener">listening socket</param>
+/// <returns>socket connected to the client, or invalidSocket on error</returns>
+socketHandle AcceptClient(socketHandle listener)
+{
+	nativeSocket client = accept((nativeSocket)listener, nullptr, nullptr);
+	if ((socketHandle)client == invalidSocket) {
+		return invalidSocket;
+	}
+	DisableNagle((socketHandle)client);
+	return (socketHandle)client;
+}
+
+/// <summary>
+/// Connect to a port of the loopback interface
+/// </summary>
+/// <param name="port">port to connect to</param>
+/// <returns>connected socket, or invalidSocket if nobody is listening</returns>
+socketHandle ConnectLocal(int port)
+{
+	nativeSocket server = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if ((socketHandle)server == invalidSocket) {
+		return invalidSocket;
+	}
+	sockaddr_in address = LocalAddress(port);
+	if (connect(server, (sockaddr*)&address, sizeof(address)) != 0) {
+		closesocket(server);
+		return invalidSocket;
+	}
+	DisableNagle((socketHandle)server);
+	return (socketHandle)server;
+}
+
+/// <summary>
+/// Send a whole buffer, send may only send a part of it at once
+/// </summary>
+/// <param name="socket">connected socket</param>
+/// <param name="buffer">data to send</param>
+/// <param name="size">size of the data in bytes</param>
+/// <returns>false if the connection is closed</returns>
+bool SendAll(socketHandle socket, const void* buffer, size_t size)
+{
+	const char* data = (const char*)buffer;
+	while (size > 0) {
+		int chunk = size > 1 << 30 ? 1 << 30 : (int)size;
+		auto sent = send((nativeSocket)socket, data, chunk, MSG_NOSIGNAL); // No SIGPIPE if the other side is gone
+		if (sent <= 0) {
+			return false;
+		}
+		data += sent;
+		size -= (size_t)sent;
+	}
+	return true;
+}
+
+/// <summary>
+/// Receive a whole buffer, recv may only receive a part of it at once
+/// </summary>
+/// <param name="socket">connected socket</param>
+/// <param name="buffer">filled with the data received</param>
+/// <param name="size">size of the data in bytes</param>
+/// <returns>false if the connection is closed</returns>
+bool ReceiveAll(socketHandle socket, void* buffer, size_t size)
+{
+	char* data = (char*)buffer;
+	while (size > 0) {
+		int chunk = size > 1 << 30 ? 1 << 30 : (int)size;
+		auto received = recv((nativeSocket)socket, data, chunk, 0);
+		if (received <= 0) {
+			return false;
+		}
+		data += received;
+		size -= (size_t)received;
+	}
+	return true;
+}
+
+/// <summary>
+/// Check without waiting if data can be received, or if the connection is closed
+/// </summary>
+/// <param name="socket">connected socket</param>
+/// <returns>true if recv won't block</returns>
+bool IsReadable(socketHandle socket)
+{
+	fd_set readable;
+	FD_ZERO(&readable);
+	FD_SET((nativeSocket)socket, &readable);
+	timeval noWait = {};
+	return select((int)socket + 1, &readable, nullptr, nullptr, &noWait) > 0; // The first argument is ignored on Windows
+}
+
+/// <summary>
+/// Close a socket
+/// </summary>
+/// <param name="socket">socket to close</param>
+void CloseSocket(socketHandle socket)
+{
+	if (socket != invalidSocket) {
+		closesocket((nativeSocket)socket);
+	}
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/// <summary>
+/// Minimal TCP sockets on the loopback interface (127.0.0.1), used by the GUI to talk to the render server.
+/// Works the same way with Winsock on Windows and BSD sockets on Linux.
+/// </summary>
+
+/// <summary>
+/// Handle of a socket, a SOCKET on Windows and a file descriptor on Linux
+/// </summary>
+typedef intptr_t socketHandle;
+
+/// <summary>
+/// Value of a socket handle when the socket couldn't be created
+/// </summary>
+constexpr socketHandle invalidSocket = -1;
+
+bool InitializeSockets();
+int FindFreeLocalPort();
+socketHandle ListenLocal(int);
+socketHandle AcceptClient(socketHandle);
+socketHandle ConnectLocal(int);
+bool SendAll(socketHandle, const void*, size_t);
+bool ReceiveAll(socketHandle, void*, size_t);
+bool IsReadable(socketHandle);
+void CloseSocket(socketHandle);
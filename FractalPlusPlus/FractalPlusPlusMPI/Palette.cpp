@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "Palette.h"
+
+
+/// <summary>
+/// Function coloring count smooth iteration counts into count pixels of 4 bytes (blue, green, red, unused)
+/// </summary>
+typedef void (*paletteFunction)(const float*, size_t, int, unsigned char*);
+
+/// <summary>
+/// Palette usable by Colorize
+/// </summary>
+typedef struct paletteEntry {
+	const char* name; // Name used by --palette and displayed by the GUI
+	paletteFunction colorize;
+} paletteEntry;
+
+/// <summary>
+/// Write a pixel
+/// </summary>
+/// <param name="pixel">4 bytes of the pixel</param>
+/// <param name="red">red between 0 and 1</param>
+/// <param name="green">green between 0 and 1</param>
+/// <param name="blue">blue between 0 and 1</param>
+static void WritePixel(unsigned char* pixel, double red, double green, double blue)
+{
+	pixel[0] = (unsigned char)(255.0 * std::clamp(blue, 0.0, 1.0));
+	pixel[1] = (unsigned char)(255.0 * std::clamp(green, 0.0, 1.0));
+	pixel[2] = (unsigned char)(255.0 * std::clamp(red, 0.0, 1.0));
+	pixel[3] = 0;
+}
+
+/// <summary>
+/// Gray proportional to the iteration count, black inside the set
+/// </summary>
+/// <param name="iterations">smooth iteration counts</param>
+/// <param name="count">number of pixels</param>
+/// <param name="maxIteration">number of iterations after which a pixel is considered as not diverging</param>
+/// <param name="pixels">4 bytes per pixel filled with the colors</param>
+static void ColorizeLinear(const float* iterations, size_t count, int maxIteration, unsigned char* pixels)
+{
+	for (size_t i = 0; i < count; i++) {
+		double value = iterations[i] == interiorIteration ? 0 : iterations[i] / (double)maxIteration;
+		WritePixel(pixels + i * 4, value, value, value);
+	}
+}
+
+/// <summary>
+/// Gray proportional to the square root of the iteration count, black inside the set.
+/// The square root brightens the first iterations, where most of the pixels around the set are.
+/// </summary>
+/// <param name="iterations">smooth iteration counts</param>
+/// <param name="count">number of pixels</param>
+/// <param name="maxIteration">number of iterations after which a pixel is considered as not diverging</param>
+/// <param name="pixels">4 bytes per pixel filled with the colors</param>
+static void ColorizeSqrt(const float* iterations, size_t count, int maxIteration, unsigned char* pixels)
+{
+	for (size_t i = 0; i < count; i++) {
+		double value = iterations[i] == interiorIteration ? 0 : sqrt(std::max(0.0, iterations[i] / (double)maxIteration));
+		WritePixel(pixels + i * 4, value, value, value);
+	}
+}
+
+/// <summary>
+/// Gray given by the share of the pixels of the frame escaping in fewer iterations (histogram equalization),
+/// so every frame uses the whole gray scale whatever its zoom and maxIteration. Black inside the set.
+/// </summary>
+/// <param name="iterations">smooth iteration counts</param>
+/// <param name="count">number of pixels</param>
+/// <param name="maxIteration">number of iterations after which a pixel is considered as not diverging</param>
+/// <param name="pixels">4 bytes per pixel filled with the colors</param>
+static void ColorizeHistogram(const float* iterations, size_t count, int maxIteration, unsigned char* pixels)
+{
+	// Number of escaping pixels per whole iteration count
+	std::vector<double> cumulative(maxIteration + 2, 0);
+	double escaping = 0;
+	for (size_t i = 0; i < count; i++) {
+		if (iterations[i] != interiorIteration) {
+			cumulative[std::clamp((int)iterations[i], 0, maxIteration) + 1]++;
+			escaping++;
+		}
+	}
+	// Share of the escaping pixels below each whole iteration count
+	for (int i = 1; i <= maxIteration + 1; i++) {
+		cumulative[i] += cumulative[i - 1];
+	}
+	for (double& share : cumulative) {
+		share /= std::max(escaping, 1.0);
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		double value = 0;
+		if (iterations[i] != interiorIteration) {
+			// Interpolate between the whole counts around the smooth count, so the bands don't show
+			double iteration = std::clamp((double)iterations[i], 0.0, (double)maxIteration);
+			int whole = std::min((int)iteration, maxIteration);
+			value = cumulative[whole] + (cumulative[whole + 1] - cumulative[whole]) * (iteration - whole);
+		}
+		WritePixel(pixels + i * 4, value, value, value);
+	}
+}
+
+/// <summary>
+/// Rainbow repeating every cyclicPeriod iterations, black inside the set.
+/// The colors don't depend on maxIteration, so the details of deep zooms stay visible.
+/// </summary>
+/// <param name="iterations">smooth iteration counts</param>
+/// <param name="count">number of pixels</param>
+/// <param name="maxIteration">number of iterations after which a pixel is considered as not diverging</param>
+/// <param name="pixels">4 bytes per pixel filled with the colors</param>
+static void ColorizeCyclic(const float* iterations, size_t count, int, unsigned char* pixels)
+{
+	const double twoPi = 6.283185307179586;
+	for (size_t i = 0; i < count; i++) {
+		if (iterations[i] == interiorIteration) {
+			WritePixel(pixels + i * 4, 0, 0, 0);
+			continue;
+		}
+		double phase = twoPi * iterations[i] / cyclicPeriod;
+		WritePixel(pixels + i * 4, 0.5 + 0.5 * cos(phase), 0.5 + 0.5 * cos(phase + twoPi / 3), 0.5 + 0.5 * cos(phase + 2 * twoPi / 3));
+	}
+}
+
+/// <summary>
+/// Palettes in the order of PaletteType, a new palette only needs a function and an entry here
+/// </summary>
+static const paletteEntry palettes[PALETTE_COUNT] = {
+	{ "linear", ColorizeLinear },
+	{ "sqrt", ColorizeSqrt },
+	{ "histogram", ColorizeHistogram },
+	{ "cyclic", ColorizeCyclic }
+};
+
+/// <summary>
+/// Find a palette from its name
+/// </summary>
+/// <param name="name">name of the palette</param>
+/// <param name="palette">set to the palette when it's found</param>
+/// <returns>false if no palette has this name</returns>
+bool FindPalette(const std::string& name, PaletteType* palette)
+{
+	for (int i = 0; i < (int)PALETTE_COUNT; i++) {
+		if (name == palettes[i].name) {
+			*palette = (PaletteType)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+/// <summary>
+/// Get the name of a palette
+/// </summary>
+/// <param name="palette">palette</param>
+/// <returns>name of the palette, "unknown" if it doesn't exist</returns>
+const char* GetPaletteName(PaletteType palette)
+{
+	return palette < PALETTE_COUNT ? palettes[palette].name : "unknown";
+}
+
+/// <summary>
+/// Color pixels from their smooth iteration counts
+/// </summary>
+/// <param name="iterations">smooth iteration counts, interiorIteration for the pixels inside the set</param>
+/// <param name="count">number of pixels</param>
+/// <param name="maxIteration">number of iterations after which a pixel is considered as not diverging</param>
+/// <param name="palette">palette to use, the sqrt palette if it doesn't exist</param>
+/// <param name="pixels">4 bytes per pixel (blue, green, red, unused) filled with the colors</param>
+void Colorize(const float* iterations, size_t count, int maxIteration, PaletteType palette, unsigned char* pixels)
+{
+	palettes[palette < PALETTE_COUNT ? palette : PALETTE_SQRT].colorize(iterations, count, maxIteration, pixels);
+}
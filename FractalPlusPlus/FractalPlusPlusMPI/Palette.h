@@ -0,0 +1,35 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/// <summary>
+/// Colorization of the smooth iteration counts calculated by the ranks.
+/// The counts are the product of a render, the palettes only map them to colors,
+/// so a frame can be recolored in a few milliseconds without calculating it again.
+/// </summary>
+
+/// <summary>
+/// Smooth iteration count of a pixel whose sequence doesn't diverge
+/// </summary>
+constexpr float interiorIteration = -1.0f;
+
+/// <summary>
+/// Palettes mapping the smooth iteration counts to colors, in the order of the palettes table of Palette.cpp
+/// </summary>
+enum PaletteType : uint32_t {
+	PALETTE_LINEAR, // Gray proportional to the iteration count
+	PALETTE_SQRT, // Gray proportional to the square root of the iteration count, the original look
+	PALETTE_HISTOGRAM, // Gray spread evenly over the pixels of the frame (histogram equalization)
+	PALETTE_CYCLIC, // Rainbow repeating every cyclicPeriod iterations
+	PALETTE_COUNT // Number of palettes
+};
+
+/// <summary>
+/// Number of iterations of one cycle of the cyclic palette
+/// </summary>
+constexpr double cyclicPeriod = 64;
+
+bool FindPalette(const std::string&, PaletteType*);
+const char* GetPaletteName(PaletteType);
+void Colorize(const float*, size_t, int, PaletteType, unsigned char*);
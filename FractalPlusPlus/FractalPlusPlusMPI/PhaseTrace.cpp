@@ -0,0 +1,156 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <mpi.h>
+
+#include "PhaseTrace.h"
+
+
+/// <summary>
+/// Start recording, called by every rank at the same time.
+/// The ranks leave the barrier together, so their times are comparable even on nodes whose clocks differ.
+/// </summary>
+void PhaseTrace::Start()
+{
+	MPI_Barrier(MPI_COMM_WORLD);
+	origin = MPI_Wtime();
+	wallClockOrigin = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+	enabled = true;
+}
+
+/// <summary>
+/// Whether the spans are recorded
+/// </summary>
+/// <returns>false if Start wasn't called</returns>
+bool PhaseTrace::IsEnabled() const
+{
+	return enabled;
+}
+
+/// <summary>
+/// Start a new frame, the next spans are added to it
+/// </summary>
+void PhaseTrace::NextFrame()
+{
+	frame++;
+}
+
+/// <summary>
+/// Get the time passed since the origin of the trace, to pass to Add at the end of the span
+/// </summary>
+/// <returns>time in seconds</returns>
+double PhaseTrace::Now() const
+{
+	return MPI_Wtime() - origin;
+}
+
+/// <summary>
+/// Add a span ending now to the current frame, nothing is done when the trace isn't started
+/// </summary>
+/// <param name="phase">phase of the span</param>
+/// <param name="start">time returned by Now at the start of the span</param>
+/// <param name="count">iterations, values or pixels handled during the span</param>
+void PhaseTrace::Add(TracePhase phase, double start, double count)
+{
+	if (enabled) {
+		spans.push_back({ start, Now() - start, (double)phase, (double)frame, count });
+	}
+}
+
+/// <summary>
+/// Gather the spans of every rank on rank 0, write them in a Chrome trace file with one process per rank,
+/// and display the total time of each phase summed over the ranks in one line. Called by every rank.
+/// </summary>
+/// <param name="rank">rank of the current process</param>
+/// <param name="numtasks">number of MPI ranks</param>
+/// <param name="path">path of the JSON file written by rank 0</param>
+void PhaseTrace::Write(int rank, int numtasks, const std::string& path) const
+{
+	constexpr int values = sizeof(traceSpan) / sizeof(double);
+	int count = (int)spans.size() * values;
+	std::vector<int> counts(rank == 0 ? numtasks : 0);
+	MPI_Gather(&count, 1, MPI_INT, counts.data(), 1, MPI_INT, 0, MPI_COMM_WORLD);
+
+	std::vector<int> displacements(counts.size());
+	for (size_t i = 1; i < counts.size(); i++) {
+		displacements[i] = displacements[i - 1] + counts[i - 1];
+	}
+	std::vector<traceSpan> allSpans(rank == 0 ? (displacements.back() + counts.back()) / values : 0);
+	MPI_Gatherv(spans.data(), count, MPI_DOUBLE, allSpans.data(), counts.data(), displacements.data(), MPI_DOUBLE, 0, MPI_COMM_WORLD);
+
+	// Name of the node of each rank
+	char machine[MPI_MAX_PROCESSOR_NAME] = {};
+	int machineLength;
+	MPI_Get_processor_name(machine, &machineLength);
+	std::vector<char> machines(rank == 0 ? (size_t)numtasks * MPI_MAX_PROCESSOR_NAME : 0);
+	MPI_Gather(machine, MPI_MAX_PROCESSOR_NAME, MPI_CHAR, machines.data(), MPI_MAX_PROCESSOR_NAME, MPI_CHAR, 0, MPI_COMM_WORLD);
+
+	if (rank != 0) {
+		return;
+	}
+
+	std::ofstream file(path, std::ios::trunc);
+	if (!file) {
+		throw std::runtime_error("Unable to write the trace in " + path);
+	}
+	file << std::fixed;
+	file.precision(3);
+	file << "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"wallClockOrigin\":" << wallClockOrigin << "},\"traceEvents\":[" << std::endl;
+	for (int i = 0; i < numtasks; i++) {
+		file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << i << ",\"args\":{\"name\":\"Rank " << i << " ("
+			<< &machines[(size_t)i * MPI_MAX_PROCESSOR_NAME] << ")\"}}," << std::endl;
+	}
+
+	// Times of the Chrome traces are in microseconds, the ranks are the processes
+	double phaseTimes[PHASE_COUNT] = {};
+	double iterations = 0;
+	double frames = 0;
+	for (int i = 0; i < numtasks; i++) {
+		for (int j = displacements[i] / values; j < (displacements[i] + counts[i]) / values; j++) {
+			const traceSpan& span = allSpans[j];
+			TracePhase phase = (TracePhase)(int)span.phase;
+			file << "{\"name\":\"" << GetPhaseName(phase) << "\",\"cat\":\"frame\",\"ph\":\"X\",\"pid\":" << i << ",\"tid\":0,\"ts\":" << span.start * 1e6
+				<< ",\"dur\":" << span.duration * 1e6 << ",\"args\":{\"frame\":" << (int)span.frame << ",\"count\":" << (long long)span.count << "}}," << std::endl;
+			phaseTimes[phase] += span.duration;
+			if (phase == PHASE_COMPUTE) {
+				iterations += span.count;
+			}
+			frames = std::max(frames, span.frame + 1);
+		}
+	}
+	// The last event closes the list without a trailing comma
+	file << "{\"name\":\"trace_end\",\"ph\":\"i\",\"s\":\"g\",\"pid\":0,\"tid\":0,\"ts\":" << Now() * 1e6 << "}]}" << std::endl;
+
+	std::cout << "Trace of " << frames << " frames on " << numtasks << " ranks :";
+	for (int phase = 0; phase < PHASE_COUNT; phase++) {
+		std::cout << " " << GetPhaseName((TracePhase)phase) << " " << phaseTimes[phase] << " s,";
+	}
+	std::cout << " " << iterations << " iterations, written in " << path << std::endl;
+}
+
+/// <summary>
+/// Get the name of a phase, as displayed in the trace
+/// </summary>
+/// <param name="phase">phase</param>
+/// <returns>name of the phase</returns>
+const char* GetPhaseName(TracePhase phase)
+{
+	switch (phase) {
+		case PHASE_COMPUTE:
+			return "compute";
+		case PHASE_SEND:
+			return "send";
+		case PHASE_RECEIVE:
+			return "receive";
+		case PHASE_WAIT:
+			return "wait";
+		case PHASE_ASSEMBLE:
+			return "assemble";
+		case PHASE_ENCODE:
+			return "encode";
+		default:
+			return "write";
+	}
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Phases of a frame recorded by the trace
+/// </summary>
+enum TracePhase {
+	PHASE_COMPUTE, // Calculation of pixels by the threads of the rank
+	PHASE_SEND, // Sending pixels to rank 0, including the wait until it receives them
+	PHASE_RECEIVE, // Waiting for pixels or for work from another rank
+	PHASE_WAIT, // Barrier between the passes of the progressive rendering
+	PHASE_ASSEMBLE, // Copy of the passes and of the cached tiles in the image by rank 0
+	PHASE_ENCODE, // Coloring of the smooth iteration counts
+	PHASE_WRITE, // Writing of the image file or of the shared memory
+	PHASE_COUNT
+};
+
+/// <summary>
+/// Span of time spent by a rank in a phase, only made of doubles so the spans of every rank can be gathered at once
+/// </summary>
+typedef struct traceSpan {
+	double start; // Seconds since the origin of the trace
+	double duration; // Seconds
+	double phase; // TracePhase
+	double frame; // Number of the frame, from 0
+	double count; // Iterations for PHASE_COMPUTE, values sent or received for PHASE_SEND and PHASE_RECEIVE, pixels otherwise
+} traceSpan;
+
+/// <summary>
+/// Records the phases of each frame of a rank, then merges the spans of every rank on rank 0
+/// in a file of the Chrome trace event format, opened by chrome://tracing or https://ui.perfetto.dev.
+/// The spans are only recorded by the thread making the MPI calls.
+/// </summary>
+class PhaseTrace
+{
+private:
+	/// <summary>
+	/// Whether Start was called
+	/// </summary>
+	bool enabled = false;
+
+	/// <summary>
+	/// MPI_Wtime when the ranks left the barrier of Start, the times of every rank are relative to it
+	/// </summary>
+	double origin = 0;
+
+	/// <summary>
+	/// Seconds since 1970 on rank 0 at the origin
+	/// </summary>
+	double wallClockOrigin = 0;
+
+	/// <summary>
+	/// Frame of the spans added
+	/// </summary>
+	int frame = -1;
+
+	/// <summary>
+	/// Spans recorded by this rank
+	/// </summary>
+	std::vector<traceSpan> spans;
+public:
+	void Start();
+	bool IsEnabled() const;
+	void NextFrame();
+	double Now() const;
+	void Add(TracePhase, double, double);
+	void Write(int, int, const std::string&) const;
+};
+
+const char* GetPhaseName(TracePhase);
@@ -0,0 +1,120 @@
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+#include "RenderJournal.h"
+
+
+/// <summary>
+/// Hash a text with FNV-1a
+/// </summary>
+/// <param name="text">text to hash</param>
+/// <returns>hash of 64 bits</returns>
+static uint64_t HashText(const std::string& text)
+{
+	uint64_t hash = 14695981039346656037ull;
+	for (unsigned char character : text) {
+		hash = (hash ^ character) * 1099511628211ull;
+	}
+	return hash;
+}
+
+/// <summary>
+/// Read the journals of every rank from the checkpoint directory, called by every rank before any of them writes its journal
+/// </summary>
+/// <param name="path">checkpoint directory, it may not exist yet</param>
+/// <param name="renderDescription">parameters changing the pixels of the image, the journals of other parameters are refused</param>
+void RenderJournal::Read(const std::string& path, const std::string& renderDescription)
+{
+	directory = path;
+	renderHash = HashText(renderDescription);
+	recordedUnits.clear();
+	if (!std::filesystem::is_directory(directory)) {
+		return;
+	}
+
+	for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(directory)) {
+		if (entry.path().extension() != ".journal") {
+			continue;
+		}
+		std::ifstream journal(entry.path(), std::ios::binary);
+		journalHeader header;
+		if (!journal.read((char*)&header, sizeof(header)) || std::memcmp(header.magic, "FPPJOURN", sizeof(header.magic)) != 0) {
+			continue; // Empty journal of a rank killed before writing its header
+		}
+		if (header.renderHash != renderHash) {
+			throw std::invalid_argument("The checkpoint " + directory + " is the one of another render, delete it or choose another directory");
+		}
+		// A record cut by the end of the program isn't read entirely and is ignored
+		journalRecord record;
+		while (journal.read((char*)&record, sizeof(record))) {
+			recordedUnits[record.unit] = record.checksum;
+		}
+	}
+}
+
+/// <summary>
+/// Get the units recorded by the journals read
+/// </summary>
+/// <returns>checksum of each unit written, by index of unit</returns>
+const std::unordered_map<int64_t, uint64_t>& RenderJournal::GetRecordedUnits() const
+{
+	return recordedUnits;
+}
+
+/// <summary>
+/// Open the journal of the current rank to append the units it writes, once every rank has read the journals
+/// </summary>
+/// <param name="rank">rank of the current process</param>
+void RenderJournal::StartWriting(int rank)
+{
+	std::filesystem::path path = std::filesystem::path(directory) / ("rank_" + std::to_string(rank) + ".journal");
+	// The journal of another run with the same number of ranks is continued, without the record it may have cut
+	bool exists = std::filesystem::exists(path) && std::filesystem::file_size(path) >= sizeof(journalHeader);
+	if (exists) {
+		uintmax_t size = std::filesystem::file_size(path);
+		std::filesystem::resize_file(path, size - (size - sizeof(journalHeader)) % sizeof(journalRecord));
+	}
+	file.open(path, exists ? std::ios::binary | std::ios::app : std::ios::binary | std::ios::trunc);
+	if (!file) {
+		throw std::runtime_error("Unable to write the journal " + path.string());
+	}
+	if (!exists) {
+		journalHeader header;
+		std::memcpy(header.magic, "FPPJOURN", sizeof(header.magic));
+		header.renderHash = renderHash;
+		file.write((const char*)&header, sizeof(header));
+		file.flush();
+	}
+}
+
+/// <summary>
+/// Record a unit whose write in the image file is done, the record is written immediately
+/// so it isn't lost if the program is killed
+/// </summary>
+/// <param name="unit">index of the unit</param>
+/// <param name="checksum">ChecksumPixels of the colors written</param>
+void RenderJournal::Append(int64_t unit, uint64_t checksum)
+{
+	journalRecord record = { unit, checksum };
+	file.write((const char*)&record, sizeof(record));
+	file.flush();
+	if (!file) {
+		throw std::runtime_error("Unable to write the journal of " + directory + ", the disk may be full");
+	}
+}
+
+/// <summary>
+/// Checksum of the colors of a unit, FNV-1a on whole pixels so it costs little next to their calculation
+/// </summary>
+/// <param name="pixels">colors of the unit</param>
+/// <param name="count">number of pixels</param>
+/// <returns>checksum of 64 bits</returns>
+uint64_t ChecksumPixels(const uint32_t* pixels, long long count)
+{
+	uint64_t checksum = 14695981039346656037ull;
+	for (long long i = 0; i < count; i++) {
+		checksum = (checksum ^ pixels[i]) * 1099511628211ull;
+	}
+	return checksum;
+}
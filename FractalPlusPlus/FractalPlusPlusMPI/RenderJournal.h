@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+
+/// <summary>
+/// Header at the start of the journal of each rank
+/// </summary>
+typedef struct journalHeader {
+	char magic[8]; // "FPPJOURN"
+	uint64_t renderHash; // Hash of the parameters of the render, so the journal of another image isn't used
+} journalHeader;
+
+/// <summary>
+/// Unit of the image written in the image file, appended to the journal once its write is done
+/// </summary>
+typedef struct journalRecord {
+	int64_t unit; // Index of the unit in the image file
+	uint64_t checksum; // ChecksumPixels of the colors of the unit, to check they really are in the image file
+} journalRecord;
+
+/// <summary>
+/// Journal of the units of an image of --output already written, so a render killed before its end can be resumed.
+/// Each rank appends the units it writes to its own file of the checkpoint directory, and every rank reads all of them
+/// when starting, so the render can be resumed with another number of ranks.
+/// A record cut by the end of the program is ignored, the unit is then calculated again.
+/// </summary>
+class RenderJournal
+{
+private:
+	/// <summary>
+	/// Directory of the journals of every rank
+	/// </summary>
+	std::string directory;
+
+	/// <summary>
+	/// Hash of the parameters of the render
+	/// </summary>
+	uint64_t renderHash = 0;
+
+	/// <summary>
+	/// Units recorded by every journal of the directory, with their checksum
+	/// </summary>
+	std::unordered_map<int64_t, uint64_t> recordedUnits;
+
+	/// <summary>
+	/// Journal of the current rank, opened by StartWriting
+	/// </summary>
+	std::ofstream file;
+public:
+	void Read(const std::string&, const std::string&);
+	const std::unordered_map<int64_t, uint64_t>& GetRecordedUnits() const;
+	void StartWriting(int);
+	void Append(int64_t, uint64_t);
+};
+
+uint64_t ChecksumPixels(const uint32_t*, long long);
@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdint>
+
+/// <summary>
+/// Binary messages exchanged between the GUI and FractalPlusPlusMPI running as a render server (--server).
+/// Both programs run on the same computer, so the structs are sent as they are in memory.
+/// The doubles are sent with all their bits, unlike the text arguments of the command line.
+/// The server answers the requests in order. A request sent while a frame is calculated cancels it,
+/// the frame is then answered with STATUS_CANCELLED before the request is handled.
+/// </summary>
+
+/// <summary>
+/// Commands sent by the GUI
+/// </summary>
+enum RenderCommand : uint32_t {
+	COMMAND_RENDER = 1, // Calculate the Mandelbrot image of a viewport
+	COMMAND_QUIT = 2, // Stop the render server
+	COMMAND_RECOLOR = 3 // Color the last frame again with another palette, without calculating it
+};
+
+/// <summary>
+/// Status of a rendered frame sent back by the server
+/// </summary>
+enum RenderStatus : uint32_t {
+	STATUS_DONE = 0,
+	STATUS_INVALID_REQUEST = 1,
+	STATUS_PARTIAL = 2, // A coarse pass of the progressive rendering is saved, the next passes are coming
+	STATUS_CANCELLED = 3 // The frame was stopped by the next request, the image keeps its last saved pass. Also the reply to COMMAND_RECOLOR for such a frame
+};
+
+/// <summary>
+/// Request sent by the GUI, only command and palette are read for COMMAND_RECOLOR
+/// </summary>
+typedef struct renderRequest {
+	uint32_t command;
+	int32_t pixelWidth;
+	int32_t pixelHeight;
+	int32_t maxIteration;
+	uint32_t palette; // PaletteType used to color the frame
+	uint32_t centerLength; // Length of the text "X Y" sent after the request with the center at full precision, 0 if there is none
+	uint32_t passes; // Passes of the progressive rendering, a STATUS_PARTIAL reply is sent after each one but the last
+	uint32_t fractal; // FractalType of the frame
+	// Ranges of the viewport, relative to the center when there is one so they stay precise however deep the zoom is
+	double minRangeX;
+	double maxRangeX;
+	double minRangeY;
+	double maxRangeY;
+	int32_t power; // Power of the formula of the fractal
+	uint32_t colorMode; // ColorMode of the frame
+	double juliaReal; // c of the Julia sets
+	double juliaImag;
+} renderRequest;
+
+/// <summary>
+/// Answer of the server once the requested frame is saved or cancelled, preceded by a STATUS_PARTIAL answer for each coarse pass
+/// </summary>
+typedef struct renderReply {
+	uint32_t status;
+	uint32_t frame; // Number of the frame since the server started
+	double seconds; // Time spent rendering the frame
+} renderReply;
@@ -0,0 +1,169 @@
+#include <algorithm>
+#include <deque>
+#include <iostream>
+#include <string>
+#include <mpi.h>
+
+#include "RenderServer.h"
+#include "LocalSocket.h"
+#include "RenderProtocol.h"
+
+
+/// <summary>
+/// Maximum length of the text of the center sent after a render request
+/// </summary>
+constexpr uint32_t maxCenterLength = 1 << 16;
+
+/// <summary>
+/// Keep the MPI world running and render the viewports requested by the GUI, until it quits or disconnects.
+/// Rank 0 listens on port of the loopback interface and broadcasts each request to the other ranks.
+/// A request arriving while a frame is calculated cancels it, the ranks stop within a chunk and the request is handled next,
+/// so the GUI zooming several times in a row only waits for the last frame. A palette change doesn't cancel the frame,
+/// it's applied once the frame is done.
+/// </summary>
+/// <param name="renderer">renderer calculating the requested frames</param>
+/// <param name="rank">rank of the current process</param>
+/// <param name="numtasks">number of MPI ranks</param>
+/// <param name="port">port of the loopback interface to listen on</param>
+/// <returns>on rank 0, false if the server couldn't listen on port</returns>
+bool RunServer(FractalRenderer& renderer, int rank, int numtasks, int port)
+{
+	socketHandle client = invalidSocket;
+	bool listened = true;
+	if (rank == 0) {
+		socketHandle listener = invalidSocket;
+		if (InitializeSockets()) {
+			listener = ListenLocal(port);
+		}
+		if (listener == invalidSocket) {
+			std::cerr << "Unable to listen on port " << port << std::endl;
+			listened = false;
+		}
+		else {
+			std::cout << "Render server listening on port " << port << std::endl;
+			client = AcceptClient(listener);
+			CloseSocket(listener); // Only one GUI per server
+		}
+	}
+
+	// Requests read by rank 0 while a frame was calculated, handled once the frame is done or cancelled.
+	// The reading stops at the first one which isn't a palette change, the center sent after it is read with it
+	std::deque<renderRequest> receivedRequests;
+	bool superseded = false;
+	renderer.cancellable = true;
+	renderer.cancelRequested = [&]() {
+		while (!superseded && client != invalidSocket && IsReadable(client)) {
+			renderRequest received = {};
+			if (!ReceiveAll(client, &received, sizeof(received))) {
+				received.command = COMMAND_QUIT; // The GUI is gone
+			}
+			receivedRequests.push_back(received);
+			superseded = received.command != COMMAND_RECOLOR;
+		}
+		return superseded;
+	};
+
+	uint32_t frame = 0;
+	while (true) {
+		renderRequest request = {};
+		if (rank == 0) {
+			// Answer the requests rank 0 handles alone until one needs every rank
+			while (true) {
+				if (!receivedRequests.empty()) {
+					request = receivedRequests.front();
+					receivedRequests.pop_front();
+					superseded = superseded && request.command == COMMAND_RECOLOR;
+				}
+				else if (client == invalidSocket || !ReceiveAll(client, &request, sizeof(request))) {
+					request.command = COMMAND_QUIT; // The GUI is gone
+				}
+
+				// Center at full precision sent after the request
+				bool validCenter = true;
+				if (request.command == COMMAND_RENDER && request.centerLength > 0) {
+					std::string center(std::min(request.centerLength, maxCenterLength), ' ');
+					if (request.centerLength > maxCenterLength || !ReceiveAll(client, &center[0], center.size())) {
+						request.command = COMMAND_QUIT; // Can't read the next requests anymore
+					}
+					else {
+						size_t separator = center.find(' ');
+						int fractionLimbs = BigFloat::FractionLimbsFor(std::min((request.maxRangeX - request.minRangeX) / request.pixelWidth,
+							(request.maxRangeY - request.minRangeY) / request.pixelHeight));
+						validCenter = separator != std::string::npos && BigFloat::Parse(center.substr(0, separator), fractionLimbs, &renderer.centerX)
+							&& BigFloat::Parse(center.substr(separator + 1), fractionLimbs, &renderer.centerY);
+					}
+				}
+
+				if (request.command == COMMAND_QUIT || (request.command == COMMAND_RENDER && validCenter
+					&& request.pixelWidth > 0 && request.pixelHeight > 0 && request.maxIteration > 0
+					&& (long long)request.pixelWidth * request.pixelHeight <= INT32_MAX && request.palette < PALETTE_COUNT
+					&& request.passes >= 1 && request.passes <= (uint32_t)maxPasses
+					&& AreFractalParametersValid({ (FractalType)request.fractal, request.power, (ColorMode)request.colorMode, request.juliaReal, request.juliaImag }))) {
+					break;
+				}
+
+				renderReply reply = { STATUS_INVALID_REQUEST, frame, 0 };
+				if (request.command == COMMAND_RECOLOR && request.palette < PALETTE_COUNT && frame > 0 && renderer.frameCancelled) {
+					// Only color the last frame again if it was finished, it was cancelled by a request sent after this one
+					reply = { STATUS_CANCELLED, frame, 0 };
+				}
+				else if (request.command == COMMAND_RECOLOR && request.palette < PALETTE_COUNT && frame > 0) {
+					double startTime = MPI_Wtime();
+					renderer.palette = (PaletteType)request.palette;
+					renderer.ColorizeFrame();
+					reply = { STATUS_DONE, frame, MPI_Wtime() - startTime };
+				}
+				SendAll(client, &reply, sizeof(reply));
+			}
+		}
+		MPI_Bcast(&request, sizeof(request), MPI_BYTE, 0, MPI_COMM_WORLD);
+		if (request.command == COMMAND_QUIT) {
+			break;
+		}
+
+		renderer.pixelWidth = request.pixelWidth;
+		renderer.pixelHeight = request.pixelHeight;
+		renderer.maxIteration = request.maxIteration;
+		renderer.rangeWidth = request.maxRangeX - request.minRangeX;
+		renderer.rangeHeight = request.maxRangeY - request.minRangeY;
+		if (request.centerLength > 0) {
+			// The ranges are relative to the center read by rank 0
+			double center[2] = { renderer.centerX.ToDouble(), renderer.centerY.ToDouble() };
+			MPI_Bcast(center, 2, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+			renderer.minRangeX = center[0] + request.minRangeX;
+			renderer.maxRangeX = center[0] + request.maxRangeX;
+			renderer.minRangeY = center[1] + request.minRangeY;
+			renderer.maxRangeY = center[1] + request.maxRangeY;
+		}
+		else {
+			renderer.minRangeX = request.minRangeX;
+			renderer.maxRangeX = request.maxRangeX;
+			renderer.minRangeY = request.minRangeY;
+			renderer.maxRangeY = request.maxRangeY;
+			renderer.centerX = BigFloat((renderer.minRangeX + renderer.maxRangeX) / 2, 2);
+			renderer.centerY = BigFloat((renderer.minRangeY + renderer.maxRangeY) / 2, 2);
+		}
+		renderer.palette = (PaletteType)request.palette;
+		renderer.passes = (int)request.passes;
+		renderer.fractal = { (FractalType)request.fractal, request.power, (ColorMode)request.colorMode, request.juliaReal, request.juliaImag };
+
+		double startTime = MPI_Wtime();
+		renderer.RenderFrame(rank, numtasks, [&]() {
+			// The GUI displays the coarse pass while the next one is calculated
+			renderReply reply = { STATUS_PARTIAL, frame + 1, MPI_Wtime() - startTime };
+			SendAll(client, &reply, sizeof(reply));
+		});
+		frame++;
+
+		if (rank == 0) {
+			renderReply reply = { renderer.frameCancelled ? STATUS_CANCELLED : STATUS_DONE, frame, MPI_Wtime() - startTime };
+			if (renderer.frameCancelled) {
+				std::cout << "Frame " << frame << " cancelled after " << reply.seconds << " s by the next request" << std::endl;
+			}
+			SendAll(client, &reply, sizeof(reply));
+		}
+	}
+
+	CloseSocket(client);
+	return listened;
+}
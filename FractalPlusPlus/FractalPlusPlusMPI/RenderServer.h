@@ -0,0 +1,4 @@
+#pragma once
+#include "FractalRenderer.h"
+
+bool RunServer(FractalRenderer&, int, int, int);
@@ -0,0 +1,379 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <mpi.h>
+
+#include "Schedules.h"
+
+
+/// <summary>
+/// Number of pixels of a chunk of the anti-aliasing handed out by rank 0, 32 tasks of ComputeSubsamples
+/// </summary>
+constexpr int refineChunkPixels = 2048;
+
+/// <summary>
+/// Static schedule, each rank calculates one contiguous part of the grid of the current pass.
+/// The first numberOfPixels % numtasks ranks calculate one more pixel than the others.
+/// With the subdivision the parts are rows of tiles, the first ranks calculating one more row of tiles.
+/// The ranks send each chunk of GetChunkRows() rows of their part as soon as it's calculated without waiting for rank 0,
+/// which receives them straight at their place in the image in the order they arrive while it calculates its own part,
+/// so a slow rank doesn't delay the chunks of the others. With the coordinator, rank 0 has no part and only receives.
+/// </summary>
+/// <param name="renderer">frame being calculated</param>
+/// <param name="rank">rank of the current process</param>
+/// <param name="numtasks">number of MPI ranks</param>
+/// <param name="iterations">smooth iteration counts of the grid of the pass filled by rank 0, nullptr for the other ranks</param>
+/// <param name="statistics">work done by the rank</param>
+void RunStaticSchedule(FractalRenderer& renderer, int rank, int numtasks, float* iterations, rankStatistics* statistics)
+{
+	int numberOfPixels = renderer.passWidth * renderer.passHeight;
+	// Parts are made of units of 1 pixel, or of one row of tiles with the subdivision
+	int unitPixels = renderer.subdivide ? renderer.tileSize * renderer.passWidth : 1;
+	int units = (numberOfPixels + unitPixels - 1) / unitPixels;
+	int firstRank = renderer.RankZeroComputes(numtasks) ? 0 : 1;
+	std::vector<int> counts(numtasks);
+	std::vector<int> displacements(numtasks);
+	for (int i = firstRank; i < numtasks; i++) {
+		displacements[i] = i == firstRank ? 0 : displacements[i - 1] + counts[i - 1];
+		int rankUnits = units / (numtasks - firstRank) + (i - firstRank < units % (numtasks - firstRank) ? 1 : 0);
+		counts[i] = (int)std::min((long long)rankUnits * unitPixels, (long long)numberOfPixels - displacements[i]);
+	}
+	// A chunk is a whole row of tiles with the subdivision
+	int chunkPixels = renderer.GetChunkRows() * renderer.passWidth;
+	auto getChunkCount = [chunkPixels](int count) { return (count + chunkPixels - 1) / chunkPixels; };
+
+	// Rank 0 receives every chunk of the other ranks straight at its place in the image
+	std::vector<MPI_Request> requests;
+	if (rank == 0) {
+		for (int i = 1; i < numtasks; i++) {
+			for (int offset = 0; offset < counts[i]; offset += chunkPixels) {
+				requests.emplace_back();
+				MPI_Irecv(iterations + displacements[i] + offset, std::min(chunkPixels, counts[i] - offset), MPI_FLOAT, i, TAG_CHUNK_PIXELS, MPI_COMM_WORLD, &requests.back());
+			}
+		}
+	}
+	int receivedChunks = 0;
+
+	// Rank 0 calculates its part straight in the image, the other ranks keep their part until every chunk is sent
+	std::vector<float> localIterations(rank == 0 ? 0 : counts[rank]);
+	float* target = rank == 0 ? iterations + displacements[0] : localIterations.data();
+	std::vector<MPI_Request> sends(rank == 0 ? 0 : getChunkCount(counts[rank]));
+	long long iteratedPixels = 0;
+	double busyTime = 0;
+	for (int offset = 0; offset < counts[rank]; offset += chunkPixels) {
+		int chunkCount = std::min(chunkPixels, counts[rank] - offset);
+		double startTime = MPI_Wtime();
+		double traceStart = renderer.phaseTrace.Now();
+		long long previousIterations = renderer.kernelIterations;
+		if (renderer.subdivide) {
+			iteratedPixels += renderer.ComputeRows((displacements[rank] + offset) / renderer.passWidth, chunkCount / renderer.passWidth, target + offset);
+		}
+		else {
+			renderer.ComputePixels(displacements[rank] + offset, chunkCount, target + offset);
+			iteratedPixels += chunkCount;
+		}
+		busyTime += MPI_Wtime() - startTime;
+		renderer.phaseTrace.Add(PHASE_COMPUTE, traceStart, (double)(renderer.kernelIterations - previousIterations));
+
+		traceStart = renderer.phaseTrace.Now();
+		if (rank == 0) {
+			// Take the chunks already arrived between two chunks of rank 0, which also lets MPI progress
+			int done = 0;
+			std::vector<int> indices(requests.size());
+			MPI_Testsome((int)requests.size(), requests.data(), &done, indices.data(), MPI_STATUSES_IGNORE);
+			receivedChunks += done == MPI_UNDEFINED ? 0 : done;
+			renderer.phaseTrace.Add(PHASE_RECEIVE, traceStart, done == MPI_UNDEFINED ? 0 : done);
+		}
+		else {
+			MPI_Isend(target + offset, chunkCount, MPI_FLOAT, 0, TAG_CHUNK_PIXELS, MPI_COMM_WORLD, &sends[offset / chunkPixels]);
+			renderer.phaseTrace.Add(PHASE_SEND, traceStart, chunkCount);
+		}
+	}
+	*statistics = { busyTime, (double)getChunkCount(counts[rank]), (double)counts[rank], (double)iteratedPixels };
+
+	if (rank == 0) {
+		// The chunks left, in the order they arrive. The frames of the render server poll them instead of blocking in MPI_Waitany
+		// so a request of the GUI arriving meanwhile still cancels the frame
+		double traceStart = renderer.phaseTrace.Now();
+		while (receivedChunks < (int)requests.size()) {
+			int index;
+			int arrived = 1;
+			if (renderer.cancellable) {
+				MPI_Testany((int)requests.size(), requests.data(), &index, &arrived, MPI_STATUS_IGNORE);
+			}
+			else {
+				MPI_Waitany((int)requests.size(), requests.data(), &index, MPI_STATUS_IGNORE);
+			}
+			if (arrived) {
+				receivedChunks++;
+				renderer.phaseTrace.Add(PHASE_RECEIVE, traceStart, 1);
+				traceStart = renderer.phaseTrace.Now();
+			}
+			else {
+				renderer.IsFrameCancelled();
+				std::this_thread::sleep_for(std::chrono::microseconds(100));
+			}
+		}
+	}
+	else {
+		double traceStart = renderer.phaseTrace.Now();
+		MPI_Waitall((int)sends.size(), sends.data(), MPI_STATUSES_IGNORE);
+		renderer.phaseTrace.Add(PHASE_SEND, traceStart, 0);
+		std::cout << "Rank " << rank << " sent " << counts[rank] << " pixels in " << sends.size() << " chunks" << std::endl;
+	}
+}
+
+/// <summary>
+/// Rank 0's side of the dynamic schedule.
+/// Rank 0 hands out chunks of GetChunkRows() rows of the grid of the current pass to the ranks asking for work and stores the chunks they send back.
+/// Between two requests it calculates the grid one row (one row of tiles with the subdivision) at a time, so it stays responsive.
+/// With the coordinator it only waits for the requests.
+/// </summary>
+/// <param name="renderer">frame being calculated</param>
+/// <param name="iterations">smooth iteration counts of the grid of the pass filled with the rows of every rank</param>
+/// <param name="numtasks">number of MPI ranks</param>
+/// <param name="statistics">work done by rank 0</param>
+void RunDynamicMaster(FractalRenderer& renderer, float* iterations, int numtasks, rankStatistics* statistics)
+{
+	int nextRow = 0;
+	int activeWorkers = numtasks - 1;
+	bool computes = renderer.RankZeroComputes(numtasks);
+
+	while (nextRow < renderer.passHeight || activeWorkers > 0) {
+		// Answer every rank waiting for work, wait for them when rank 0 has nothing left to calculate
+		int pending = 0;
+		MPI_Iprobe(MPI_ANY_SOURCE, TAG_RESULT, MPI_COMM_WORLD, &pending, MPI_STATUS_IGNORE);
+		while (pending || ((nextRow >= renderer.passHeight || !computes) && activeWorkers > 0)) {
+			MPI_Status status;
+			int result[2];
+			double traceStart = renderer.phaseTrace.Now();
+			MPI_Recv(result, 2, MPI_INT, MPI_ANY_SOURCE, TAG_RESULT, MPI_COMM_WORLD, &status);
+			int worker = status.MPI_SOURCE;
+			if (result[1] > 0) {
+				// Receive the rows straight at their place in the image
+				MPI_Recv(iterations + (size_t)result[0] * renderer.passWidth, result[1] * renderer.passWidth, MPI_FLOAT, worker, TAG_CHUNK_PIXELS, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+			}
+			renderer.phaseTrace.Add(PHASE_RECEIVE, traceStart, (double)result[1] * renderer.passWidth);
+
+			if (renderer.IsFrameCancelled()) {
+				nextRow = renderer.passHeight; // Hand out no more work, the ranks stop after their current chunk
+			}
+			int work[2] = { nextRow, std::max(0, std::min(renderer.GetChunkRows(), renderer.passHeight - nextRow)) };
+			if (work[1] == 0) {
+				activeWorkers--;
+			}
+			nextRow += work[1];
+			traceStart = renderer.phaseTrace.Now();
+			MPI_Send(work, 2, MPI_INT, worker, TAG_WORK, MPI_COMM_WORLD);
+			renderer.phaseTrace.Add(PHASE_SEND, traceStart, 2);
+
+			MPI_Iprobe(MPI_ANY_SOURCE, TAG_RESULT, MPI_COMM_WORLD, &pending, MPI_STATUS_IGNORE);
+		}
+
+		// Calculate one row of rank 0's own share, a whole chunk with the subdivision which needs rows of tiles
+		if (nextRow < renderer.passHeight && computes) {
+			int rowCount = renderer.subdivide ? std::min(renderer.GetChunkRows(), renderer.passHeight - nextRow) : 1;
+			double startTime = MPI_Wtime();
+			double traceStart = renderer.phaseTrace.Now();
+			long long previousIterations = renderer.kernelIterations;
+			statistics->iteratedPixels += renderer.ComputeRows(nextRow, rowCount, iterations + (size_t)nextRow * renderer.passWidth);
+			statistics->busyTime += MPI_Wtime() - startTime;
+			renderer.phaseTrace.Add(PHASE_COMPUTE, traceStart, (double)(renderer.kernelIterations - previousIterations));
+			statistics->chunks++;
+			statistics->pixels += (double)rowCount * renderer.passWidth;
+			nextRow += rowCount;
+		}
+	}
+}
+
+/// <summary>
+/// Worker's side of the dynamic schedule.
+/// The rank sends its finished chunk (nothing the first time) to rank 0, which answers with the next chunk to calculate.
+/// </summary>
+/// <param name="renderer">frame being calculated</param>
+/// <param name="statistics">work done by the rank</param>
+void RunDynamicWorker(FractalRenderer& renderer, rankStatistics* statistics)
+{
+	std::vector<float> chunkIterations((size_t)renderer.GetChunkRows() * renderer.passWidth);
+	int result[2] = { 0, 0 };
+
+	while (true) {
+		double traceStart = renderer.phaseTrace.Now();
+		MPI_Send(result, 2, MPI_INT, 0, TAG_RESULT, MPI_COMM_WORLD);
+		if (result[1] > 0) {
+			MPI_Send(chunkIterations.data(), result[1] * renderer.passWidth, MPI_FLOAT, 0, TAG_CHUNK_PIXELS, MPI_COMM_WORLD);
+		}
+		renderer.phaseTrace.Add(PHASE_SEND, traceStart, (double)result[1] * renderer.passWidth);
+
+		// Waiting for rank 0, which answers between two of its own rows
+		int work[2];
+		traceStart = renderer.phaseTrace.Now();
+		MPI_Recv(work, 2, MPI_INT, 0, TAG_WORK, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+		renderer.phaseTrace.Add(PHASE_RECEIVE, traceStart, 2);
+		if (work[1] == 0) {
+			break; // No more work
+		}
+
+		double startTime = MPI_Wtime();
+		traceStart = renderer.phaseTrace.Now();
+		long long previousIterations = renderer.kernelIterations;
+		statistics->iteratedPixels += renderer.ComputeRows(work[0], work[1], chunkIterations.data());
+		statistics->busyTime += MPI_Wtime() - startTime;
+		renderer.phaseTrace.Add(PHASE_COMPUTE, traceStart, (double)(renderer.kernelIterations - previousIterations));
+		statistics->chunks++;
+		statistics->pixels += (double)work[1] * renderer.passWidth;
+
+		result[0] = work[0];
+		result[1] = work[1];
+	}
+}
+
+/// <summary>
+/// Rank 0's side of the anti-aliasing, RunDynamicMaster over the chunks of pixels.
+/// Between two requests it calculates its own chunks, unless it's only the coordinator.
+/// </summary>
+/// <param name="renderer">frame being calculated</param>
+/// <param name="pixels">pixels to refine</param>
+/// <param name="samples">filled with the smooth iteration counts of the antialiasSamples subsamples of each pixel</param>
+/// <param name="numtasks">number of MPI ranks</param>
+void RunRefinementMaster(FractalRenderer& renderer, const std::vector<int>& pixels, float* samples, int numtasks)
+{
+	int count = (int)pixels.size();
+	int nextPixel = 0;
+	int activeWorkers = numtasks - 1;
+	bool computes = renderer.RankZeroComputes(numtasks);
+
+	while (nextPixel < count || activeWorkers > 0) {
+		// Answer every rank waiting for work, wait for them when rank 0 has nothing left to calculate
+		int pending = 0;
+		MPI_Iprobe(MPI_ANY_SOURCE, TAG_RESULT, MPI_COMM_WORLD, &pending, MPI_STATUS_IGNORE);
+		while (pending || ((nextPixel >= count || !computes) && activeWorkers > 0)) {
+			MPI_Status status;
+			int result[2];
+			double traceStart = renderer.phaseTrace.Now();
+			MPI_Recv(result, 2, MPI_INT, MPI_ANY_SOURCE, TAG_RESULT, MPI_COMM_WORLD, &status);
+			int worker = status.MPI_SOURCE;
+			if (result[1] > 0) {
+				MPI_Recv(samples + (size_t)result[0] * renderer.antialiasSamples, result[1] * renderer.antialiasSamples, MPI_FLOAT, worker, TAG_CHUNK_PIXELS, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+			}
+			renderer.phaseTrace.Add(PHASE_RECEIVE, traceStart, (double)result[1] * renderer.antialiasSamples);
+
+			if (renderer.IsFrameCancelled()) {
+				nextPixel = count; // Hand out no more work, the ranks stop after their current chunk
+			}
+			int work[2] = { nextPixel, std::max(0, std::min(refineChunkPixels, count - nextPixel)) };
+			if (work[1] == 0) {
+				activeWorkers--;
+			}
+			nextPixel += work[1];
+			traceStart = renderer.phaseTrace.Now();
+			MPI_Send(work, 2, MPI_INT, worker, TAG_WORK, MPI_COMM_WORLD);
+			renderer.phaseTrace.Add(PHASE_SEND, traceStart, 2);
+
+			MPI_Iprobe(MPI_ANY_SOURCE, TAG_RESULT, MPI_COMM_WORLD, &pending, MPI_STATUS_IGNORE);
+		}
+
+		// Calculate one chunk of rank 0's own share
+		if (nextPixel < count && computes) {
+			if (renderer.IsFrameCancelled()) {
+				nextPixel = count;
+				continue;
+			}
+			int pixelCount = std::min(refineChunkPixels, count - nextPixel);
+			double traceStart = renderer.phaseTrace.Now();
+			long long previousIterations = renderer.kernelIterations;
+			renderer.ComputeSubsamples(pixels.data() + nextPixel, pixelCount, samples + (size_t)nextPixel * renderer.antialiasSamples);
+			renderer.phaseTrace.Add(PHASE_COMPUTE, traceStart, (double)(renderer.kernelIterations - previousIterations));
+			nextPixel += pixelCount;
+		}
+	}
+}
+
+/// <summary>
+/// Worker's side of the anti-aliasing, like RunDynamicWorker with a range of pixels for each chunk
+/// </summary>
+/// <param name="renderer">frame being calculated</param>
+/// <param name="pixels">pixels to refine, the same on every rank</param>
+void RunRefinementWorker(FractalRenderer& renderer, const std::vector<int>& pixels)
+{
+	std::vector<float> chunkSamples((size_t)refineChunkPixels * renderer.antialiasSamples);
+	int result[2] = { 0, 0 };
+
+	while (true) {
+		double traceStart = renderer.phaseTrace.Now();
+		MPI_Send(result, 2, MPI_INT, 0, TAG_RESULT, MPI_COMM_WORLD);
+		if (result[1] > 0) {
+			MPI_Send(chunkSamples.data(), result[1] * renderer.antialiasSamples, MPI_FLOAT, 0, TAG_CHUNK_PIXELS, MPI_COMM_WORLD);
+		}
+		renderer.phaseTrace.Add(PHASE_SEND, traceStart, (double)result[1] * renderer.antialiasSamples);
+
+		int work[2];
+		traceStart = renderer.phaseTrace.Now();
+		MPI_Recv(work, 2, MPI_INT, 0, TAG_WORK, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+		renderer.phaseTrace.Add(PHASE_RECEIVE, traceStart, 2);
+		if (work[1] == 0) {
+			break; // No more work
+		}
+
+		// The chunks of a cancelled frame are still sent so the schedule ends as usual, rank 0 drops them
+		if (!renderer.IsFrameCancelled()) {
+			traceStart = renderer.phaseTrace.Now();
+			long long previousIterations = renderer.kernelIterations;
+			renderer.ComputeSubsamples(pixels.data() + work[0], work[1], chunkSamples.data());
+			renderer.phaseTrace.Add(PHASE_COMPUTE, traceStart, (double)(renderer.kernelIterations - previousIterations));
+		}
+
+		result[0] = work[0];
+		result[1] = work[1];
+	}
+}
+
+/// <summary>
+/// Gather the work done by every rank on rank 0 and display it,
+/// with the ratio between the busiest rank and the mean to see the load imbalance
+/// </summary>
+/// <param name="renderer">frame being calculated</param>
+/// <param name="rank">rank of the current process</param>
+/// <param name="numtasks">number of MPI ranks</param>
+/// <param name="statistics">work done by the current rank</param>
+/// <returns>on rank 0, the work of every rank summed, with the busy time of the busiest rank</returns>
+rankStatistics ReportStatistics(const FractalRenderer& renderer, int rank, int numtasks, rankStatistics statistics)
+{
+	std::vector<rankStatistics> allStatistics(rank == 0 ? numtasks : 0);
+	constexpr int values = sizeof(rankStatistics) / sizeof(double);
+	MPI_Gather(&statistics, values, MPI_DOUBLE, allStatistics.data(), values, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+
+	if (rank == 0) {
+		double maxBusyTime = 0;
+		double sumBusyTime = 0;
+		double sumPixels = 0;
+		double sumIteratedPixels = 0;
+		double sumChunks = 0;
+		double sumIterations = 0;
+		for (int i = 0; i < numtasks; i++) {
+			std::cout << "Rank " << i << " busy " << allStatistics[i].busyTime << " s for " << allStatistics[i].pixels << " pixels in " << allStatistics[i].chunks << " chunks" << std::endl;
+			maxBusyTime = std::max(maxBusyTime, allStatistics[i].busyTime);
+			sumBusyTime += allStatistics[i].busyTime;
+			sumPixels += allStatistics[i].pixels;
+			sumIteratedPixels += allStatistics[i].iteratedPixels;
+			sumChunks += allStatistics[i].chunks;
+			sumIterations += allStatistics[i].iterations;
+		}
+		if (sumBusyTime > 0) {
+			// The coordinator calculates nothing, it's left out of the mean
+			int computingRanks = renderer.RankZeroComputes(numtasks) ? numtasks : numtasks - 1;
+			std::cout << "Load imbalance (max / mean busy time) : " << maxBusyTime / (sumBusyTime / computingRanks) << std::endl;
+		}
+		if (renderer.subdivide && sumPixels > 0) {
+			std::cout << "Pixels iterated : " << sumIteratedPixels << ", filled : " << sumPixels - sumIteratedPixels
+				<< " (" << 100 * (sumPixels - sumIteratedPixels) / sumPixels << " % filled)" << std::endl;
+		}
+		if (maxBusyTime > 0) {
+			std::cout << "Iterations : " << sumIterations << " (" << sumIterations / maxBusyTime << " per second)" << std::endl;
+		}
+		std::cout << "--------------------------------------------------" << std::endl;
+		return { maxBusyTime, sumChunks, sumPixels, sumIteratedPixels, sumIterations };
+	}
+	return statistics;
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <vector>
+
+#include "FractalRenderer.h"
+
+/// <summary>
+/// MPI tags used to exchange messages between rank 0 and the other ranks
+/// </summary>
+enum MessageTag {
+	TAG_RESULT = 11, // {firstRow, rowCount} of a finished chunk, rowCount is 0 when asking for the first chunk. {frame, firstRow, rowCount} for the animations and the batch
+	TAG_CHUNK_PIXELS = 12, // Pixels of a finished chunk
+	TAG_WORK = 13, // {firstRow, rowCount} of the next chunk to calculate, rowCount is 0 when there is no more work. {frame, firstRow, rowCount} for the animations, a batchChunk for the batch
+	TAG_CANCEL = 14 // Empty message telling a rank the frame being calculated is cancelled
+};
+
+void RunStaticSchedule(FractalRenderer&, int, int, float*, rankStatistics*);
+void RunDynamicMaster(FractalRenderer&, float*, int, rankStatistics*);
+void RunDynamicWorker(FractalRenderer&, rankStatistics*);
+void RunRefinementMaster(FractalRenderer&, const std::vector<int>&, float*, int);
+void RunRefinementWorker(FractalRenderer&, const std::vector<int>&);
+rankStatistics ReportStatistics(const FractalRenderer&, int, int, rankStatistics);
@@ -0,0 +1,262 @@
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32) && !defined(__CYGWIN__)
+#define FPP_WINDOWS
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "SharedFrame.h"
+
+
+/// <summary>
+/// Destructor, unmapping the shared memory and removing it if this object created it
+/// </summary>
+SharedFrame::~SharedFrame()
+{
+	Close();
+}
+
+/// <summary>
+/// Get a name of shared memory specific to the current process,
+/// so two users or two GUIs on the same computer don't overwrite each other's frame
+/// </summary>
+/// <returns>name of shared memory</returns>
+std::string SharedFrame::UniqueName()
+{
+#if defined(FPP_WINDOWS)
+	return "Local\\FractalPlusPlus-" + std::to_string(GetCurrentProcessId());
+#else
+	return "/FractalPlusPlus-" + std::to_string(getpid());
+#endif
+}
+
+/// <summary>
+/// Create the shared memory, big enough for a frame of maxWidth * maxHeight pixels.
+/// It's removed when this object is destroyed.
+/// </summary>
+/// <param name="frameName">name of the shared memory</param>
+/// <param name="maxWidth">maximum width of the frames in pixels</param>
+/// <param name="maxHeight">maximum height of the frames in pixels</param>
+/// <returns>false if the shared memory can't be created</returns>
+bool SharedFrame::Create(const std::string& frameName, int maxWidth, int maxHeight)
+{
+	Close();
+	name = frameName;
+	if (!Map(true, sizeof(sharedFrameHeader) + (size_t)maxWidth * maxHeight * 4)) {
+		return false;
+	}
+	owner = true;
+	header->width = 0;
+	header->height = 0;
+	header->ready = 0;
+	header->sequence = 0;
+	header->capacity = mappedSize - sizeof(sharedFrameHeader);
+	header->magic = sharedFrameMagic;
+	return true;
+}
+
+/// <summary>
+/// Open a shared memory created by another process, or create it if it doesn't exist.
+/// On Linux it's enlarged if a frame of width * height pixels doesn't fit in it.
+/// </summary>
+/// <param name="frameName">name of the shared memory</param>
+/// <param name="width">width of the next frame in pixels</param>
+/// <param name="height">height of the next frame in pixels</param>
+/// <returns>false if the shared memory can't be opened</returns>
+bool SharedFrame::Open(const std::string& frameName, int width, int height)
+{
+	Close();
+	name = frameName;
+	if (!Map(false, sizeof(sharedFrameHeader) + (size_t)width * height * 4)) {
+		return false;
+	}
+	if (header->magic != sharedFrameMagic) {
+		// Created by this call
+		header->width = 0;
+		header->height = 0;
+		header->ready = 0;
+		header->sequence = 0;
+		header->magic = sharedFrameMagic;
+	}
+	header->capacity = mappedSize - sizeof(sharedFrameHeader);
+	return true;
+}
+
+/// <summary>
+/// Create or open the shared memory and map it in the memory of the process
+/// </summary>
+/// <param name="create">true to create a new shared memory of the given size, false to open it and enlarge it if needed</param>
+/// <param name="size">minimum size of the shared memory in bytes</param>
+/// <returns>false if the shared memory can't be mapped</returns>
+bool SharedFrame::Map(bool create, size_t size)
+{
+#if defined(FPP_WINDOWS)
+	HANDLE mapping = create ? nullptr : OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name.c_str());
+	if (mapping == nullptr) {
+		mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, (DWORD)((uint64_t)size >> 32), (DWORD)size, name.c_str());
+	}
+	if (mapping == nullptr) {
+		return false;
+	}
+	void* memory = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+	MEMORY_BASIC_INFORMATION information;
+	if (memory == nullptr || VirtualQuery(memory, &information, sizeof(information)) == 0 || information.RegionSize < size) {
+		// A file mapping can't be enlarged once created
+		if (memory != nullptr) {
+			UnmapViewOfFile(memory);
+		}
+		CloseHandle(mapping);
+		return false;
+	}
+	handle = (intptr_t)mapping;
+	mappedSize = information.RegionSize;
+#else
+	int descriptor = shm_open(name.c_str(), O_RDWR | O_CREAT | (create ? O_TRUNC : 0), 0600);
+	if (descriptor < 0) {
+		return false;
+	}
+	struct stat information;
+	if (fstat(descriptor, &information) != 0) {
+		close(descriptor);
+		return false;
+	}
+	if ((size_t)information.st_size < size) {
+		if (ftruncate(descriptor, (off_t)size) != 0) {
+			close(descriptor);
+			return false;
+		}
+	}
+	else {
+		size = (size_t)information.st_size;
+	}
+	void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+	if (memory == MAP_FAILED) {
+		close(descriptor);
+		return false;
+	}
+	handle = descriptor;
+	mappedSize = size;
+#endif
+	header = (sharedFrameHeader*)memory;
+	return true;
+}
+
+/// <summary>
+/// Unmap the shared memory, and remove it if this object created it
+/// </summary>
+void SharedFrame::Close()
+{
+	if (header == nullptr) {
+		return;
+	}
+#if defined(FPP_WINDOWS)
+	UnmapViewOfFile(header);
+	CloseHandle((HANDLE)handle);
+#else
+	munmap(header, mappedSize);
+	close((int)handle);
+	if (owner) {
+		shm_unlink(name.c_str());
+	}
+#endif
+	header = nullptr;
+	mappedSize = 0;
+	handle = -1;
+	owner = false;
+}
+
+/// <summary>
+/// Check if the shared memory is mapped
+/// </summary>
+/// <returns>true if the shared memory can be used</returns>
+bool SharedFrame::IsOpen() const
+{
+	return header != nullptr;
+}
+
+/// <summary>
+/// Get the name of the shared memory
+/// </summary>
+/// <returns>name of the shared memory</returns>
+const std::string& SharedFrame::GetName() const
+{
+	return name;
+}
+
+/// <summary>
+/// Start writing a new frame, the frame isn't ready anymore until EndWrite is called
+/// </summary>
+/// <param name="width">width of the frame in pixels</param>
+/// <param name="height">height of the frame in pixels</param>
+/// <returns>pixels to fill, or nullptr if the frame doesn't fit in the shared memory</returns>
+unsigned char* SharedFrame::BeginWrite(int width, int height)
+{
+	size_t frameSize = (size_t)width * height * 4;
+	if (header == nullptr || frameSize > header->capacity || frameSize > mappedSize - sizeof(sharedFrameHeader)) {
+		return nullptr;
+	}
+	header->ready.store(0, std::memory_order_release);
+	// The pixels written next mustn't be seen before the frame is marked as not ready
+	std::atomic_thread_fence(std::memory_order_release);
+	header->width = (uint32_t)width;
+	header->height = (uint32_t)height;
+	return GetPixels();
+}
+
+/// <summary>
+/// Mark the frame started by BeginWrite as complete
+/// </summary>
+void SharedFrame::EndWrite()
+{
+	header->sequence.fetch_add(1, std::memory_order_relaxed);
+	header->ready.store(1, std::memory_order_release);
+}
+
+/// <summary>
+/// Check if the shared memory contains a whole frame which fits in the memory mapped by this process
+/// </summary>
+/// <returns>true if the pixels can be read</returns>
+bool SharedFrame::IsReady() const
+{
+	return header != nullptr && header->magic == sharedFrameMagic && header->ready.load(std::memory_order_acquire) == 1
+		&& (size_t)header->width * header->height * 4 <= mappedSize - sizeof(sharedFrameHeader);
+}
+
+/// <summary>
+/// Get the number of frames written in the shared memory
+/// </summary>
+/// <returns>sequence number of the last frame</returns>
+uint64_t SharedFrame::GetSequence() const
+{
+	return header->sequence.load(std::memory_order_acquire);
+}
+
+/// <summary>
+/// Get the width of the frame
+/// </summary>
+/// <returns>width in pixels</returns>
+int SharedFrame::GetWidth() const
+{
+	return (int)header->width;
+}
+
+/// <summary>
+/// Get the height of the frame
+/// </summary>
+/// <returns>height in pixels</returns>
+int SharedFrame::GetHeight() const
+{
+	return (int)header->height;
+}
+
+/// <summary>
+/// Get the pixels of the frame, 4 bytes per pixel (blue, green, red, unused) row by row
+/// </summary>
+/// <returns>first byte of the pixels</returns>
+unsigned char* SharedFrame::GetPixels() const
+{
+	return (unsigned char*)(header + 1);
+}
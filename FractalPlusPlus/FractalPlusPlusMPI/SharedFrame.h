@@ -0,0 +1,74 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/// <summary>
+/// Header at the beginning of the shared memory, followed by the pixels of the frame
+/// </summary>
+typedef struct sharedFrameHeader {
+	uint32_t magic; // sharedFrameMagic once the memory is initialized
+	uint32_t width; // Width of the frame in pixels
+	uint32_t height; // Height of the frame in pixels
+	std::atomic<uint32_t> ready; // 1 when the pixels contain a whole frame, 0 while they are written
+	std::atomic<uint64_t> sequence; // Number of frames written in the shared memory
+	uint64_t capacity; // Size in bytes available for the pixels
+} sharedFrameHeader;
+
+/// <summary>
+/// Value of sharedFrameHeader.magic, "FPPF"
+/// </summary>
+constexpr uint32_t sharedFrameMagic = 0x46505046;
+
+/// <summary>
+/// Frame shared between FractalPlusPlusMPI and the GUI through a named shared memory
+/// (POSIX shm_open on Linux, a file mapping on Windows).
+/// The pixels are 4 bytes each (blue, green, red, unused) row by row, so the GUI can copy them without decoding.
+/// The GUI copies a frame out of the memory before displaying it, checking with the sequence that it wasn't rewritten meanwhile.
+/// </summary>
+class SharedFrame
+{
+private:
+	/// <summary>
+	/// Name of the shared memory
+	/// </summary>
+	std::string name;
+
+	/// <summary>
+	/// Beginning of the mapped memory
+	/// </summary>
+	sharedFrameHeader* header = nullptr;
+
+	/// <summary>
+	/// Size of the mapped memory in bytes
+	/// </summary>
+	size_t mappedSize = 0;
+
+	/// <summary>
+	/// File mapping handle on Windows, file descriptor on Linux
+	/// </summary>
+	intptr_t handle = -1;
+
+	/// <summary>
+	/// Whether this object created the shared memory and removes it when destroyed
+	/// </summary>
+	bool owner = false;
+
+	bool Map(bool, size_t);
+public:
+	~SharedFrame();
+	static std::string UniqueName();
+	bool Create(const std::string&, int, int);
+	bool Open(const std::string&, int, int);
+	void Close();
+	bool IsOpen() const;
+	const std::string& GetName() const;
+	unsigned char* BeginWrite(int, int);
+	void EndWrite();
+	bool IsReady() const;
+	uint64_t GetSequence() const;
+	int GetWidth() const;
+	int GetHeight() const;
+	unsigned char* GetPixels() const;
+};
@@ -0,0 +1,150 @@
+#include "ThreadPool.h"
+
+
+/// <summary>
+/// Constructor of the pool, starting its threads
+/// </summary>
+/// <param name="threadCount">number of threads calculating, including the thread calling ParallelFor</param>
+ThreadPool::ThreadPool(int threadCount)
+{
+	if (threadCount < 1) {
+		threadCount = 1;
+	}
+	for (int i = 0; i < threadCount; i++) {
+		queues.push_back(std::make_unique<taskQueue>());
+	}
+	for (int i = 1; i < threadCount; i++) {
+		threads.emplace_back(&ThreadPool::WorkerLoop, this, i);
+	}
+}
+
+/// <summary>
+/// Destructor of the pool, waiting for its threads to end
+/// </summary>
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(jobMutex);
+		stopping = true;
+	}
+	jobStarted.notify_all();
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+}
+
+/// <summary>
+/// Get the number of threads calculating, including the thread calling ParallelFor
+/// </summary>
+/// <returns>number of threads</returns>
+int ThreadPool::GetThreadCount() const
+{
+	return (int)queues.size();
+}
+
+/// <summary>
+/// Run task(0) to task(taskCount - 1) on every thread of the pool and wait for all of them to be done.
+/// The thread calling this method runs tasks too.
+/// </summary>
+/// <param name="taskCount">number of tasks</param>
+/// <param name="task">method called with the index of each task</param>
+void ThreadPool::ParallelFor(int taskCount, const std::function<void(int)>& task)
+{
+	if (taskCount <= 0) {
+		return;
+	}
+	if (threads.empty()) {
+		for (int i = 0; i < taskCount; i++) {
+			task(i);
+		}
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(jobMutex);
+		currentTask = &task;
+		remainingTasks = taskCount;
+
+		// Give each thread a contiguous block of tasks, neighbouring pixels usually take the same time
+		int queueCount = (int)queues.size();
+		for (int i = 0; i < queueCount; i++) {
+			std::lock_guard<std::mutex> queueLock(queues[i]->mutex);
+			for (int j = (int)((long long)taskCount * i / queueCount); j < (int)((long long)taskCount * (i + 1) / queueCount); j++) {
+				queues[i]->tasks.push_back(j);
+			}
+		}
+		generation++;
+	}
+	jobStarted.notify_all();
+
+	RunTasks(0);
+
+	std::unique_lock<std::mutex> lock(jobMutex);
+	jobFinished.wait(lock, [this] { return remainingTasks == 0; });
+	currentTask = nullptr;
+}
+
+/// <summary>
+/// Loop of a thread of the pool, waiting for parallel loops and running their tasks
+/// </summary>
+/// <param name="index">index of the thread and of its queue</param>
+void ThreadPool::WorkerLoop(int index)
+{
+	long long seenGeneration = 0;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(jobMutex);
+			jobStarted.wait(lock, [this, seenGeneration] { return stopping || generation != seenGeneration; });
+			if (stopping) {
+				return;
+			}
+			seenGeneration = generation;
+		}
+		RunTasks(index);
+	}
+}
+
+/// <summary>
+/// Run tasks of the current parallel loop until there is no task left in any queue
+/// </summary>
+/// <param name="index">index of the thread and of its queue</param>
+void ThreadPool::RunTasks(int index)
+{
+	int task;
+	while (PopTask(index, &task)) {
+		(*currentTask)(task);
+		if (--remainingTasks == 0) {
+			std::lock_guard<std::mutex> lock(jobMutex);
+			jobFinished.notify_all();
+		}
+	}
+}
+
+/// <summary>
+/// Take the next task of the thread's own queue, or steal the last task of another thread's queue
+/// </summary>
+/// <param name="index">index of the thread and of its queue</param>
+/// <param name="task">set to the index of the task taken</param>
+/// <returns>false if every queue is empty</returns>
+bool ThreadPool::PopTask(int index, int* task)
+{
+	int queueCount = (int)queues.size();
+	for (int i = 0; i < queueCount; i++) {
+		taskQueue& queue = *queues[(index + i) % queueCount];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.tasks.empty()) {
+			continue;
+		}
+		if (i == 0) {
+			*task = queue.tasks.front();
+			queue.tasks.pop_front();
+		}
+		else {
+			// Steal from the end, far from the tasks the owner is running
+			*task = queue.tasks.back();
+			queue.tasks.pop_back();
+		}
+		return true;
+	}
+	return false;
+}
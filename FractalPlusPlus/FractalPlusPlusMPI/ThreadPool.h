@@ -0,0 +1,81 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// <summary>
+/// Pool of threads running the tasks of a parallel loop with work stealing.
+/// Each thread starts with its own block of tasks and takes tasks from the other threads once its block is done,
+/// so a thread which got fast pixels helps the ones which got slow pixels.
+/// Only the thread calling ParallelFor may use MPI, the other threads only calculate.
+/// </summary>
+class ThreadPool
+{
+private:
+	/// <summary>
+	/// Tasks waiting to be run by one thread
+	/// </summary>
+	typedef struct taskQueue {
+		std::mutex mutex;
+		std::deque<int> tasks;
+	} taskQueue;
+
+	/// <summary>
+	/// Threads of the pool, the thread calling ParallelFor is the thread 0 and isn't in this list
+	/// </summary>
+	std::vector<std::thread> threads;
+
+	/// <summary>
+	/// Queue of tasks of each thread, including the thread calling ParallelFor
+	/// </summary>
+	std::vector<std::unique_ptr<taskQueue>> queues;
+
+	/// <summary>
+	/// Protects generation, stopping and currentTask
+	/// </summary>
+	std::mutex jobMutex;
+
+	/// <summary>
+	/// Signaled when a new parallel loop starts or when the pool is destroyed
+	/// </summary>
+	std::condition_variable jobStarted;
+
+	/// <summary>
+	/// Signaled when the last task of the parallel loop is done
+	/// </summary>
+	std::condition_variable jobFinished;
+
+	/// <summary>
+	/// Number of parallel loops started, used by the threads to know when a new one starts
+	/// </summary>
+	long long generation = 0;
+
+	/// <summary>
+	/// Whether the pool is destroyed
+	/// </summary>
+	bool stopping = false;
+
+	/// <summary>
+	/// Method called for each task of the current parallel loop
+	/// </summary>
+	const std::function<void(int)>* currentTask = nullptr;
+
+	/// <summary>
+	/// Number of tasks of the current parallel loop not done yet
+	/// </summary>
+	std::atomic<int> remainingTasks{ 0 };
+
+	void WorkerLoop(int);
+	void RunTasks(int);
+	bool PopTask(int, int*);
+public:
+	ThreadPool(int);
+	~ThreadPool();
+	int GetThreadCount() const;
+	void ParallelFor(int, const std::function<void(int)>&);
+};
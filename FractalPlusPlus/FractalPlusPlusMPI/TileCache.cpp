@@ -0,0 +1,219 @@
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#include "TileCache.h"
+
+
+/// <summary>
+/// Compare two tile keys
+/// </summary>
+/// <param name="a">first key</param>
+/// <param name="b">second key</param>
+/// <returns>true if they identify the same tile</returns>
+bool operator==(const tileKey& a, const tileKey& b)
+{
+	// The struct has no padding, and the zoom levels must have exactly the same bits
+	return std::memcmp(&a, &b, sizeof(tileKey)) == 0;
+}
+
+/// <summary>
+/// Hash a tile key, mixing its bytes 8 at a time with the finalizer of SplitMix64.
+/// The hash also names the files of the spill directory, so neighbor tiles must not collide
+/// like with std::hash which returns the integers unchanged.
+/// </summary>
+/// <param name="key">key to hash</param>
+/// <returns>hash of the key</returns>
+size_t tileKeyHash::operator()(const tileKey& key) const
+{
+	static_assert(sizeof(tileKey) % sizeof(uint64_t) == 0, "tileKey must have no padding");
+	uint64_t words[sizeof(tileKey) / sizeof(uint64_t)];
+	std::memcpy(words, &key, sizeof(tileKey));
+
+	uint64_t hash = 0;
+	for (uint64_t word : words) {
+		hash = (hash ^ word) + 0x9e3779b97f4a7c15ull;
+		hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ull;
+		hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebull;
+		hash ^= hash >> 31;
+	}
+	return (size_t)hash;
+}
+
+/// <summary>
+/// Set the size of the tiles and of the cache, removing the tiles in memory
+/// </summary>
+/// <param name="size">width and height of the tiles in pixels</param>
+/// <param name="capacityBytes">memory used by the tiles, 0 to disable the cache</param>
+/// <param name="directory">directory where the tiles removed from memory are written, empty to forget them</param>
+void TileCache::Configure(int size, size_t capacityBytes, const std::string& directory)
+{
+	tileSize = size;
+	capacity = capacityBytes / ((size_t)size * size * sizeof(float));
+	spillDirectory = directory;
+	entries.clear();
+	index.clear();
+	if (!spillDirectory.empty()) {
+		std::error_code error;
+		std::filesystem::create_directories(spillDirectory, error);
+	}
+}
+
+/// <summary>
+/// Whether the cache keeps tiles
+/// </summary>
+/// <returns>false if the cache is disabled</returns>
+bool TileCache::IsEnabled() const
+{
+	return capacity > 0;
+}
+
+/// <summary>
+/// Get the width and height of the tiles
+/// </summary>
+/// <returns>size of the tiles in pixels</returns>
+int TileCache::GetTileSize() const
+{
+	return tileSize;
+}
+
+/// <summary>
+/// Look for a tile in memory, then in the spill directory, and make it the most recently used
+/// </summary>
+/// <param name="key">tile to find</param>
+/// <param name="iterations">filled with the smooth iteration counts of the tile row by row when it's found</param>
+/// <returns>false if the tile has to be calculated</returns>
+bool TileCache::Find(const tileKey& key, float* iterations)
+{
+	auto found = index.find(key);
+	if (found != index.end()) {
+		entries.splice(entries.begin(), entries, found->second);
+		std::memcpy(iterations, found->second->iterations.data(), found->second->iterations.size() * sizeof(float));
+		hits++;
+		return true;
+	}
+
+	if (!spillDirectory.empty() && ReadSpill(key, iterations)) {
+		Insert(key, iterations);
+		diskHits++;
+		return true;
+	}
+
+	misses++;
+	return false;
+}
+
+/// <summary>
+/// Keep a tile as the most recently used, removing the least recently used one if the cache is full
+/// </summary>
+/// <param name="key">tile</param>
+/// <param name="iterations">smooth iteration counts of the tile row by row</param>
+void TileCache::Insert(const tileKey& key, const float* iterations)
+{
+	if (capacity == 0) {
+		return;
+	}
+
+	auto found = index.find(key);
+	if (found != index.end()) {
+		entries.splice(entries.begin(), entries, found->second);
+	}
+	else {
+		if (entries.size() >= capacity) {
+			if (!spillDirectory.empty()) {
+				WriteSpill(entries.back());
+			}
+			index.erase(entries.back().key);
+			entries.pop_back();
+		}
+		entries.push_front({ key, std::vector<float>((size_t)tileSize * tileSize) });
+		index[key] = entries.begin();
+	}
+	std::memcpy(entries.front().iterations.data(), iterations, entries.front().iterations.size() * sizeof(float));
+}
+
+/// <summary>
+/// Get the path of the file of a tile in the spill directory
+/// </summary>
+/// <param name="key">tile</param>
+/// <returns>path of the file, named after the hash of the key</returns>
+std::string TileCache::GetSpillPath(const tileKey& key) const
+{
+	std::ostringstream name;
+	name << std::hex << std::setw(16) << std::setfill('0') << (uint64_t)tileKeyHash()(key) << ".tile";
+	return (std::filesystem::path(spillDirectory) / name.str()).string();
+}
+
+/// <summary>
+/// Read a tile from the spill directory
+/// </summary>
+/// <param name="key">tile to read</param>
+/// <param name="iterations">filled with the smooth iteration counts of the tile when it's found</param>
+/// <returns>false if the file doesn't exist or is another tile with the same hash</returns>
+bool TileCache::ReadSpill(const tileKey& key, float* iterations) const
+{
+	std::ifstream file(GetSpillPath(key), std::ios::binary);
+	tileKey fileKey;
+	if (!file.read((char*)&fileKey, sizeof(fileKey)) || !(fileKey == key)) {
+		return false;
+	}
+	return (bool)file.read((char*)iterations, (std::streamsize)tileSize * tileSize * sizeof(float));
+}
+
+/// <summary>
+/// Write a tile in the spill directory, the file starts with the key followed by the smooth iteration counts
+/// </summary>
+/// <param name="entry">tile to write</param>
+void TileCache::WriteSpill(const cacheEntry& entry) const
+{
+	std::ofstream file(GetSpillPath(entry.key), std::ios::binary | std::ios::trunc);
+	file.write((const char*)&entry.key, sizeof(entry.key));
+	file.write((const char*)entry.iterations.data(), (std::streamsize)entry.iterations.size() * sizeof(float));
+}
+
+/// <summary>
+/// Get the number of tiles found in memory since the program started
+/// </summary>
+/// <returns>number of hits</returns>
+uint64_t TileCache::GetHits() const
+{
+	return hits;
+}
+
+/// <summary>
+/// Get the number of tiles read back from the spill directory since the program started
+/// </summary>
+/// <returns>number of hits on disk</returns>
+uint64_t TileCache::GetDiskHits() const
+{
+	return diskHits;
+}
+
+/// <summary>
+/// Get the number of tiles which weren't found since the program started
+/// </summary>
+/// <returns>number of misses</returns>
+uint64_t TileCache::GetMisses() const
+{
+	return misses;
+}
+
+/// <summary>
+/// Get the number of tiles in memory
+/// </summary>
+/// <returns>number of tiles</returns>
+size_t TileCache::GetTileCount() const
+{
+	return entries.size();
+}
+
+/// <summary>
+/// Get the memory used by the tiles
+/// </summary>
+/// <returns>size of the tiles in memory in bytes</returns>
+size_t TileCache::GetMemoryBytes() const
+{
+	return entries.size() * tileSize * tileSize * sizeof(float);
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// <summary>
+/// Identifies a square tile of smooth iteration counts in a grid of pixels covering the whole complex plane.
+/// Two frames share their tiles when they have the same zoom level and their pixels are on the same grid,
+/// like a frame and the same frame moved by a whole number of pixels.
+/// </summary>
+typedef struct tileKey {
+	double spacingX; // Zoom level : distance between two pixels on the X axis, compared exactly so a tile is only used at the scale it was calculated
+	double spacingY; // Distance between two pixels on the Y axis
+	int64_t tileX; // Column of the tile in the grid, the tile starting at the pixel tileX * tile size
+	int64_t tileY; // Row of the tile in the grid
+	int32_t phaseX; // Position of the grid in 1/256 of a pixel, the grids of two frames of the same zoom level can be shifted
+	int32_t phaseY;
+	int32_t maxIteration;
+	uint32_t parameters; // Hash of the fractal parameters changing the colored values, see HashFractalParameters
+} tileKey;
+
+bool operator==(const tileKey&, const tileKey&);
+
+/// <summary>
+/// Hash of a tileKey for the index of the cache
+/// </summary>
+typedef struct tileKeyHash {
+	size_t operator()(const tileKey&) const;
+} tileKeyHash;
+
+/// <summary>
+/// Least recently used cache of tiles of smooth iteration counts, kept by rank 0 between the frames of the render server.
+/// When the memory is full the least recently used tile is removed, or written in the spill directory if there is one
+/// so it can be read back later instead of being calculated again, even by another run of the program.
+/// </summary>
+class TileCache
+{
+private:
+	/// <summary>
+	/// Tile kept in memory
+	/// </summary>
+	typedef struct cacheEntry {
+		tileKey key;
+		std::vector<float> iterations; // Smooth iteration counts of the tile row by row
+	} cacheEntry;
+
+	/// <summary>
+	/// Width and height of the tiles in pixels
+	/// </summary>
+	int tileSize = 0;
+
+	/// <summary>
+	/// Maximum number of tiles kept in memory, 0 when the cache is disabled
+	/// </summary>
+	size_t capacity = 0;
+
+	/// <summary>
+	/// Directory where the tiles removed from memory are written, empty to forget them
+	/// </summary>
+	std::string spillDirectory;
+
+	/// <summary>
+	/// Tiles in memory, the most recently used first
+	/// </summary>
+	std::list<cacheEntry> entries;
+
+	/// <summary>
+	/// Position of each tile of entries
+	/// </summary>
+	std::unordered_map<tileKey, std::list<cacheEntry>::iterator, tileKeyHash> index;
+
+	/// <summary>
+	/// Number of tiles found in memory
+	/// </summary>
+	uint64_t hits = 0;
+
+	/// <summary>
+	/// Number of tiles read back from the spill directory
+	/// </summary>
+	uint64_t diskHits = 0;
+
+	/// <summary>
+	/// Number of tiles which had to be calculated
+	/// </summary>
+	uint64_t misses = 0;
+
+	std::string GetSpillPath(const tileKey&) const;
+	bool ReadSpill(const tileKey&, float*) const;
+	void WriteSpill(const cacheEntry&) const;
+public:
+	void Configure(int, size_t, const std::string&);
+	bool IsEnabled() const;
+	int GetTileSize() const;
+	bool Find(const tileKey&, float*);
+	void Insert(const tileKey&, const float*);
+	uint64_t GetHits() const;
+	uint64_t GetDiskHits() const;
+	uint64_t GetMisses() const;
+	size_t GetTileCount() const;
+	size_t GetMemoryBytes() const;
+};
@@ -0,0 +1,21 @@
+#!/bin/bash
+# Run the benchmarks of FractalPlusPlusMPI built by build_linux.sh, from 1 to [maxRanks] MPI ranks
+# Usage : ./benchmark_linux.sh [maxRanks, default 4] [results file, .json for JSON lines, default benchmark.csv]
+readonly OUTPUT=build_linux/
+readonly MAX_RANKS=${1:-4}
+readonly RESULTS=$(realpath -m "${2:-benchmark.csv}") # The results are appended, so several builds or computers can be compared in the same file
+
+if [[ ! -x "$OUTPUT/FractalPlusPlusMPI" ]]
+then
+	echo "Run ./build_linux.sh first"
+	exit 1
+fi
+cd "$OUTPUT"
+
+# The micro-benchmarks only run on rank 0, they don't change with the number of ranks
+./FractalPlusPlusMPI --benchmark "$RESULTS" || exit 1
+for ((ranks = 2; ranks <= MAX_RANKS; ranks++))
+do
+	mpiexec -n $ranks ./FractalPlusPlusMPI --benchmark "$RESULTS" --benchmark-suites frames,scaling || exit 1
+done
+echo "Results in $RESULTS"
@@ -5,13 +5,24 @@ readonly IMAGE=/tmp/Mandelbrot.bmp
 mkdir -p "$OUTPUT"
 # "\cp" is used instead of "cp" because "cp" is sometimes aliased to "cp -i" which asks the user before overwritting
 \cp "FractalPlusPlusGUI/FractalPlusPlusGUI.cpp" "$OUTPUT" # GUI files
-\cp "FractalPlusPlusMPI/Complex.cpp" "FractalPlusPlusMPI/Complex.h" "FractalPlusPlusMPI/FractalPlusPlusMPI.cpp" "$OUTPUT" # MPI files
+\cp "FractalPlusPlusMPI/Complex.h" "FractalPlusPlusMPI/Kernel.h" "FractalPlusPlusMPI/Kernel.cpp" "FractalPlusPlusMPI/KernelAvx2.cpp" "FractalPlusPlusMPI/KernelAvx512.cpp" "FractalPlusPlusMPI/ThreadPool.h" "FractalPlusPlusMPI/ThreadPool.cpp" "FractalPlusPlusMPI/LocalSocket.h" "FractalPlusPlusMPI/LocalSocket.cpp" "FractalPlusPlusMPI/RenderProtocol.h" "FractalPlusPlusMPI/SharedFrame.h" "FractalPlusPlusMPI/SharedFrame.cpp" "FractalPlusPlusMPI/Palette.h" "FractalPlusPlusMPI/Palette.cpp" "FractalPlusPlusMPI/BigFloat.h" "FractalPlusPlusMPI/BigFloat.cpp" "FractalPlusPlusMPI/TileCache.h" "FractalPlusPlusMPI/FractalEngine.h" "FractalPlusPlusMPI/DoubleDouble.h" "FractalPlusPlusMPI/TileCache.cpp" "FractalPlusPlusMPI/PhaseTrace.h" "FractalPlusPlusMPI/PhaseTrace.cpp" "FractalPlusPlusMPI/ImageFile.h" "FractalPlusPlusMPI/ImageFile.cpp" "FractalPlusPlusMPI/RenderJournal.h" "FractalPlusPlusMPI/RenderJournal.cpp" "FractalPlusPlusMPI/Animation.h" "FractalPlusPlusMPI/Animation.cpp" "FractalPlusPlusMPI/Batch.h" "FractalPlusPlusMPI/Batch.cpp" "FractalPlusPlusMPI/FractalRenderer.h" "FractalPlusPlusMPI/FractalRenderer.cpp" "FractalPlusPlusMPI/Schedules.h" "FractalPlusPlusMPI/Schedules.cpp" "FractalPlusPlusMPI/RenderServer.h" "FractalPlusPlusMPI/RenderServer.cpp" "FractalPlusPlusMPI/LargeImageRenderer.h" "FractalPlusPlusMPI/LargeImageRenderer.cpp" "FractalPlusPlusMPI/AnimationRenderer.h" "FractalPlusPlusMPI/AnimationRenderer.cpp" "FractalPlusPlusMPI/BatchRenderer.h" "FractalPlusPlusMPI/BatchRenderer.cpp" "FractalPlusPlusMPI/Benchmark.h" "FractalPlusPlusMPI/Benchmark.cpp" "FractalPlusPlusMPI/FractalPlusPlusMPI.cpp" "$OUTPUT" # MPI files
 
 cd "$OUTPUT"
 
 # Compile both projects
-mpic++ "FractalPlusPlusMPI.cpp" "Complex.cpp" -lSDL -Wall -I/urs/local/include -o "FractalPlusPlusMPI"
-g++ "FractalPlusPlusGUI.cpp" -lSDL -Wall -I/urs/local/include -o "FractalPlusPlusGUI"
+# -ffp-contract=off stops the compiler from merging multiplications and additions, so every kernel gives the same image
+readonly CXXFLAGS="-O2 -ffp-contract=off -Wall -I/urs/local/include"
+# The AVX2 and AVX-512 kernels are compiled with their instructions enabled, the one supported by the CPU is chosen at runtime
+if [[ $(uname -m) == "x86_64" ]]
+then
+	mpic++ -c "KernelAvx2.cpp" $CXXFLAGS -mavx2 -o "KernelAvx2.o"
+	mpic++ -c "KernelAvx512.cpp" $CXXFLAGS -mavx512f -o "KernelAvx512.o"
+else
+	mpic++ -c "KernelAvx2.cpp" $CXXFLAGS -o "KernelAvx2.o"
+	mpic++ -c "KernelAvx512.cpp" $CXXFLAGS -o "KernelAvx512.o"
+fi
+mpic++ "FractalPlusPlusMPI.cpp" "Kernel.cpp" "ThreadPool.cpp" "LocalSocket.cpp" "SharedFrame.cpp" "Palette.cpp" "BigFloat.cpp" "TileCache.cpp" "PhaseTrace.cpp" "ImageFile.cpp" "RenderJournal.cpp" "Animation.cpp" "Batch.cpp" "FractalRenderer.cpp" "Schedules.cpp" "RenderServer.cpp" "LargeImageRenderer.cpp" "AnimationRenderer.cpp" "BatchRenderer.cpp" "Benchmark.cpp" "KernelAvx2.o" "KernelAvx512.o" -lSDL -lrt -pthread $CXXFLAGS -o "FractalPlusPlusMPI"
+g++ "FractalPlusPlusGUI.cpp" "LocalSocket.cpp" "SharedFrame.cpp" "Palette.cpp" "BigFloat.cpp" -lSDL -lrt -Wall -I/urs/local/include -o "FractalPlusPlusGUI"
 
 # Check if the Mandelbrot image exists
 if [[ -f "$IMAGE" ]]